@@ -0,0 +1,408 @@
+#include "catalog_snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "xdg_basedirs.h"
+
+//identifier at the start of snapshot files
+#define CATALOG_SNAPSHOT_MAGIC "FLYBYSNP"
+
+/**
+ * Header of snapshot file. Followed by the source file status, the filenames referred to by the TLE entries,
+ * the TLE entries and the non-empty transponder database entries.
+ **/
+struct catalog_snapshot_header {
+	///CATALOG_SNAPSHOT_MAGIC
+	char magic[8];
+	///CATALOG_SNAPSHOT_VERSION
+	uint32_t version;
+	///Size of struct tle_db_entry, guards against layout changes without version increments
+	uint32_t tle_entry_size;
+	///Size of struct sat_db_entry
+	uint32_t sat_entry_size;
+	///Whether transponder database was loaded
+	uint32_t transponder_db_loaded;
+	///Number of source files
+	uint64_t num_sources;
+	///Number of TLE filenames
+	uint64_t num_filenames;
+	///Number of TLE entries
+	uint64_t num_tles;
+	///Number of stored transponder database entries
+	uint64_t num_sats;
+};
+
+void catalog_sources_add_file(struct catalog_sources *sources, const char *path)
+{
+	int index = string_array_size(&(sources->paths));
+	sources->status = (struct catalog_source*)realloc(sources->status, sizeof(struct catalog_source)*(index+1));
+	string_array_add(&(sources->paths), path);
+
+	struct catalog_source status = {.mtime_sec = 0, .mtime_nsec = 0, .size = -1};
+	struct stat file_stat;
+	if (stat(path, &file_stat) == 0) {
+		status.mtime_sec = file_stat.st_mtim.tv_sec;
+		status.mtime_nsec = file_stat.st_mtim.tv_nsec;
+		status.size = file_stat.st_size;
+	}
+	sources->status[index] = status;
+}
+
+void catalog_sources_add_directory(struct catalog_sources *sources, const char *dirpath)
+{
+	//the directory modification time changes when files are added or removed
+	catalog_sources_add_file(sources, dirpath);
+
+	DIR *d = opendir(dirpath);
+	if (d) {
+		struct dirent *file;
+		while ((file = readdir(d)) != NULL) {
+			if (file->d_type == DT_REG) {
+				char path[MAX_NUM_CHARS] = {0};
+				snprintf(path, MAX_NUM_CHARS, "%s%s", dirpath, file->d_name);
+				catalog_sources_add_file(sources, path);
+			}
+		}
+		closedir(d);
+	}
+}
+
+void catalog_sources_from_search_paths(struct catalog_sources *sources)
+{
+	char *data_home = xdg_data_home();
+	char *data_dirs_str = xdg_data_dirs();
+	string_array_t data_dirs = {0};
+	stringsplit(data_dirs_str, &data_dirs);
+	free(data_dirs_str);
+
+	//TLE directories, see tle_db_from_search_paths()
+	char path[MAX_NUM_CHARS] = {0};
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, TLE_RELATIVE_DIR_PATH);
+	catalog_sources_add_directory(sources, path);
+	for (int i=0; i < string_array_size(&data_dirs); i++) {
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), TLE_RELATIVE_DIR_PATH);
+		catalog_sources_add_directory(sources, path);
+	}
+
+	//transponder database files, see transponder_db_from_search_paths()
+	for (int i=0; i < string_array_size(&data_dirs); i++) {
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), DB_RELATIVE_FILE_PATH);
+		catalog_sources_add_file(sources, path);
+	}
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, DB_RELATIVE_FILE_PATH);
+	catalog_sources_add_file(sources, path);
+
+	string_array_free(&data_dirs);
+	free(data_home);
+}
+
+void catalog_sources_free(struct catalog_sources *sources)
+{
+	string_array_free(&(sources->paths));
+	free(sources->status);
+	sources->status = NULL;
+}
+
+/**
+ * Write string to snapshot file, prefixed by its length.
+ *
+ * \param fd File
+ * \param string String
+ **/
+void catalog_snapshot_write_string(FILE *fd, const char *string)
+{
+	uint32_t length = strlen(string);
+	fwrite(&length, sizeof(length), 1, fd);
+	fwrite(string, sizeof(char), length, fd);
+}
+
+int catalog_snapshot_to_file(const char *filename, struct catalog_sources *sources, const struct tle_db *tle_db, const struct transponder_db *transponder_db)
+{
+	if (transponder_db->num_sats != tle_db->num_tles) {
+		return -1;
+	}
+
+	//write to temporary file in the same directory, renamed on completion
+	int tmp_size = strlen(filename) + strlen(".XXXXXX") + 1;
+	char *tmp_filename = (char*)malloc(sizeof(char)*tmp_size);
+	snprintf(tmp_filename, tmp_size, "%s.XXXXXX", filename);
+	int fid = mkstemp(tmp_filename);
+	if (fid == -1) {
+		free(tmp_filename);
+		return -1;
+	}
+	FILE *fd = fdopen(fid, "wb");
+
+	//map filename indices to indices in the snapshot filename list
+	string_array_t filenames = {0};
+	int *snapshot_filename_index = (int*)malloc(sizeof(int)*(tle_db->num_tles+1));
+	int previous_filename_index = -1;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		int filename_index = tle_db->tles[i].filename_index;
+		if ((i == 0) || (filename_index != previous_filename_index)) {
+			const char *tle_filename = tle_db_interned_filename(filename_index);
+			int index = string_array_find(&filenames, tle_filename);
+			if (index == -1) {
+				string_array_add(&filenames, tle_filename);
+				index = string_array_size(&filenames)-1;
+			}
+			snapshot_filename_index[i] = index;
+		} else {
+			snapshot_filename_index[i] = snapshot_filename_index[i-1];
+		}
+		previous_filename_index = filename_index;
+	}
+
+	uint64_t num_sats = 0;
+	for (int i=0; i < transponder_db->num_sats; i++) {
+		if (transponder_db->sats[i].location != LOCATION_NONE) {
+			num_sats++;
+		}
+	}
+
+	struct catalog_snapshot_header header = {0};
+	memcpy(header.magic, CATALOG_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = CATALOG_SNAPSHOT_VERSION;
+	header.tle_entry_size = sizeof(struct tle_db_entry);
+	header.sat_entry_size = sizeof(struct sat_db_entry);
+	header.transponder_db_loaded = transponder_db->loaded;
+	header.num_sources = string_array_size(&(sources->paths));
+	header.num_filenames = string_array_size(&filenames);
+	header.num_tles = tle_db->num_tles;
+	header.num_sats = num_sats;
+	fwrite(&header, sizeof(header), 1, fd);
+
+	for (int i=0; i < header.num_sources; i++) {
+		fwrite(&(sources->status[i]), sizeof(struct catalog_source), 1, fd);
+		catalog_snapshot_write_string(fd, string_array_get(&(sources->paths), i));
+	}
+
+	for (int i=0; i < header.num_filenames; i++) {
+		catalog_snapshot_write_string(fd, string_array_get(&filenames, i));
+	}
+
+	for (int i=0; i < tle_db->num_tles; i++) {
+		struct tle_db_entry entry = tle_db->tles[i];
+		entry.filename_index = snapshot_filename_index[i];
+		entry.enabled = false;
+		fwrite(&entry, sizeof(entry), 1, fd);
+	}
+
+	//only entries read from a transponder database file are stored
+	for (uint64_t i=0; i < transponder_db->num_sats; i++) {
+		if (transponder_db->sats[i].location != LOCATION_NONE) {
+			fwrite(&i, sizeof(i), 1, fd);
+			fwrite(&(transponder_db->sats[i]), sizeof(struct sat_db_entry), 1, fd);
+		}
+	}
+
+	string_array_free(&filenames);
+	free(snapshot_filename_index);
+
+	bool write_failed = ferror(fd) != 0;
+	write_failed = (fclose(fd) != 0) || write_failed;
+
+	int retval = 0;
+	if (write_failed || (rename(tmp_filename, filename) != 0)) {
+		unlink(tmp_filename);
+		retval = -1;
+	}
+	free(tmp_filename);
+	return retval;
+}
+
+/**
+ * Copy data from the current position in the snapshot buffer.
+ *
+ * \param data Current position in buffer, advanced by size on success
+ * \param data_end End of buffer
+ * \param destination Destination
+ * \param size Number of bytes to copy
+ * \return True on success, false if the buffer is exhausted
+ **/
+bool catalog_snapshot_read(const char **data, const char *data_end, void *destination, size_t size)
+{
+	if (data_end - *data < size) {
+		return false;
+	}
+	memcpy(destination, *data, size);
+	*data += size;
+	return true;
+}
+
+/**
+ * Read length-prefixed string from the current position in the snapshot buffer.
+ *
+ * \param data Current position in buffer, advanced past the string on success
+ * \param data_end End of buffer
+ * \param ret_string Returned string, null-terminated
+ * \param max_length Size of ret_string
+ * \return True on success, false if the buffer is exhausted or the string is too long
+ **/
+bool catalog_snapshot_read_string(const char **data, const char *data_end, char *ret_string, size_t max_length)
+{
+	uint32_t length;
+	if (!catalog_snapshot_read(data, data_end, &length, sizeof(length)) || (length >= max_length)) {
+		return false;
+	}
+	if (!catalog_snapshot_read(data, data_end, ret_string, length)) {
+		return false;
+	}
+	ret_string[length] = '\0';
+	return true;
+}
+
+/**
+ * Parse snapshot in memory buffer. See catalog_snapshot_from_file().
+ *
+ * \param data Start of buffer
+ * \param data_end End of buffer
+ * \param sources Current status of source files
+ * \param ret_tle_db Returned TLE database
+ * \param ret_transponder_db Returned transponder database
+ * \return CATALOG_SNAPSHOT_SUCCESS on success, one of the other values in enum catalog_snapshot_err otherwise
+ **/
+int catalog_snapshot_from_buffer(const char *data, const char *data_end, struct catalog_sources *sources, struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db)
+{
+	struct catalog_snapshot_header header;
+	if (!catalog_snapshot_read(&data, data_end, &header, sizeof(header)) ||
+	    (memcmp(header.magic, CATALOG_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) ||
+	    (header.version != CATALOG_SNAPSHOT_VERSION) ||
+	    (header.tle_entry_size != sizeof(struct tle_db_entry)) ||
+	    (header.sat_entry_size != sizeof(struct sat_db_entry))) {
+		return CATALOG_SNAPSHOT_INVALID;
+	}
+
+	//compare stored source file status against the current
+	if (header.num_sources != string_array_size(&(sources->paths))) {
+		return CATALOG_SNAPSHOT_OUTDATED;
+	}
+	for (int i=0; i < header.num_sources; i++) {
+		struct catalog_source status;
+		char path[MAX_NUM_CHARS];
+		if (!catalog_snapshot_read(&data, data_end, &status, sizeof(status)) ||
+		    !catalog_snapshot_read_string(&data, data_end, path, MAX_NUM_CHARS)) {
+			return CATALOG_SNAPSHOT_INVALID;
+		}
+		if ((strcmp(path, string_array_get(&(sources->paths), i)) != 0) ||
+		    (status.mtime_sec != sources->status[i].mtime_sec) ||
+		    (status.mtime_nsec != sources->status[i].mtime_nsec) ||
+		    (status.size != sources->status[i].size)) {
+			return CATALOG_SNAPSHOT_OUTDATED;
+		}
+	}
+
+	//filenames referred to by the TLE entries
+	string_array_t filenames = {0};
+	for (int i=0; i < header.num_filenames; i++) {
+		char filename[MAX_NUM_CHARS];
+		if (!catalog_snapshot_read_string(&data, data_end, filename, MAX_NUM_CHARS)) {
+			string_array_free(&filenames);
+			return CATALOG_SNAPSHOT_INVALID;
+		}
+		string_array_add(&filenames, filename);
+	}
+
+	//check size and indices of TLE entries and transponder database entries before anything is modified
+	const char *tles_start = data;
+	size_t sat_record_size = sizeof(uint64_t) + sizeof(struct sat_db_entry);
+	bool valid = ((data_end - data)/sizeof(struct tle_db_entry) >= header.num_tles) &&
+		     ((data_end - data) - header.num_tles*sizeof(struct tle_db_entry) == header.num_sats*sat_record_size);
+	for (int i=0; valid && (i < header.num_tles); i++) {
+		struct tle_db_entry entry;
+		catalog_snapshot_read(&data, data_end, &entry, sizeof(entry));
+		valid = (entry.filename_index >= 0) && (entry.filename_index < header.num_filenames);
+	}
+	for (int i=0; valid && (i < header.num_sats); i++) {
+		uint64_t tle_index;
+		memcpy(&tle_index, data + i*sat_record_size, sizeof(tle_index));
+		valid = tle_index < header.num_tles;
+	}
+	if (!valid) {
+		string_array_free(&filenames);
+		return CATALOG_SNAPSHOT_INVALID;
+	}
+
+	//TLE entries, with snapshot filename indices mapped to interned filename indices
+	int *filename_index = (int*)malloc(sizeof(int)*(header.num_filenames+1));
+	for (int i=0; i < header.num_filenames; i++) {
+		filename_index[i] = tle_db_intern_filename(string_array_get(&filenames, i));
+	}
+	string_array_free(&filenames);
+
+	data = tles_start;
+	for (int i=0; i < header.num_tles; i++) {
+		struct tle_db_entry entry;
+		catalog_snapshot_read(&data, data_end, &entry, sizeof(entry));
+		entry.filename_index = filename_index[entry.filename_index];
+		tle_db_add_entry(ret_tle_db, &entry);
+	}
+	free(filename_index);
+
+	//transponder database entries
+	struct transponder_db *transponder_db = transponder_db_create(ret_tle_db);
+	for (int i=0; i < header.num_sats; i++) {
+		uint64_t tle_index;
+		catalog_snapshot_read(&data, data_end, &tle_index, sizeof(tle_index));
+		catalog_snapshot_read(&data, data_end, &(transponder_db->sats[tle_index]), sizeof(struct sat_db_entry));
+	}
+	transponder_db->loaded = header.transponder_db_loaded;
+	*ret_transponder_db = transponder_db;
+
+	return CATALOG_SNAPSHOT_SUCCESS;
+}
+
+int catalog_snapshot_from_file(const char *filename, struct catalog_sources *sources, struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		return CATALOG_SNAPSHOT_FILE_READING_ERROR;
+	}
+
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size == 0)) {
+		close(fd);
+		return CATALOG_SNAPSHOT_FILE_READING_ERROR;
+	}
+
+	void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return CATALOG_SNAPSHOT_FILE_READING_ERROR;
+	}
+
+	int retval = catalog_snapshot_from_buffer((const char*)data, (const char*)data + file_stat.st_size, sources, ret_tle_db, ret_transponder_db);
+	munmap(data, file_stat.st_size);
+	return retval;
+}
+
+void catalog_from_search_paths(struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db)
+{
+	struct catalog_sources sources = {0};
+	catalog_sources_from_search_paths(&sources);
+
+	char *cache_home = xdg_cache_home();
+	char snapshot_dir[MAX_NUM_CHARS] = {0};
+	snprintf(snapshot_dir, MAX_NUM_CHARS, "%s%s", cache_home, FLYBY_RELATIVE_ROOT_PATH);
+	char snapshot_path[MAX_NUM_CHARS] = {0};
+	snprintf(snapshot_path, MAX_NUM_CHARS, "%s%s", cache_home, CATALOG_SNAPSHOT_RELATIVE_FILE_PATH);
+	free(cache_home);
+
+	if (catalog_snapshot_from_file(snapshot_path, &sources, ret_tle_db, ret_transponder_db) == CATALOG_SNAPSHOT_SUCCESS) {
+		ret_tle_db->read_from_xdg = true;
+	} else {
+		//full rebuild. The source file status is obtained before reading, so that changes made during reading invalidate the new snapshot
+		tle_db_from_search_paths(ret_tle_db);
+		*ret_transponder_db = transponder_db_create(ret_tle_db);
+		transponder_db_from_search_paths(ret_tle_db, *ret_transponder_db);
+
+		create_path_if_missing(snapshot_dir);
+		catalog_snapshot_to_file(snapshot_path, &sources, ret_tle_db, *ret_transponder_db);
+	}
+	catalog_sources_free(&sources);
+}
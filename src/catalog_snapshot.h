@@ -0,0 +1,118 @@
+#ifndef CATALOG_SNAPSHOT_H_DEFINED
+#define CATALOG_SNAPSHOT_H_DEFINED
+
+#include <stdint.h>
+#include "string_array.h"
+#include "tle_db.h"
+#include "transponder_db.h"
+
+/**
+ * Binary snapshot of the merged TLE database and transponder database, used for skipping the parsing of
+ * all TLE files and transponder database files on startup when none of them have changed since the last time.
+ **/
+
+//Version of the snapshot file format. Increment when the format or the layout of the stored structs changes
+#define CATALOG_SNAPSHOT_VERSION 1
+
+/**
+ * File status of a source file, used for deciding whether a snapshot is outdated.
+ **/
+struct catalog_source {
+	///Modification time, seconds
+	int64_t mtime_sec;
+	///Modification time, nanoseconds
+	int64_t mtime_nsec;
+	///File size, -1 if the file does not exist
+	int64_t size;
+};
+
+/**
+ * List over the files and directories the TLE and transponder databases are read from.
+ **/
+struct catalog_sources {
+	///Paths to files and directories
+	string_array_t paths;
+	///File status, one for each path
+	struct catalog_source *status;
+};
+
+/**
+ * Add file to list over source files. Non-existing files are also added, so that a snapshot is invalidated when they are created.
+ *
+ * \param sources List over source files
+ * \param path Path to file
+ **/
+void catalog_sources_add_file(struct catalog_sources *sources, const char *path);
+
+/**
+ * Add directory and all regular files within it to list over source files, in the order they are read by tle_db_from_directory().
+ *
+ * \param sources List over source files
+ * \param dirpath Path to directory, with trailing '/'
+ **/
+void catalog_sources_add_directory(struct catalog_sources *sources, const char *dirpath);
+
+/**
+ * Collect the TLE directories and transponder database files that are read by tle_db_from_search_paths() and
+ * transponder_db_from_search_paths().
+ *
+ * \param sources Returned list over source files
+ **/
+void catalog_sources_from_search_paths(struct catalog_sources *sources);
+
+/**
+ * Free memory allocated in list over source files.
+ *
+ * \param sources List over source files
+ **/
+void catalog_sources_free(struct catalog_sources *sources);
+
+/**
+ * Return values of catalog_snapshot_from_file().
+ **/
+enum catalog_snapshot_err {
+	///Success
+	CATALOG_SNAPSHOT_SUCCESS = 0,
+	///Snapshot file could not be read
+	CATALOG_SNAPSHOT_FILE_READING_ERROR = -1,
+	///Snapshot file is of a different version or is corrupt
+	CATALOG_SNAPSHOT_INVALID = -2,
+	///Source files have changed since the snapshot was written
+	CATALOG_SNAPSHOT_OUTDATED = -3
+};
+
+/**
+ * Write snapshot of TLE database and transponder database to file. The file is written to a temporary file
+ * and renamed, so that a partially written snapshot never is read.
+ *
+ * \param filename Snapshot filename
+ * \param sources Source files the databases were read from
+ * \param tle_db TLE database
+ * \param transponder_db Transponder database, indices corresponding to the TLE database
+ * \return 0 on success, -1 otherwise
+ **/
+int catalog_snapshot_to_file(const char *filename, struct catalog_sources *sources, const struct tle_db *tle_db, const struct transponder_db *transponder_db);
+
+/**
+ * Read snapshot of TLE database and transponder database from file, if the source files are unchanged since
+ * the snapshot was written. The enabled flags of the TLE entries are not stored, and will be unset.
+ *
+ * \param filename Snapshot filename
+ * \param sources Current status of source files, compared against the status stored in the snapshot
+ * \param ret_tle_db Returned TLE database, assumed to be empty. Left unmodified on failure
+ * \param ret_transponder_db Returned transponder database, allocated using transponder_db_create() on success
+ * \return CATALOG_SNAPSHOT_SUCCESS on success, one of the other values in enum catalog_snapshot_err otherwise
+ **/
+int catalog_snapshot_from_file(const char *filename, struct catalog_sources *sources, struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db);
+
+/**
+ * Read TLE database and transponder database from the XDG data directories, like tle_db_from_search_paths() and
+ * transponder_db_from_search_paths(). Uses the snapshot in XDG_CACHE_HOME/flyby/ instead if none of the files
+ * have changed, and writes a new snapshot otherwise.
+ *
+ * \param ret_tle_db Returned TLE database
+ * \param ret_transponder_db Returned transponder database, allocated
+ **/
+void catalog_from_search_paths(struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db);
+
+#endif
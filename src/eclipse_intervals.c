@@ -0,0 +1,295 @@
+#include "eclipse_intervals.h"
+#include "defines.h"
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+//Number of seconds in a day
+#define SECONDS_PER_DAY 86400.0
+
+//Gravitational parameter of the earth, in km^3/s^2
+#define ECLIPSE_GM 398600.8
+
+//Smallest step when bracketing umbra entries and exits, in days. Eclipses shorter than this can be missed
+#define ECLIPSE_MIN_STEP (10.0/SECONDS_PER_DAY)
+
+//Largest step when bracketing umbra entries and exits, in days
+#define ECLIPSE_MAX_STEP (1.0/24.0)
+
+//Safety factor on the bound of the rate of change of the eclipse depth
+#define ECLIPSE_RATE_MARGIN 1.2
+
+//Accuracy of the umbra entry and exit times, in days
+#define ECLIPSE_TIME_TOLERANCE (0.1/SECONDS_PER_DAY)
+
+//Maximum number of iterations when refining umbra entry and exit times
+#define ECLIPSE_MAX_ITERATIONS 50
+
+/**
+ * Shadow function: The eclipse depth, with sign forced to be consistent with the eclipse status, so that it is
+ * positive within the umbra and negative outside.
+ *
+ * \param orbit Orbit
+ * \return Shadow function value
+ **/
+static inline double eclipse_shadow_function(const struct predict_position *orbit)
+{
+	if (orbit->eclipsed) {
+		return fmax(orbit->eclipse_depth, DBL_MIN);
+	} else {
+		return fmin(orbit->eclipse_depth, -DBL_MIN);
+	}
+}
+
+/**
+ * Get the time step that can be taken from the given orbit without the shadow function changing sign, bounded by
+ * the eclipse depth divided by the largest rate of change of the eclipse depth. The eclipse depth is the earth's
+ * angular radius minus the sun's angular radius minus the angle between the sun and the satellite as seen from the
+ * earth's center. The angle changes at most as fast as the angular velocity of the satellite about the earth's
+ * center, and the earth's angular radius as fast as the radial velocity allows. Both are bounded over the whole
+ * orbit using the osculating orbit at the current position. The motion of the sun is negligible.
+ *
+ * \param orbit Orbit
+ * \return Time step, in days
+ **/
+double eclipse_step(const struct predict_position *orbit)
+{
+	const double *pos = orbit->position;
+	const double *vel = orbit->velocity;
+	double pos_length = sqrt(pos[0]*pos[0] + pos[1]*pos[1] + pos[2]*pos[2]);
+	double vel_squared = vel[0]*vel[0] + vel[1]*vel[1] + vel[2]*vel[2];
+
+	//osculating orbit: angular momentum, semi-major axis, eccentricity and perigee distance
+	double momentum[3] = {pos[1]*vel[2] - pos[2]*vel[1], pos[2]*vel[0] - pos[0]*vel[2], pos[0]*vel[1] - pos[1]*vel[0]};
+	double momentum_length = sqrt(momentum[0]*momentum[0] + momentum[1]*momentum[1] + momentum[2]*momentum[2]);
+	double inverse_semi_major_axis = 2.0/pos_length - vel_squared/ECLIPSE_GM;
+	double eccentricity = sqrt(fmax(1.0 - momentum_length*momentum_length*inverse_semi_major_axis/ECLIPSE_GM, 0.0));
+	double perigee = momentum_length*momentum_length/ECLIPSE_GM/(1.0 + eccentricity);
+	if ((inverse_semi_major_axis <= 0) || (perigee <= 0)) {
+		return ECLIPSE_MIN_STEP;
+	}
+
+	//largest angular velocity and rate of change of the earth's angular radius, at perigee, in radians per second
+	double max_angular_rate = momentum_length/(perigee*perigee);
+	double max_radial_speed = ECLIPSE_GM*eccentricity/momentum_length;
+	double radius_ratio = fmin(EARTH_RADIUS_KM/perigee, 0.99);
+	double max_radius_rate = max_radial_speed*radius_ratio/perigee/sqrt(1.0 - radius_ratio*radius_ratio);
+	double rate_bound = (max_angular_rate + max_radius_rate)*ECLIPSE_RATE_MARGIN;
+
+	double step = fabs(orbit->eclipse_depth)/rate_bound/SECONDS_PER_DAY;
+	return fmin(fmax(step, ECLIPSE_MIN_STEP), ECLIPSE_MAX_STEP);
+}
+
+/**
+ * Shrink a bracket around a sign change of the shadow function using the shadow function at a time within it.
+ *
+ * \param time Time within the bracket
+ * \param value Shadow function at the time
+ * \param lower Lower end of bracket, updated
+ * \param lower_value Shadow function at the lower end, updated
+ * \param upper Upper end of bracket, updated
+ * \param upper_value Shadow function at the upper end, updated
+ * \return True if the upper end was moved, false if the lower end was moved
+ **/
+bool eclipse_shrink_bracket(predict_julian_date_t time, double value, predict_julian_date_t *lower, double *lower_value, predict_julian_date_t *upper, double *upper_value)
+{
+	if ((value > 0) == (*upper_value > 0)) {
+		*upper = time;
+		*upper_value = value;
+		return true;
+	} else {
+		*lower = time;
+		*lower_value = value;
+		return false;
+	}
+}
+
+/**
+ * Refine the time at which the shadow function changes sign within a bracket, using the Illinois variant of the
+ * false position method. Each estimate is followed by a probe just beyond it, so that an accurate estimate closes
+ * the bracket from both sides.
+ *
+ * \param orbital_elements Orbital elements
+ * \param lower Lower end of bracket
+ * \param lower_value Shadow function at the lower end
+ * \param upper Upper end of bracket
+ * \param upper_value Shadow function at the upper end, with opposite sign of `lower_value`
+ * \return Time of sign change
+ **/
+predict_julian_date_t eclipse_refine(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t lower, double lower_value, predict_julian_date_t upper, double upper_value)
+{
+	int retained_side = 0;
+	for (int i=0; (i < ECLIPSE_MAX_ITERATIONS) && (upper - lower > ECLIPSE_TIME_TOLERANCE); i++) {
+		predict_julian_date_t time = lower + (upper - lower)*lower_value/(lower_value - upper_value);
+		if (!((time > lower) && (time < upper))) {
+			time = (lower + upper)/2.0;
+		}
+
+		struct predict_position orbit;
+		predict_orbit(orbital_elements, &orbit, time);
+		bool upper_moved = eclipse_shrink_bracket(time, eclipse_shadow_function(&orbit), &lower, &lower_value, &upper, &upper_value);
+
+		//halve the value at an end that is retained twice in a row, so that both ends converge
+		int side = upper_moved ? -1 : 1;
+		if ((side == retained_side) && upper_moved) {
+			lower_value /= 2.0;
+		} else if (side == retained_side) {
+			upper_value /= 2.0;
+		}
+		retained_side = side;
+
+		predict_julian_date_t probe = upper_moved ? time - ECLIPSE_TIME_TOLERANCE/2.0 : time + ECLIPSE_TIME_TOLERANCE/2.0;
+		if ((probe > lower) && (probe < upper)) {
+			predict_orbit(orbital_elements, &orbit, probe);
+			eclipse_shrink_bracket(probe, eclipse_shadow_function(&orbit), &lower, &lower_value, &upper, &upper_value);
+		}
+	}
+	return (lower + upper)/2.0;
+}
+
+/**
+ * Add interval to the list of eclipse intervals.
+ *
+ * \param intervals Eclipse intervals
+ * \param entry_time Umbra entry
+ * \param exit_time Umbra exit
+ **/
+void eclipse_intervals_add(struct eclipse_intervals *intervals, predict_julian_date_t entry_time, predict_julian_date_t exit_time)
+{
+	if (intervals->num_intervals == intervals->available_size) {
+		intervals->available_size = (intervals->available_size > 0) ? intervals->available_size*2 : 16;
+		intervals->intervals = (struct eclipse_interval*)realloc(intervals->intervals, sizeof(struct eclipse_interval)*intervals->available_size);
+	}
+	intervals->intervals[intervals->num_intervals].entry_time = entry_time;
+	intervals->intervals[intervals->num_intervals].exit_time = exit_time;
+	intervals->num_intervals++;
+}
+
+void eclipse_intervals_find(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_intervals *intervals)
+{
+	intervals->num_intervals = 0;
+	intervals->decayed = false;
+
+	struct predict_position orbit;
+	predict_orbit(orbital_elements, &orbit, start_time);
+	if (orbit.decayed) {
+		intervals->decayed = true;
+		intervals->decay_time = start_time;
+		return;
+	}
+
+	predict_julian_date_t time = start_time;
+	predict_julian_date_t entry_time = start_time;
+	while (time < end_time) {
+		predict_julian_date_t next_time = fmin(time + eclipse_step(&orbit), end_time);
+		struct predict_position next_orbit;
+		predict_orbit(orbital_elements, &next_orbit, next_time);
+		if (next_orbit.decayed) {
+			intervals->decayed = true;
+			intervals->decay_time = time;
+			end_time = time;
+			break;
+		}
+
+		if (next_orbit.eclipsed != orbit.eclipsed) {
+			predict_julian_date_t crossing = eclipse_refine(orbital_elements, time, eclipse_shadow_function(&orbit), next_time, eclipse_shadow_function(&next_orbit));
+			if (next_orbit.eclipsed) {
+				entry_time = crossing;
+			} else {
+				eclipse_intervals_add(intervals, entry_time, crossing);
+			}
+		}
+		time = next_time;
+		orbit = next_orbit;
+	}
+
+	if (orbit.eclipsed) {
+		eclipse_intervals_add(intervals, entry_time, end_time);
+	}
+}
+
+void eclipse_intervals_free(struct eclipse_intervals *intervals)
+{
+	free(intervals->intervals);
+	intervals->intervals = NULL;
+	intervals->num_intervals = 0;
+	intervals->available_size = 0;
+}
+
+/**
+ * Get the first minute of the day that starts at or after the given time.
+ *
+ * \param time Time
+ * \param day_start Start of the day
+ * \return Minute, from 0 to ECLIPSE_MINUTES_PER_DAY
+ **/
+int eclipse_first_minute_after(predict_julian_date_t time, predict_julian_date_t day_start)
+{
+	double minute = ceil((time - day_start)*ECLIPSE_MINUTES_PER_DAY);
+	return fmin(fmax(minute, 0), ECLIPSE_MINUTES_PER_DAY);
+}
+
+int eclipse_intervals_sunlit_minutes(const struct eclipse_intervals *intervals, predict_julian_date_t day_start)
+{
+	int eclipsed_minutes = 0;
+	for (int i=0; i < intervals->num_intervals; i++) {
+		const struct eclipse_interval *interval = &(intervals->intervals[i]);
+		eclipsed_minutes += eclipse_first_minute_after(interval->exit_time, day_start) - eclipse_first_minute_after(interval->entry_time, day_start);
+	}
+
+	//minutes after the decay are neither sunlit nor eclipsed
+	int num_minutes = ECLIPSE_MINUTES_PER_DAY;
+	if (intervals->decayed) {
+		num_minutes = eclipse_first_minute_after(intervals->decay_time, day_start);
+	}
+	return num_minutes - eclipsed_minutes;
+}
+
+/**
+ * Data for calculating sunlit minutes in the worker threads.
+ **/
+struct eclipse_sunlit_minutes_task {
+	///Orbital elements
+	const predict_orbital_elements_t *orbital_elements;
+	///Start of the first day
+	predict_julian_date_t start_day;
+	///Number of days
+	int num_days;
+	///Returned number of sunlit minutes for each day
+	int *sunlit_minutes;
+	///Returned decay status for each day
+	bool *decayed;
+};
+
+/**
+ * Calculate the sunlit minutes of a slice of the days. Run by the worker threads.
+ *
+ * \param data Task, struct eclipse_sunlit_minutes_task
+ * \param slice Slice index
+ * \param num_slices Number of slices
+ **/
+void eclipse_sunlit_minutes_slice(void *data, int slice, int num_slices)
+{
+	struct eclipse_sunlit_minutes_task *task = (struct eclipse_sunlit_minutes_task*)data;
+	int start, end;
+	thread_pool_slice_range(task->num_days, slice, num_slices, &start, &end);
+
+	struct eclipse_intervals intervals = {0};
+	for (int i=start; i < end; i++) {
+		predict_julian_date_t day_start = task->start_day + i;
+		eclipse_intervals_find(task->orbital_elements, day_start, day_start + 1.0, &intervals);
+		task->sunlit_minutes[i] = eclipse_intervals_sunlit_minutes(&intervals, day_start);
+		task->decayed[i] = intervals.decayed;
+	}
+	eclipse_intervals_free(&intervals);
+}
+
+void eclipse_sunlit_minutes(struct thread_pool *pool, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_day, int num_days, int *sunlit_minutes, bool *decayed)
+{
+	struct eclipse_sunlit_minutes_task task = {.orbital_elements = orbital_elements, .start_day = start_day, .num_days = num_days, .sunlit_minutes = sunlit_minutes, .decayed = decayed};
+	if (pool != NULL) {
+		thread_pool_run(pool, eclipse_sunlit_minutes_slice, &task);
+	} else {
+		eclipse_sunlit_minutes_slice(&task, 0, 1);
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef ECLIPSE_INTERVALS_H_DEFINED
+#define ECLIPSE_INTERVALS_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+#include "thread_pool.h"
+
+/**
+ * Search for the time intervals a satellite spends in the earth's umbra, as given by the eclipse check in
+ * predict_orbit(). Umbra entries and exits are bracketed by stepping through the orbit with steps limited by how
+ * fast the eclipse depth can change, and refined using root finding on the eclipse depth. Used for the solar
+ * illumination predictions instead of propagating the orbit at every minute of the day.
+ **/
+
+//Number of minutes in a day
+#define ECLIPSE_MINUTES_PER_DAY 1440
+
+/**
+ * Time interval in eclipse.
+ **/
+struct eclipse_interval {
+	///Time of umbra entry, or start of the searched time span if already eclipsed
+	predict_julian_date_t entry_time;
+	///Time of umbra exit, or end of the searched time span if still eclipsed
+	predict_julian_date_t exit_time;
+};
+
+/**
+ * Eclipse intervals within a time span.
+ **/
+struct eclipse_intervals {
+	///Number of intervals
+	int num_intervals;
+	///Intervals, in chronological order
+	struct eclipse_interval *intervals;
+	///Available size in the `intervals` array, reallocated at need
+	int available_size;
+	///Whether the orbit decayed within the time span. Intervals are searched only up to the decay
+	bool decayed;
+	///Last time the orbit was found not to be decayed, or the start of the time span if decayed from the start. Valid when `decayed` is set
+	predict_julian_date_t decay_time;
+};
+
+/**
+ * Find the eclipse intervals of a satellite within a time span.
+ *
+ * \param orbital_elements Orbital elements
+ * \param start_time Start of time span
+ * \param end_time End of time span
+ * \param intervals Returned intervals. Should be initialized to zero, and freed using eclipse_intervals_free()
+ **/
+void eclipse_intervals_find(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_intervals *intervals);
+
+/**
+ * Free the interval array.
+ *
+ * \param intervals Eclipse intervals
+ **/
+void eclipse_intervals_free(struct eclipse_intervals *intervals);
+
+/**
+ * Count the number of sunlit minutes in a day from the eclipse intervals, sampled at the start of each minute. Minutes
+ * after the decay of the orbit are not counted as sunlit.
+ *
+ * \param intervals Eclipse intervals, covering the day
+ * \param day_start Start of the day
+ * \return Number of sunlit minutes, from 0 to ECLIPSE_MINUTES_PER_DAY
+ **/
+int eclipse_intervals_sunlit_minutes(const struct eclipse_intervals *intervals, predict_julian_date_t day_start);
+
+/**
+ * Calculate the number of sunlit minutes for a range of consecutive days, with the days divided across the worker
+ * threads of a thread pool.
+ *
+ * \param pool Thread pool, or NULL for calculating in the calling thread
+ * \param orbital_elements Orbital elements
+ * \param start_day Start of the first day
+ * \param num_days Number of days
+ * \param sunlit_minutes Returned number of sunlit minutes for each day, counted up to the decay for decayed days
+ * \param decayed Returned decay status for each day, true if the orbit has decayed by the end of the day
+ **/
+void eclipse_sunlit_minutes(struct thread_pool *pool, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_day, int num_days, int *sunlit_minutes, bool *decayed);
+
+#endif
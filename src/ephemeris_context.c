@@ -0,0 +1,226 @@
+#include "ephemeris_context.h"
+#include <math.h>
+
+#define JULIAN_TIME_DIFF 2444238.5
+#define SECONDS_PER_DAY 86400.0
+#define EARTH_RADIUS_KM_WGS84 6.378137E3
+#define FLATTENING_FACTOR 3.35281066474748E-3
+#define EARTH_ANGULAR_VELOCITY 7.292115E-5
+#define EARTH_ROTATIONS_PER_SIDERIAL_DAY 1.00273790934
+#define SOLAR_RADIUS_KM 6.96000E5
+#define ASTRONOMICAL_UNIT_KM 1.49597870691E8
+
+/**
+ * Reduce value to [0, divisor).
+ *
+ * \param value Value
+ * \param divisor Divisor
+ * \return Reduced value
+ **/
+static inline double ephemeris_context_modulus(double value, double divisor)
+{
+	double ret_val = fmod(value, divisor);
+	if (ret_val < 0.0) {
+		ret_val += divisor;
+	}
+	return ret_val;
+}
+
+/**
+ * Calculate position of the sun, as in libpredict.
+ *
+ * \param time Time
+ * \param position Returned position in km, ECI frame
+ **/
+void ephemeris_context_solar_position(predict_julian_date_t time, double position[3])
+{
+	double mjd = time + JULIAN_TIME_DIFF - 2415020.0;
+	double year = 1900 + mjd/365.25;
+	double delta_et = 26.465 + 0.747622*(year - 1950) + 1.886913*sin(2*M_PI*(year - 1975)/33);
+	double T = (mjd + delta_et/SECONDS_PER_DAY)/36525.0;
+	double M = (M_PI/180.0)*ephemeris_context_modulus(358.47583 + fmod(35999.04975*T, 360.0) - (0.000150 + 0.0000033*T)*T*T, 360.0);
+	double L = (M_PI/180.0)*ephemeris_context_modulus(279.69668 + fmod(36000.76892*T, 360.0) + 0.0003025*T*T, 360.0);
+	double e = 0.01675104 - (0.0000418 + 0.000000126*T)*T;
+	double C = (M_PI/180.0)*((1.919460 - (0.004789 + 0.000014*T)*T)*sin(M) + (0.020094 - 0.000100*T)*sin(2*M) + 0.000293*sin(3*M));
+	double O = (M_PI/180.0)*ephemeris_context_modulus(259.18 - 1934.142*T, 360.0);
+	double Lsa = ephemeris_context_modulus(L + C - (M_PI/180.0)*(0.00569 - 0.00479*sin(O)), 2*M_PI);
+	double nu = ephemeris_context_modulus(M + C, 2*M_PI);
+	double R = 1.0000002*(1 - e*e)/(1 + e*cos(nu));
+	double eps = (M_PI/180.0)*(23.452294 - (0.0130125 + (0.00000164 - 0.000000503*T)*T)*T + 0.00256*cos(O));
+	R = ASTRONOMICAL_UNIT_KM*R;
+	position[0] = R*cos(Lsa);
+	position[1] = R*sin(Lsa)*cos(eps);
+	position[2] = R*sin(Lsa)*sin(eps);
+}
+
+/**
+ * Calculate Greenwich sidereal time, as in libpredict.
+ *
+ * \param time Time
+ * \return Sidereal time in radians
+ **/
+double ephemeris_context_theta_g(predict_julian_date_t time)
+{
+	double jd = time + JULIAN_TIME_DIFF;
+	double UT = (jd + 0.5) - floor(jd + 0.5);
+	jd = jd - UT;
+	double TU = (jd - 2451545.0)/36525;
+	double GMST = 24110.54841 + TU*(8640184.812866 + TU*(0.093104 - TU*6.2E-6));
+	GMST = ephemeris_context_modulus(GMST + SECONDS_PER_DAY*EARTH_ROTATIONS_PER_SIDERIAL_DAY*UT, SECONDS_PER_DAY);
+	return 2*M_PI*GMST/SECONDS_PER_DAY;
+}
+
+/**
+ * Calculate topocentric azimuth, elevation, range and their rates of an object with given ECI position and velocity.
+ *
+ * \param context Context
+ * \param position Position in km
+ * \param velocity Velocity in km/s
+ * \param obs Returned observation
+ **/
+void ephemeris_context_observe_position(const struct ephemeris_context *context, const double position[3], const double velocity[3], struct predict_observation *obs)
+{
+	double range[3], rgvel[3];
+	for (int i=0; i < 3; i++) {
+		range[i] = position[i] - context->observer_position[i];
+		rgvel[i] = velocity[i] - context->observer_velocity[i];
+	}
+	double range_length = sqrt(range[0]*range[0] + range[1]*range[1] + range[2]*range[2]);
+	double range_rate = (range[0]*rgvel[0] + range[1]*rgvel[1] + range[2]*rgvel[2])/range_length;
+
+	//rotate to topocentric coordinates (south, east, zenith)
+	double theta_dot = 2*M_PI*EARTH_ROTATIONS_PER_SIDERIAL_DAY/SECONDS_PER_DAY;
+	double sin_lat = context->sin_lat, cos_lat = context->cos_lat;
+	double sin_theta = context->sin_theta, cos_theta = context->cos_theta;
+	double top_s = sin_lat*cos_theta*range[0] + sin_lat*sin_theta*range[1] - cos_lat*range[2];
+	double top_e = -sin_theta*range[0] + cos_theta*range[1];
+	double top_z = cos_lat*cos_theta*range[0] + cos_lat*sin_theta*range[1] + sin_lat*range[2];
+	double top_s_dot = sin_lat*(cos_theta*rgvel[0] - sin_theta*range[0]*theta_dot) + sin_lat*(sin_theta*rgvel[1] + cos_theta*range[1]*theta_dot) - cos_lat*rgvel[2];
+	double top_e_dot = -(sin_theta*rgvel[0] + cos_theta*range[0]*theta_dot) + (cos_theta*rgvel[1] - sin_theta*range[1]*theta_dot);
+	double top_z_dot = cos_lat*(cos_theta*(rgvel[0] + range[1]*theta_dot) + sin_theta*(rgvel[1] - range[0]*theta_dot)) + sin_lat*rgvel[2];
+
+	//azimuth
+	double y = -top_e/top_s;
+	double azimuth = atan(y);
+	if (top_s > 0.0) {
+		azimuth += M_PI;
+	}
+	if (azimuth < 0.0) {
+		azimuth += 2*M_PI;
+	}
+	double y_dot = -(top_e_dot*top_s - top_s_dot*top_e)/(top_s*top_s);
+
+	//elevation
+	double x = top_z/range_length;
+	double elevation = asin(fmax(fmin(x, 1.0), -1.0));
+	double x_dot = (top_z_dot*range_length - range_rate*top_z)/(range_length*range_length);
+
+	obs->azimuth = azimuth;
+	obs->azimuth_rate = y_dot/(1 + y*y);
+	obs->elevation = elevation;
+	obs->elevation_rate = x_dot/sqrt(1 - x*x);
+	obs->range = range_length;
+	obs->range_rate = range_rate;
+	obs->range_x = range[0];
+	obs->range_y = range[1];
+	obs->range_z = range[2];
+}
+
+void ephemeris_context_update(struct ephemeris_context *context, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	context->time = time;
+	context->observer = observer;
+	context->sun_elevation_limit = NAUTICAL_TWILIGHT_SUN_ELEVATION;
+	context->theta_g = ephemeris_context_theta_g(time);
+
+	//observer position and velocity, stationary relative to the earth's surface
+	double altitude = observer->altitude/1000.0;
+	context->theta = ephemeris_context_modulus(context->theta_g + observer->longitude, 2*M_PI);
+	context->sin_lat = sin(observer->latitude);
+	context->cos_lat = cos(observer->latitude);
+	context->sin_theta = sin(context->theta);
+	context->cos_theta = cos(context->theta);
+	double c = 1/sqrt(1 + FLATTENING_FACTOR*(FLATTENING_FACTOR - 2)*context->sin_lat*context->sin_lat);
+	double sq = (1 - FLATTENING_FACTOR)*(1 - FLATTENING_FACTOR)*c;
+	double achcp = (EARTH_RADIUS_KM_WGS84*c + altitude)*context->cos_lat;
+	context->observer_position[0] = achcp*context->cos_theta;
+	context->observer_position[1] = achcp*context->sin_theta;
+	context->observer_position[2] = (EARTH_RADIUS_KM_WGS84*sq + altitude)*context->sin_lat;
+	context->observer_velocity[0] = -EARTH_ANGULAR_VELOCITY*context->observer_position[1];
+	context->observer_velocity[1] = EARTH_ANGULAR_VELOCITY*context->observer_position[0];
+	context->observer_velocity[2] = 0;
+
+	//sun, with range in AU and range rate in m/s as in predict_observe_sun()
+	ephemeris_context_solar_position(time, context->solar_position);
+	double zero_vector[3] = {0};
+	ephemeris_context_observe_position(context, context->solar_position, zero_vector, &(context->sun));
+	context->sun.range = 1.0 + (context->sun.range - ASTRONOMICAL_UNIT_KM)/ASTRONOMICAL_UNIT_KM;
+	context->sun.range_rate = 1000.0*context->sun.range_rate;
+	context->sun.visible = false;
+	context->sun.time = time;
+}
+
+void ephemeris_context_update_moon(struct ephemeris_context *context)
+{
+	predict_observe_moon(context->observer, context->time, &(context->moon));
+}
+
+void ephemeris_context_observe_orbit(const struct ephemeris_context *context, const struct predict_position *orbit, struct predict_observation *obs)
+{
+	ephemeris_context_observe_position(context, orbit->position, orbit->velocity, obs);
+
+	//visible if the satellite is above the horizon and in sunlight, while the sun is low enough
+	obs->visible = !orbit->eclipsed && (context->sun.elevation*180.0/M_PI < context->sun_elevation_limit) && (obs->elevation*180.0/M_PI > 0);
+	obs->time = orbit->time;
+}
+
+void ephemeris_context_observe_orbits(const struct ephemeris_context *context, int num_orbits, const struct predict_position *orbits, struct predict_observation *observations)
+{
+	for (int i=0; i < num_orbits; i++) {
+		ephemeris_context_observe_orbit(context, &(orbits[i]), &(observations[i]));
+	}
+}
+
+bool ephemeris_context_eclipsed(const struct ephemeris_context *context, const double position[3], double *eclipse_depth)
+{
+	const double *sol = context->solar_position;
+	double pos_length = sqrt(position[0]*position[0] + position[1]*position[1] + position[2]*position[2]);
+	double rho[3] = {sol[0] - position[0], sol[1] - position[1], sol[2] - position[2]};
+	double sd_earth = asin(fmin(EARTH_RADIUS_KM_WGS84/pos_length, 1.0));
+	double sd_sun = asin(fmin(SOLAR_RADIUS_KM/sqrt(rho[0]*rho[0] + rho[1]*rho[1] + rho[2]*rho[2]), 1.0));
+	double sol_length = sqrt(sol[0]*sol[0] + sol[1]*sol[1] + sol[2]*sol[2]);
+	double cos_delta = -(sol[0]*position[0] + sol[1]*position[1] + sol[2]*position[2])/sol_length/pos_length;
+	double delta = acos(fmax(fmin(cos_delta, 1.0), -1.0));
+	*eclipse_depth = sd_earth - sd_sun - delta;
+	return (sd_earth >= sd_sun) && (*eclipse_depth >= 0);
+}
+
+void ephemeris_context_geodetic_position(const struct ephemeris_context *context, struct predict_position *orbit)
+{
+	//geodetic position, WGS 84 ellipsoid
+	const double *pos = orbit->position;
+	double longitude = ephemeris_context_modulus(atan2(pos[1], pos[0]) - context->theta_g, 2*M_PI);
+	double r = sqrt(pos[0]*pos[0] + pos[1]*pos[1]);
+	double e2 = FLATTENING_FACTOR*(2 - FLATTENING_FACTOR);
+	double latitude = atan2(pos[2], r);
+	double phi, c;
+	do {
+		phi = latitude;
+		double sin_phi = sin(phi);
+		c = 1/sqrt(1 - e2*sin_phi*sin_phi);
+		latitude = atan2(pos[2] + EARTH_RADIUS_KM_WGS84*c*e2*sin_phi, r);
+	} while (fabs(latitude - phi) >= 1E-10);
+	orbit->altitude = r/cos(latitude) - EARTH_RADIUS_KM_WGS84*c;
+	if (latitude > M_PI/2) {
+		latitude -= 2*M_PI;
+	}
+	if (longitude > M_PI) {
+		longitude -= 2*M_PI;
+	}
+	orbit->latitude = latitude;
+	orbit->longitude = longitude;
+
+	orbit->eclipsed = ephemeris_context_eclipsed(context, pos, &(orbit->eclipse_depth));
+
+	orbit->footprint = 2.0*EARTH_RADIUS_KM_WGS84*acos(EARTH_RADIUS_KM_WGS84/(EARTH_RADIUS_KM_WGS84 + orbit->altitude));
+}
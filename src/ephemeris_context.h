@@ -0,0 +1,102 @@
+#ifndef EPHEMERIS_CONTEXT_H_DEFINED
+#define EPHEMERIS_CONTEXT_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+
+/**
+ * Quantities that depend only on the time and the QTH, shared by all satellites observed at the same time:
+ * sidereal time, observer position and velocity, topocentric rotation and the sun vector. Computed once per
+ * update using ephemeris_context_update(), and used for observing any number of orbits and for the sun information.
+ * The moon is only observed on request using ephemeris_context_update_moon(), since it is costly and not needed for
+ * observing orbits. Gives the same results as predict_observe_orbit(), predict_observe_sun() and the eclipse check
+ * in predict_orbit().
+ **/
+
+//Sun elevation below which satellites in sunlight are considered visible, in degrees
+#define NAUTICAL_TWILIGHT_SUN_ELEVATION -12.0
+
+/**
+ * Ephemeris context.
+ **/
+struct ephemeris_context {
+	///Time
+	predict_julian_date_t time;
+	///Observer
+	const predict_observer_t *observer;
+	///Greenwich sidereal time, in radians
+	double theta_g;
+	///Local sidereal time of the observer, in radians
+	double theta;
+	///Observer position in km, ECI frame
+	double observer_position[3];
+	///Observer velocity in km/s, ECI frame
+	double observer_velocity[3];
+	///Sine and cosine of the observer latitude and the local sidereal time, defining the rotation from ECI to topocentric coordinates
+	double sin_lat, cos_lat, sin_theta, cos_theta;
+	///Sun position in km, ECI frame
+	double solar_position[3];
+	///Observation of the sun, as returned by predict_observe_sun()
+	struct predict_observation sun;
+	///Observation of the moon, as returned by predict_observe_moon(). Set only by ephemeris_context_update_moon()
+	struct predict_observation moon;
+	///Sun elevation below which satellites in sunlight are considered visible, in degrees. Set to NAUTICAL_TWILIGHT_SUN_ELEVATION by ephemeris_context_update(), and can be changed before observing orbits
+	double sun_elevation_limit;
+};
+
+/**
+ * Calculate the ephemeris context for the given observer and time.
+ *
+ * \param context Returned context
+ * \param observer Observer, has to be valid for as long as the context is used
+ * \param time Time
+ **/
+void ephemeris_context_update(struct ephemeris_context *context, const predict_observer_t *observer, predict_julian_date_t time);
+
+/**
+ * Observe the moon at the time and observer of the context.
+ *
+ * \param context Context, updated using ephemeris_context_update()
+ **/
+void ephemeris_context_update_moon(struct ephemeris_context *context);
+
+/**
+ * Observe orbit from the observer of the context. Same as predict_observe_orbit(), but without recalculating
+ * the time and observer dependent quantities, and with the visibility given by the sun elevation limit of the context.
+ *
+ * \param context Context. Should have the same time as the orbit
+ * \param orbit Orbit
+ * \param obs Returned observation
+ **/
+void ephemeris_context_observe_orbit(const struct ephemeris_context *context, const struct predict_position *orbit, struct predict_observation *obs);
+
+/**
+ * Observe several orbits from the observer of the context.
+ *
+ * \param context Context. Should have the same time as the orbits
+ * \param num_orbits Number of orbits
+ * \param orbits Orbits
+ * \param observations Returned observations, one for each orbit
+ **/
+void ephemeris_context_observe_orbits(const struct ephemeris_context *context, int num_orbits, const struct predict_position *orbits, struct predict_observation *observations);
+
+/**
+ * Check whether a position is eclipsed by the earth, as done in predict_orbit().
+ *
+ * \param context Context
+ * \param position Position in km, ECI frame
+ * \param eclipse_depth Returned eclipse depth, in radians
+ * \return True if eclipsed, false otherwise
+ **/
+bool ephemeris_context_eclipsed(const struct ephemeris_context *context, const double position[3], double *eclipse_depth);
+
+/**
+ * Calculate the geodetic position (latitude, longitude, altitude), footprint and eclipse status of an orbit from its
+ * ECI position, as done in predict_orbit().
+ *
+ * \param context Context. Should have the same time as the orbit
+ * \param orbit Orbit with the position set. The other quantities are filled in
+ **/
+void ephemeris_context_geodetic_position(const struct ephemeris_context *context, struct predict_position *orbit);
+
+#endif
@@ -164,7 +164,7 @@ void filtered_menu_pattern_match(struct filtered_menu *list, const struct tle_db
 		}
 
 		//check against TLE filename
-		char *fname_uppercase = str_to_uppercase(tle_db->tles[i].filename);
+		char *fname_uppercase = str_to_uppercase(tle_db_entry_filename(tle_db, i));
 		if (pattern_match(fname_uppercase, pattern)) {
 			display_items[i] = true;
 		}
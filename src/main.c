@@ -13,7 +13,10 @@
 #include "tle_db.h"
 #include "xdg_basedirs.h"
 #include "transponder_db.h"
+#include "catalog_snapshot.h"
 #include "option_help.h"
+#include "pass_sampler.h"
+#include "ephemeris_context.h"
 #include <libgen.h>
 
 //longopt value identificators for command line options without shorthand
@@ -22,6 +25,9 @@
 #define FLYBY_OPT_DOWNLINK_PORT 204
 #define FLYBY_OPT_DOWNLINK_VFO 205
 #define FLYBY_OPT_ADD_TLE 207
+#define FLYBY_OPT_THREADS 208
+#define FLYBY_OPT_PASS_RESOLUTION 209
+#define FLYBY_OPT_SUN_DEPRESSION 210
 
 /**
  * Parse input argument on format host:port to each separate argument.
@@ -87,6 +93,15 @@ int main(int argc, char **argv)
 	char qth_filename[MAX_NUM_CHARS] = {0};
 	bool qth_cmd_filename_set = false;
 
+	//number of worker threads, 0 means number of online CPUs
+	int num_threads = 0;
+
+	//resolution of the rows in the pass schedules
+	struct pass_sampler_resolution pass_resolution = PASS_SAMPLER_DEFAULT_RESOLUTION;
+
+	//sun depression below the horizon at which satellites in sunlight are visible, in degrees
+	double sun_depression = -NAUTICAL_TWILIGHT_SUN_ELEVATION;
+
 	//command line options
 	struct option_extended options[] = {
 		{{"add-tle-file",		required_argument,	0,	FLYBY_OPT_ADD_TLE},
@@ -95,7 +110,7 @@ int main(int argc, char **argv)
 		},
 		{{"update-tle-db",		required_argument,	0,	'u'},
 			"FILE",
-			"Update TLE database with TLE file FILE. Multiple files can be specified using the same option multiple times (e.g. -u file1 -u file2 ...). Flyby will exit afterwards. Any new TLEs in the file will be ignored."
+			"Update TLE database with TLE file FILE, or with all TLE files in directory FILE. Multiple files can be specified using the same option multiple times (e.g. -u file1 -u file2 ...), and are applied together so that each database file is rewritten only once. Flyby will exit afterwards. Any new TLEs in the file will be ignored."
 		},
 		{{"tle-file",			required_argument,	0,	't'},
 			"FILE",
@@ -129,6 +144,18 @@ int main(int argc, char **argv)
 			"VFO_NAME",
 			"Specify rigctld downlink VFO."
 		},
+		{{"threads",			required_argument,	0,	FLYBY_OPT_THREADS},
+			"NUM",
+			"Use NUM worker threads for reading TLE files, for updating the satellite listing and for calculating the solar illumination predictions. Defaults to the number of available CPUs."
+		},
+		{{"pass-resolution",		required_argument,	0,	FLYBY_OPT_PASS_RESOLUTION},
+			"RESOLUTION",
+			"Resolution of the rows in the pass predictions, as a time step in seconds (e.g. 30s) or as an angular step on the sky in degrees (e.g. 5deg). Defaults to 17deg."
+		},
+		{{"sun-depression",		required_argument,	0,	FLYBY_OPT_SUN_DEPRESSION},
+			"DEG",
+			"Depression of the sun below the horizon, in degrees, before satellites in sunlight are considered visible in the visible pass predictions. Defaults to 12 (nautical twilight)."
+		},
 		{{"help",			no_argument,		0,	'h'},
 			NULL,
 			"Show help."
@@ -188,6 +215,26 @@ int main(int argc, char **argv)
 			case FLYBY_OPT_DOWNLINK_VFO: //downlink vfo
 				strncpy(rigctld_downlink_vfo, optarg, MAX_NUM_CHARS);
 				break;
+			case FLYBY_OPT_THREADS: //number of worker threads
+				num_threads = strtol(optarg, NULL, 10);
+				if (num_threads < 1) {
+					fprintf(stderr, "Number of threads must be a positive integer.\n");
+					exit(1);
+				}
+				break;
+			case FLYBY_OPT_PASS_RESOLUTION: //resolution of pass predictions
+				if (!pass_sampler_parse_resolution(optarg, &pass_resolution)) {
+					fprintf(stderr, "Pass resolution must be a positive number followed by s or deg, got %s.\n", optarg);
+					exit(1);
+				}
+				break;
+			case FLYBY_OPT_SUN_DEPRESSION: //sun depression for visible passes
+				sun_depression = strtod(optarg, NULL);
+				if ((sun_depression < 0) || (sun_depression > 90)) {
+					fprintf(stderr, "Sun depression must be between 0 and 90 degrees, got %s.\n", optarg);
+					exit(1);
+				}
+				break;
 			case 'h': //help
 				getopt_long_show_help(usage_instructions, options, short_options);
 				return 0;
@@ -233,6 +280,8 @@ int main(int argc, char **argv)
 
 	//read TLE database
 	struct tle_db *tle_db = tle_db_create();
+	tle_db->num_loader_threads = num_threads;
+	struct transponder_db *transponder_db = NULL;
 	int num_cmd_tle_files = string_array_size(&tle_cmd_filenames);
 	if (num_cmd_tle_files > 0) {
 		//TLEs are read from files specified on the command line
@@ -247,9 +296,11 @@ int main(int argc, char **argv)
 			}
 			tle_db_destroy(&temp_db);
 		}
+		transponder_db = transponder_db_create(tle_db);
+		transponder_db_from_search_paths(tle_db, transponder_db);
 	} else {
-		//TLEs are read from XDG dirs
-		tle_db_from_search_paths(tle_db);
+		//TLEs and transponders are read from XDG dirs, or from the snapshot in XDG_CACHE_HOME if these are unchanged
+		catalog_from_search_paths(tle_db, &transponder_db);
 	}
 
 	whitelist_from_search_paths(tle_db);
@@ -257,11 +308,8 @@ int main(int argc, char **argv)
 	//use tle update files to update the TLE database, if present
 	int num_update_files = string_array_size(&tle_update_filenames);
 	if (num_update_files > 0) {
-		for (int i=0; i < num_update_files; i++) {
-			printf("Updating TLE database using %s:\n\n", string_array_get(&tle_update_filenames, i));
-			update_tle_database(string_array_get(&tle_update_filenames, i), tle_db);
-			printf("\n");
-		}
+		update_tle_database_from_files(&tle_update_filenames, tle_db);
+		printf("\n");
 		string_array_free(&tle_update_filenames);
 		return 0;
 	}
@@ -331,10 +379,7 @@ int main(int argc, char **argv)
 		free(temp);
 	}
 
-	struct transponder_db *transponder_db = transponder_db_create(tle_db);
-	transponder_db_from_search_paths(tle_db, transponder_db);
-
-	run_flyby_curses_ui(is_new_user, qth_filename, observer, tle_db, transponder_db, &rotctld, &downlink, &uplink);
+	run_flyby_curses_ui(is_new_user, qth_filename, observer, tle_db, transponder_db, &rotctld, &downlink, &uplink, num_threads, &pass_resolution, -sun_depression);
 
 	//disconnect from rigctl and rotctl
 	rigctld_disconnect(&downlink);
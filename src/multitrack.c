@@ -5,8 +5,16 @@
 #include <stdio.h>
 #include <curses.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "tle_db.h"
+#include "ephemeris_context.h"
 #include "multitrack.h"
+#include "thread_pool.h"
+#include "sgp4_batch.h"
+#include "update_schedule.h"
+#include "order_tree.h"
+#include "search_index.h"
+#include "pass_cache.h"
 #include "ui.h"
 
 //header (Satellite Azim Elev ...) color style
@@ -18,6 +26,15 @@
 //marker of menu item
 #define MULTITRACK_SELECTED_MARKER '-'
 
+//time before AOS at which the AOS countdown (MM:SS) is displayed, in days
+#define MULTITRACK_AOS_COUNTDOWN 0.00694
+
+//update interval of satellites that are far from AOS, in days
+#define MULTITRACK_FAR_UPDATE_INTERVAL (1.0/(24.0*60.0))
+
+//update interval of geostationary satellites and satellites that never rise, in days
+#define MULTITRACK_STATIC_UPDATE_INTERVAL (1.0/(24.0*60.0))
+
 /** Private multitrack satellite listing prototypes. **/
 
 /**
@@ -35,13 +52,14 @@ void multitrack_settings_from_file(multitrack_listing_t *listing);
 void multitrack_settings_to_file(multitrack_listing_t *listing);
 
 /**
- * Create entry in multitrack satellite listing.
+ * Create entry in multitrack satellite listing. The entry uses the cached orbital elements owned by the TLE database,
+ * and keeps a copy of the TLE lines for detecting updated TLEs.
  *
- * \param name Satellite name
- * \param orbital_elements Orbital elements of satellite, created from TLE
+ * \param tle_db TLE database
+ * \param tle_index Index of the satellite in the TLE database
  * \return Multitrack entry
  **/
-multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_elements_t *orbital_elements);
+multitrack_entry_t *multitrack_create_entry(struct tle_db *tle_db, int tle_index);
 
 /**
  * Print scrollbar for satellite listing.
@@ -56,36 +74,154 @@ void multitrack_print_scrollbar(multitrack_listing_t *listing);
  * \param window Window to display entry in
  * \param row Row
  * \param col Column
- * \param entry Satellite entry
+ * \param entry Satellite entry, formatted before it is displayed
+ * \param selected Whether the entry is the selected entry, displayed with a marker and inverted colors
  **/
-void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry);
+void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry, bool selected);
 
 /**
- * Update display strings and status in satellite entry.
+ * Update status of satellite entry. The display string is not formatted until the entry is displayed (see
+ * multitrack_format_entry()).
  *
  * \param max_elevation_threshold Max elevation threshold
  * \param qth QTH coordinates
+ * \param pass_cache Pass cache, used for the next AOS/LOS and maximum elevation
+ * \param tle_index Index of the entry in the TLE database
  * \param entry Multitrack entry
- * \param time Time at which satellite status should be calculated
- * \return True if aos/los times change, false otherwise
+ * \param orbit Orbit of the satellite at the time at which satellite status should be calculated (see multitrack_entry_orbit())
+ * \param obs Observation of the orbit from the QTH (see ephemeris_context_observe_orbit())
+ * \return True if aos/los times change or the entry becomes pending or ready, false otherwise
+ **/
+bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, multitrack_entry_t *entry, const struct predict_position *orbit, const struct predict_observation *obs);
+
+/**
+ * Format display string and display attributes of satellite entry from the status set in the last
+ * multitrack_update_entry(). Does nothing if the entry has not been updated since it was last formatted, so that
+ * only the displayed entries are formatted, and only once per update.
+ *
+ * \param entry Satellite entry
+ **/
+void multitrack_format_entry(multitrack_entry_t *entry);
+
+/**
+ * Propagate and observe a range of the listing entries, storing the results in `orbits` and `observations`.
+ * Near-earth entries are propagated using the batch propagation, and all entries are observed using the shared
+ * ephemeris context. Different ranges can be calculated concurrently from different threads.
+ *
+ * \param listing Satellite listing
+ * \param context Ephemeris context
+ * \param start First entry index
+ * \param end Entry index after the last one to calculate
+ **/
+void multitrack_observe_entries(multitrack_listing_t *listing, const struct ephemeris_context *context, int start, int end);
+
+/**
+ * Propagate and observe a range of the entries that are due for update in `due_entries`. Consecutive entries are
+ * propagated together.
+ *
+ * \param listing Satellite listing
+ * \param context Ephemeris context
+ * \param start First index in `due_entries`
+ * \param end Index in `due_entries` after the last one to calculate
+ **/
+void multitrack_observe_due_entries(multitrack_listing_t *listing, const struct ephemeris_context *context, int start, int end);
+
+/**
+ * Get the time at which the satellite entry next has to be updated, according to its status after an update.
+ * Satellites above the horizon, within the AOS countdown or with a pending pass prediction are updated on every
+ * update, satellites far from AOS, geostationary satellites and satellites that never rise at a minute-level
+ * interval, and decayed satellites never.
+ *
+ * \param entry Satellite entry, updated using multitrack_update_entry()
+ * \param time Time of the update
+ * \return Time of next update
+ **/
+predict_julian_date_t multitrack_entry_next_update(const multitrack_entry_t *entry, predict_julian_date_t time);
+
+/**
+ * Get orbit of satellite entry, from the batch propagation when the entry is near-earth, and from predict_orbit() otherwise.
+ * The batch has to be propagated to the same time beforehand.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Index of entry in the listing
+ * \param time Time
+ * \param orbit Returned orbit
+ **/
+void multitrack_entry_orbit(multitrack_listing_t *listing, int entry_index, predict_julian_date_t time, struct predict_position *orbit);
+
+/**
+ * Categories of the sorted satellite listing, in display order.
+ **/
+enum multitrack_category {
+	MULTITRACK_CATEGORY_ABOVE_HORIZON,
+	MULTITRACK_CATEGORY_BELOW_HORIZON,
+	MULTITRACK_CATEGORY_BELOW_THRESHOLD,
+	MULTITRACK_CATEGORY_PENDING,
+	MULTITRACK_CATEGORY_NEVER_VISIBLE,
+	MULTITRACK_CATEGORY_DECAYED
+};
+
+/**
+ * Get category of satellite entry in the sorted listing.
+ *
+ * \param entry Satellite entry
+ * \return Category
+ **/
+enum multitrack_category multitrack_entry_category(const multitrack_entry_t *entry);
+
+/**
+ * Reset the number of entries in each category.
+ *
+ * \param listing Satellite listing
+ **/
+void multitrack_reset_category_counts(multitrack_listing_t *listing);
+
+/**
+ * Mark the position of an entry in the sorted listing as outdated, so that it is moved on the next
+ * multitrack_sort_listing() if its category or sort key has changed.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Entry index
  **/
-bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, predict_julian_date_t time);
+void multitrack_mark_order_outdated(multitrack_listing_t *listing, int entry_index);
 
 /**
- * Sort satellite listing in different categories: Currently above horizon, below horizon but will rise, will never rise above horizon, decayed satellites. The satellites below the horizon are sorted internally according to AOS times.
+ * Sort satellite listing in different categories: Currently above horizon, below horizon but will rise, below the
+ * max elevation threshold, pending pass predictions, will never rise above horizon, decayed satellites. The
+ * satellites below the horizon are sorted internally according to AOS times. Only the entries marked using
+ * multitrack_mark_order_outdated() are moved, in O(log n) each.
  *
  * \param listing Satellite listing
  **/
 void multitrack_sort_listing(multitrack_listing_t *listing);
 
+/**
+ * Set the searchable fields of a satellite entry in the listing's search index: name, satellite number and
+ * international designator.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Index of entry in the listing
+ * \param tle_db TLE database
+ * \param tle_index Index of the satellite in the TLE database
+ **/
+void multitrack_index_entry(multitrack_listing_t *listing, int entry_index, const struct tle_db *tle_db, int tle_index);
+
 /**
  * Apply search information in the search field, and construct match array for matches found in the satellite list.
- * Match state is saved to listing->search_field.
+ * Match state is saved to listing->search_field. Jumps to the first match at or below the selected entry.
  *
  * \param listing Satellite list
  **/
 void multitrack_search_listing(multitrack_listing_t *listing);
 
+/**
+ * Select the search match that is first in the listing order counted from the given index, wrapping around.
+ *
+ * \param listing Satellite list
+ * \param start_index Index in the displayed listing to start from
+ **/
+void multitrack_listing_jump_to_match(multitrack_listing_t *listing, int start_index);
+
 /**
  * Jump to next search match (obtained from listing->search_field).
  *
@@ -258,11 +394,13 @@ void multitrack_resize(multitrack_listing_t *listing);
 
 /** Multitrack satellite listing function implementations. **/
 
-multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_elements_t *orbital_elements)
+multitrack_entry_t *multitrack_create_entry(struct tle_db *tle_db, int tle_index)
 {
 	multitrack_entry_t *entry = (multitrack_entry_t*)malloc(sizeof(multitrack_entry_t));
-	entry->orbital_elements = orbital_elements;
-	entry->name = strdup(name);
+	entry->orbital_elements = tle_db_entry_to_orbital_elements(tle_db, tle_index);
+	entry->name = strdup(tle_db_entry_name(tle_db, tle_index));
+	strncpy(entry->line1, tle_db->tles[tle_index].line1, TLE_LINE_LENGTH+1);
+	strncpy(entry->line2, tle_db->tles[tle_index].line2, TLE_LINE_LENGTH+1);
 	entry->next_aos = 0;
 	entry->next_los = 0;
 	entry->above_horizon = 0;
@@ -271,6 +409,12 @@ multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_el
 	entry->decayed = 0;
 	entry->max_elevation = 0;
 	entry->above_max_elevation_threshold = true;
+	entry->pending = false;
+	entry->category = -1;
+	entry->order_outdated = false;
+	entry->display_string[0] = '\0';
+	entry->display_string_outdated = false;
+	entry->display_attributes = 0;
 	return entry;
 }
 
@@ -301,7 +445,7 @@ void multitrack_resize(multitrack_listing_t *listing)
 	wrefresh(listing->header_window);
 }
 
-multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, struct tle_db *tle_db)
+multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, struct tle_db *tle_db, struct pass_cache *pass_cache, int num_threads)
 {
 	multitrack_listing_t *listing = (multitrack_listing_t*)malloc(sizeof(multitrack_listing_t));
 
@@ -316,9 +460,28 @@ multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, st
 	listing->num_entries = 0;
 	listing->entries = NULL;
 	listing->tle_db_mapping = NULL;
-	listing->sorted_index = NULL;
+	listing->order = NULL;
+	listing->outdated_order_entries = NULL;
+	listing->num_outdated_order_entries = 0;
+	listing->search_index = NULL;
+	listing->search_field = NULL;
+	listing->sgp4_batch = NULL;
+	listing->orbits = NULL;
+	listing->observations = NULL;
+	listing->update_schedule = NULL;
+	listing->due_entries = NULL;
+	listing->num_due_entries = 0;
+	listing->last_update_time = 0;
+	listing->num_updates = 0;
+	listing->num_propagations = 0;
+	listing->num_saved_propagations = 0;
+	listing->selected_entry_index = 0;
+	listing->top_index = 0;
+	listing->not_displayed = true;
+	multitrack_reset_category_counts(listing);
 
 	listing->qth = observer;
+	listing->pass_cache = pass_cache;
 
 	listing->sort_option = SORT_BY_AOS;
 	listing->max_elevation_threshold = 0;
@@ -334,6 +497,15 @@ multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, st
 
 	listing->terminal_height = LINES;
 	listing->terminal_width = LINES;
+
+	//worker threads for updating the listing data. The listing is updated serially in the UI thread when only one thread is to be used
+	if (num_threads <= 0) {
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	listing->thread_pool = NULL;
+	if (num_threads > 1) {
+		listing->thread_pool = thread_pool_create(num_threads);
+	}
 	return listing;
 }
 
@@ -345,27 +517,42 @@ void multitrack_search_listing(multitrack_listing_t *listing)
 		free(expression);
 		return;
 	}
-	for (int i=0; i < listing->num_entries; i++) {
-		if (strstr(listing->entries[listing->sorted_index[i]]->name, expression) != NULL) {
-			multitrack_search_field_add_match(listing->search_field, i);
-		}
+	int num_matches = 0;
+	const int *matches = search_index_search(listing->search_index, expression, &num_matches);
+	for (int i=0; i < num_matches; i++) {
+		multitrack_search_field_add_match(listing->search_field, matches[i]);
 	}
-	multitrack_listing_next_match(listing);
+	multitrack_listing_jump_to_match(listing, listing->selected_entry_index);
 	free(expression);
 }
 
-void multitrack_listing_next_match(multitrack_listing_t *listing)
+void multitrack_listing_jump_to_match(multitrack_listing_t *listing, int start_index)
 {
 	multitrack_search_field_t *search_field = listing->search_field;
-	if (search_field->num_matches > 0) {
-		search_field->match_num = (search_field->match_num + 1) % (search_field->num_matches);
-		listing->selected_entry_index = search_field->matches[search_field->match_num];
+	if (search_field->num_matches == 0) {
+		return;
+	}
+
+	//find the match with the shortest distance downwards from the start index, wrapping around at the end of the listing
+	int best_distance = listing->num_entries;
+	for (int i=0; i < search_field->num_matches; i++) {
+		int position = order_tree_position(listing->order, search_field->matches[i]);
+		int distance = (position - start_index + listing->num_entries) % listing->num_entries;
+		if (distance < best_distance) {
+			best_distance = distance;
+			search_field->match_num = i;
+			listing->selected_entry_index = position;
+		}
 	}
 }
 
+void multitrack_listing_next_match(multitrack_listing_t *listing)
+{
+	multitrack_listing_jump_to_match(listing, listing->selected_entry_index + 1);
+}
+
 void multitrack_free_entry(multitrack_entry_t **entry)
 {
-	predict_destroy_orbital_elements((*entry)->orbital_elements);
 	free((*entry)->name);
 	free(*entry);
 	*entry = NULL;
@@ -384,18 +571,73 @@ void multitrack_free_entries(multitrack_listing_t *listing)
 		free(listing->tle_db_mapping);
 		listing->tle_db_mapping = NULL;
 	}
-	if (listing->sorted_index != NULL) {
-		free(listing->sorted_index);
-		listing->sorted_index = NULL;
-	}
+	order_tree_destroy(&(listing->order));
+	free(listing->outdated_order_entries);
+	listing->outdated_order_entries = NULL;
+	listing->num_outdated_order_entries = 0;
+	search_index_destroy(&(listing->search_index));
+	sgp4_batch_destroy(&(listing->sgp4_batch));
+	free(listing->orbits);
+	listing->orbits = NULL;
+	free(listing->observations);
+	listing->observations = NULL;
+	update_schedule_destroy(&(listing->update_schedule));
+	free(listing->due_entries);
+	listing->due_entries = NULL;
+	listing->num_due_entries = 0;
 	listing->num_entries = 0;
 }
 
+/**
+ * Create batch propagation of the orbital elements of the listing entries.
+ *
+ * \param listing Satellite listing
+ **/
+void multitrack_create_sgp4_batch(multitrack_listing_t *listing)
+{
+	predict_orbital_elements_t **elements = (predict_orbital_elements_t**)malloc(sizeof(predict_orbital_elements_t*)*(listing->num_entries + 1));
+	for (int i=0; i < listing->num_entries; i++) {
+		elements[i] = listing->entries[i]->orbital_elements;
+	}
+	listing->sgp4_batch = sgp4_batch_create(listing->num_entries, elements);
+	free(elements);
+}
+
+/**
+ * Update entry after its TLE has been overwritten, and force new AOS/LOS predictions.
+ *
+ * \param entry Satellite entry
+ * \param tle_db TLE database
+ * \param tle_index Index of the entry in the TLE database
+ **/
+void multitrack_entry_update_tle(multitrack_entry_t *entry, struct tle_db *tle_db, int tle_index)
+{
+	entry->orbital_elements = tle_db_entry_to_orbital_elements(tle_db, tle_index);
+	free(entry->name);
+	entry->name = strdup(tle_db_entry_name(tle_db, tle_index));
+	strncpy(entry->line1, tle_db->tles[tle_index].line1, TLE_LINE_LENGTH+1);
+	strncpy(entry->line2, tle_db->tles[tle_index].line2, TLE_LINE_LENGTH+1);
+
+	//force new AOS/LOS predictions
+	entry->next_aos = 0;
+	entry->next_los = 0;
+}
+
 void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_db)
 {
 	werase(listing->window);
-	listing->not_displayed = true;
-	multitrack_free_entries(listing);
+
+	//map TLE indices to the current entries
+	int *old_entry_indices = (int*)malloc(sizeof(int)*(tle_db->num_tles + 1));
+	for (int i=0; i < tle_db->num_tles; i++) {
+		old_entry_indices[i] = -1;
+	}
+	for (int i=0; i < listing->num_entries; i++) {
+		int tle_index = listing->tle_db_mapping[i];
+		if (tle_index < tle_db->num_tles) {
+			old_entry_indices[tle_index] = i;
+		}
+	}
 
 	int num_enabled_tles = 0;
 	for (int i=0; i < tle_db->num_tles; i++) {
@@ -404,33 +646,149 @@ void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_d
 		}
 	}
 
-	listing->num_entries = num_enabled_tles;
+	//keep the entries of satellites that are still enabled, along with their predicted passes and update times,
+	//and create entries only for newly enabled satellites
+	multitrack_entry_t **entries = (multitrack_entry_t**)malloc(sizeof(multitrack_entry_t*)*(num_enabled_tles + 1));
+	int *tle_db_mapping = (int*)malloc(sizeof(int)*(num_enabled_tles + 1));
+	int *new_entry_indices = (int*)malloc(sizeof(int)*(listing->num_entries + 1));
+	for (int i=0; i < listing->num_entries; i++) {
+		new_entry_indices[i] = -1;
+	}
+	struct update_schedule *update_schedule = update_schedule_create(num_enabled_tles);
+	int num_entries = 0;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (!tle_db_entry_enabled(tle_db, i)) {
+			continue;
+		}
 
-	if (listing->num_entries > 0) {
-		listing->entries = (multitrack_entry_t**)malloc(sizeof(multitrack_entry_t*)*num_enabled_tles);
-		listing->tle_db_mapping = (int*)calloc(num_enabled_tles, sizeof(int));
-		listing->sorted_index = (int*)calloc(tle_db->num_tles, sizeof(int));
-
-		int j=0;
-		for (int i=0; i < tle_db->num_tles; i++) {
-			if (tle_db_entry_enabled(tle_db, i)) {
-				predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, i);
-				listing->entries[j] = multitrack_create_entry(tle_db_entry_name(tle_db, i), orbital_elements);
-				listing->tle_db_mapping[j] = i;
-				listing->sorted_index[j] = j;
-				j++;
+		int old_index = old_entry_indices[i];
+		if (old_index >= 0) {
+			//the orbital elements may have been freed and parsed again at the same address, compare the TLE itself
+			multitrack_entry_t *entry = listing->entries[old_index];
+			const struct tle_db_entry *tle = &(tle_db->tles[i]);
+			if ((strcmp(entry->line1, tle->line1) != 0) || (strcmp(entry->line2, tle->line2) != 0)) {
+				multitrack_entry_update_tle(entry, tle_db, i);
+			} else {
+				entry->orbital_elements = tle_db_entry_to_orbital_elements(tle_db, i);
+				update_schedule_set(update_schedule, num_entries, listing->update_schedule->update_times[old_index]);
 			}
+			entries[num_entries] = entry;
+			new_entry_indices[old_index] = num_entries;
+		} else {
+			entries[num_entries] = multitrack_create_entry(tle_db, i);
+		}
+		tle_db_mapping[num_entries] = i;
+		num_entries++;
+	}
+	free(old_entry_indices);
+
+	//find the selected satellite, or the satellite before it if it is disabled
+	int selected_entry = -1;
+	for (int i=listing->selected_entry_index; (i >= 0) && (i < listing->num_entries); i--) {
+		int new_index = new_entry_indices[order_tree_item_at(listing->order, i)];
+		if (new_index >= 0) {
+			selected_entry = new_index;
+			break;
 		}
 	}
 
-	listing->selected_entry_index = 0;
-	listing->top_index = 0;
+	//free entries of disabled satellites
+	for (int i=0; i < listing->num_entries; i++) {
+		if (new_entry_indices[i] < 0) {
+			multitrack_free_entry(&(listing->entries[i]));
+		}
+	}
+	free(new_entry_indices);
+	free(listing->entries);
+	free(listing->tle_db_mapping);
+	update_schedule_destroy(&(listing->update_schedule));
+
+	listing->num_entries = num_entries;
+	listing->entries = entries;
+	listing->tle_db_mapping = tle_db_mapping;
+	listing->update_schedule = update_schedule;
+
+	//order all entries according to their current status
+	order_tree_destroy(&(listing->order));
+	listing->order = order_tree_create(num_entries);
+	free(listing->outdated_order_entries);
+	listing->outdated_order_entries = (int*)malloc(sizeof(int)*(num_entries + 1));
+	listing->num_outdated_order_entries = 0;
+	multitrack_reset_category_counts(listing);
+	for (int i=0; i < num_entries; i++) {
+		entries[i]->category = -1;
+		entries[i]->order_outdated = false;
+		multitrack_mark_order_outdated(listing, i);
+	}
+	multitrack_sort_listing(listing);
 
-	listing->num_above_horizon = 0;
-	listing->num_below_horizon = 0;
-	listing->num_decayed = 0;
-	listing->num_nevervisible = 0;
+	//index the entries for the search field. Matches refer to entry indices, which have changed
+	search_index_destroy(&(listing->search_index));
+	listing->search_index = search_index_create(num_entries);
+	for (int i=0; i < num_entries; i++) {
+		multitrack_index_entry(listing, i, tle_db, tle_db_mapping[i]);
+	}
+	if (listing->search_field != NULL) {
+		multitrack_search_field_clear_matches(listing->search_field);
+	}
+
+	//per-update arrays, resized to the new number of entries
+	free(listing->orbits);
+	listing->orbits = (struct predict_position*)calloc(num_entries + 1, sizeof(struct predict_position));
+	free(listing->observations);
+	listing->observations = (struct predict_observation*)calloc(num_entries + 1, sizeof(struct predict_observation));
+	free(listing->due_entries);
+	listing->due_entries = (int*)malloc(sizeof(int)*(num_entries + 1));
+	listing->num_due_entries = 0;
+	sgp4_batch_destroy(&(listing->sgp4_batch));
+	multitrack_create_sgp4_batch(listing);
+
+	//keep the selection on the same satellite, or the satellite before it if it was disabled
+	listing->selected_entry_index = (selected_entry >= 0) ? order_tree_position(listing->order, selected_entry) : 0;
+	listing->top_index = 0;
 	multitrack_resize(listing);
+	if (listing->selected_entry_index > listing->bottom_index) {
+		int diff = listing->selected_entry_index - listing->bottom_index;
+		listing->bottom_index += diff;
+		listing->top_index += diff;
+	}
+}
+
+void multitrack_index_entry(multitrack_listing_t *listing, int entry_index, const struct tle_db *tle_db, int tle_index)
+{
+	//international designator, columns 10-17 of TLE line 1
+	const char *line1 = tle_db->tles[tle_index].line1;
+	char designator[9] = {0};
+	if (strlen(line1) > 9) {
+		strncpy(designator, line1 + 9, 8);
+		trim_whitespaces_from_end(designator);
+	}
+	search_index_set_item(listing->search_index, entry_index, tle_db_entry_name(tle_db, tle_index), tle_db->tles[tle_index].satellite_number, designator);
+}
+
+void multitrack_refresh_updated_tles(multitrack_listing_t *listing, struct tle_db *tle_db, const bool *updated_tles)
+{
+	for (int i=0; i < listing->num_entries; i++) {
+		int tle_index = listing->tle_db_mapping[i];
+		if (updated_tles[tle_index]) {
+			multitrack_entry_update_tle(listing->entries[i], tle_db, tle_index);
+			multitrack_index_entry(listing, i, tle_db, tle_index);
+			update_schedule_set(listing->update_schedule, i, -INFINITY);
+		}
+	}
+
+	//orbital elements of the updated entries have been replaced
+	sgp4_batch_destroy(&(listing->sgp4_batch));
+	multitrack_create_sgp4_batch(listing);
+}
+
+void multitrack_refresh_passes(multitrack_listing_t *listing)
+{
+	for (int i=0; i < listing->num_entries; i++) {
+		listing->entries[i]->next_aos = 0;
+		listing->entries[i]->next_los = 0;
+	}
+	update_schedule_reset(listing->update_schedule);
 }
 
 NCURSES_ATTR_T multitrack_colors(double range, double elevation)
@@ -462,20 +820,139 @@ NCURSES_ATTR_T multitrack_colors(double range, double elevation)
 #define SATELLITE_CLOSE_COLOR COLOR_PAIR(2)
 #define SATELLITE_FAR_COLOR COLOR_PAIR(4)
 #define SATELLITE_IGNORED_COLOR COLOR_PAIR(3)
+#define SATELLITE_PENDING_COLOR COLOR_PAIR(1)
+
+void multitrack_entry_orbit(multitrack_listing_t *listing, int entry_index, predict_julian_date_t time, struct predict_position *orbit)
+{
+	if (!sgp4_batch_orbit(listing->sgp4_batch, entry_index, orbit)) {
+		predict_orbit(listing->entries[entry_index]->orbital_elements, orbit, time);
+	}
+}
+
+void multitrack_observe_entries(multitrack_listing_t *listing, const struct ephemeris_context *context, int start, int end)
+{
+	sgp4_batch_propagate(listing->sgp4_batch, start, end);
+	for (int i=start; i < end; i++) {
+		multitrack_entry_orbit(listing, i, context->time, &(listing->orbits[i]));
+	}
+	ephemeris_context_observe_orbits(context, end - start, listing->orbits + start, listing->observations + start);
+}
+
+void multitrack_observe_due_entries(multitrack_listing_t *listing, const struct ephemeris_context *context, int start, int end)
+{
+	int i = start;
+	while (i < end) {
+		//find run of consecutive entries
+		int run_start = listing->due_entries[i];
+		int run_end = run_start + 1;
+		i++;
+		while ((i < end) && (listing->due_entries[i] == run_end)) {
+			run_end++;
+			i++;
+		}
+		multitrack_observe_entries(listing, context, run_start, run_end);
+	}
+}
+
+predict_julian_date_t multitrack_entry_next_update(const multitrack_entry_t *entry, predict_julian_date_t time)
+{
+	if (entry->decayed) {
+		return INFINITY;
+	}
+
+	//poll the pass cache until the pass has been predicted
+	if (entry->pending) {
+		return time;
+	}
+
+	if (entry->geostationary || entry->never_visible) {
+		return time + MULTITRACK_STATIC_UPDATE_INTERVAL;
+	}
+
+	if (entry->above_horizon) {
+		return time;
+	}
+
+	//below horizon, update at the countdown resolution when close to AOS
+	predict_julian_date_t countdown_start = entry->next_aos - MULTITRACK_AOS_COUNTDOWN;
+	if (time >= countdown_start) {
+		return time;
+	}
+	return fmin(time + MULTITRACK_FAR_UPDATE_INTERVAL, countdown_start);
+}
 
-bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, predict_julian_date_t time)
+bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, multitrack_entry_t *entry, const struct predict_position *orbit, const struct predict_observation *obs)
 {
-	entry->geostationary = false;
+	predict_julian_date_t time = orbit->time;
+	bool can_predict = !predict_is_geosynchronous(entry->orbital_elements) && predict_aos_happens(entry->orbital_elements, qth->latitude) && !(orbit->decayed);
+	entry->geostationary = (obs->elevation >= 0) && predict_is_geosynchronous(entry->orbital_elements);
+	entry->above_max_elevation_threshold = (entry->max_elevation > max_elevation_threshold);
 
-	struct predict_observation obs;
-	struct predict_position orbit;
-	predict_orbit(entry->orbital_elements, &orbit, time);
-	predict_observe_orbit(qth, &orbit, &obs);
+	//predict next aos/los and maximum elevation. Entries stay pending until the pass has been predicted in the background.
+	bool was_pending = entry->pending;
+	entry->pending = false;
+	bool calculate_next_los = can_predict && (time > entry->next_los) && (obs->elevation > 0);
+	bool calculate_next_aos = can_predict && (time > entry->next_aos) && (obs->elevation < 0);
+	if (calculate_next_aos || calculate_next_los) {
+		struct pass_cache_pass pass;
+		if (pass_cache_try_current_pass(pass_cache, tle_index, qth, entry->orbital_elements, time, &pass)) {
+			entry->max_elevation = pass.max_elevation*180.0/M_PI;
+			if (calculate_next_los) {
+				entry->next_los = pass.los_time;
+			}
+			if (calculate_next_aos) {
+				entry->next_aos = pass.aos_time;
+			}
+		} else {
+			entry->pending = true;
+		}
+	}
+
+	//use current elevation as max elevation if satellite is above horizon and geostationary
+	if (entry->geostationary && obs->elevation > 0) {
+	       entry->max_elevation = obs->elevation*180.0/M_PI;
+	}
+
+	//keep the state needed for formatting the display string, which is done only when the entry is displayed
+	entry->update_time = time;
+	entry->azimuth = obs->azimuth;
+	entry->elevation = obs->elevation;
+	entry->range = obs->range;
+	entry->range_rate = obs->range_rate;
+	entry->visible = obs->visible;
+	entry->latitude = orbit->latitude;
+	entry->longitude = orbit->longitude;
+	entry->altitude = orbit->altitude;
+	entry->eclipsed = orbit->eclipsed;
+	entry->can_predict = can_predict;
+	entry->display_string_outdated = true;
+
+	entry->above_horizon = obs->elevation > 0;
+	entry->decayed = orbit->decayed;
+
+	entry->never_visible = !predict_aos_happens(entry->orbital_elements, qth->latitude) || (predict_is_geosynchronous(entry->orbital_elements) && (obs->elevation <= 0.0));
+	return ((calculate_next_aos || calculate_next_los) && !entry->pending) || (entry->pending != was_pending);
+}
+
+void multitrack_format_entry(multitrack_entry_t *entry)
+{
+	if (!entry->display_string_outdated) {
+		return;
+	}
+	entry->display_string_outdated = false;
+	predict_julian_date_t time = entry->update_time;
+
+	//overwrite everything if orbit was decayed
+	if (entry->decayed) {
+		entry->display_attributes = COLOR_PAIR(2);
+		snprintf(entry->display_string, MAX_NUM_CHARS, " %-10.8s ----------------     Decayed       --------------- ", entry->name);
+		return;
+	}
 
 	//sun status
 	char sunstat;
-	if (!orbit.eclipsed) {
-		if (obs.visible) {
+	if (!entry->eclipsed) {
+		if (entry->visible) {
 			sunstat='V';
 		} else {
 			sunstat='D';
@@ -485,27 +962,28 @@ bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t
 	}
 
 	//satellite approaching status
-	char rangestat;
-	if (fabs(obs.range_rate) < 0.1) {
+	char rangestat = ' ';
+	if (fabs(entry->range_rate) < 0.1) {
 		rangestat = '=';
-	} else if (obs.range_rate < 0.0) {
+	} else if (entry->range_rate < 0.0) {
 		rangestat = '/';
-	} else if (obs.range_rate > 0.0) {
+	} else if (entry->range_rate > 0.0) {
 		rangestat = '\\';
 	}
 
 	//set text formatting attributes according to satellite state, set AOS/LOS string
-	bool can_predict = !predict_is_geosynchronous(entry->orbital_elements) && predict_aos_happens(entry->orbital_elements, qth->latitude) && !(orbit.decayed);
 	char pass_info[MAX_NUM_CHARS] = {0};
 	char aos_los[MAX_NUM_CHARS] = {0};
 
-	if (obs.elevation >= 0) {
+	if (entry->pending) {
+		entry->display_attributes = SATELLITE_PENDING_COLOR;
+		sprintf(aos_los, "Pending");
+	} else if (entry->elevation >= 0) {
 		//different colours according to range and elevation
-		entry->display_attributes = multitrack_colors(obs.range, obs.elevation*180/M_PI);
+		entry->display_attributes = multitrack_colors(entry->range, entry->elevation*180/M_PI);
 
-		if (predict_is_geosynchronous(entry->orbital_elements)){
+		if (entry->geostationary) {
 			sprintf(aos_los, "*GeoS*");
-			entry->geostationary = true;
 		} else {
 			time_t epoch = predict_from_julian(entry->next_los - time);
 			struct tm timeval;
@@ -520,177 +998,119 @@ bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t
 			}
 
 		}
-	} else if ((obs.elevation < 0) && can_predict) {
-		if ((entry->next_aos-time) < 0.00694) {
+	} else if ((entry->elevation < 0) && entry->can_predict) {
+		if ((entry->next_aos-time) < MULTITRACK_AOS_COUNTDOWN) {
 			//satellite is close, set bold
 			entry->display_attributes = SATELLITE_CLOSE_COLOR;
 			time_t epoch = predict_from_julian(entry->next_aos - time);
-			strftime(aos_los, MAX_NUM_CHARS, "%M:%S", gmtime(&epoch)); //minutes and seconds left until AOS
+			struct tm timeval;
+			gmtime_r(&epoch, &timeval);
+			strftime(aos_los, MAX_NUM_CHARS, "%M:%S", &timeval); //minutes and seconds left until AOS
 		} else {
 			//satellite is far, set normal coloring
 			entry->display_attributes = SATELLITE_FAR_COLOR;
-			time_t aoslos_epoch = predict_from_julian(entry->next_aos);
-			time_t curr_epoch = predict_from_julian(time);
-			struct tm aostime, currtime;
-			gmtime_r(&aoslos_epoch, &aostime);
-			gmtime_r(&curr_epoch, &currtime);
-			char temp[MAX_NUM_CHARS];
-			strftime(temp, MAX_NUM_CHARS, "%H:%MZ", &aostime);
 			int num_days = entry->next_aos - time;
 			if (num_days == 0) {
-				strncpy(aos_los, temp, MAX_NUM_CHARS);
+				time_t aoslos_epoch = predict_from_julian(entry->next_aos);
+				struct tm aostime;
+				gmtime_r(&aoslos_epoch, &aostime);
+				strftime(aos_los, MAX_NUM_CHARS, "%H:%MZ", &aostime);
 			} else {
 				snprintf(aos_los, MAX_NUM_CHARS, ">%2.dd", num_days);
 			}
 		}
-	} else if (!can_predict) {
+	} else if (!entry->can_predict) {
 		entry->display_attributes = SATELLITE_IGNORED_COLOR;
 		sprintf(aos_los, "*GeoS-NoAOS*");
 	}
 
-	entry->above_max_elevation_threshold = (entry->max_elevation > max_elevation_threshold);
-	if (!entry->above_max_elevation_threshold) {
+	if (!entry->above_max_elevation_threshold && !entry->pending) {
 		entry->display_attributes = SATELLITE_IGNORED_COLOR;
 	}
 
 	char abs_pos_string[MAX_NUM_CHARS] = {0};
-	sprintf(abs_pos_string, "%3.0f  %3.0f", orbit.latitude*180.0/M_PI, orbit.longitude*180.0/M_PI);
-
-	//predict next aos/los and maximum elevation
-	bool calculate_next_los = can_predict && (time > entry->next_los) && (obs.elevation > 0);
-	bool calculate_next_aos = can_predict && (time > entry->next_aos) && (obs.elevation < 0);
-	if (calculate_next_los) {
-		entry->next_los= predict_next_los(qth, entry->orbital_elements, time).time;
-	}
+	snprintf(abs_pos_string, MAX_NUM_CHARS, "%3.0f  %3.0f", entry->latitude*180.0/M_PI, entry->longitude*180.0/M_PI);
 
-	if (calculate_next_aos || calculate_next_los) {
-		struct predict_observation max_elevation_obs = predict_at_max_elevation(qth, entry->orbital_elements, time);
-		entry->max_elevation = max_elevation_obs.elevation*180.0/M_PI;
-	}
-
-	if (calculate_next_aos) {
-		entry->next_aos = predict_next_aos(qth, entry->orbital_elements, time).time;
-	}
-
-	//use current elevation as max elevation if satellite is above horizon and geostationary
-	if (entry->geostationary && obs.elevation > 0) {
-	       entry->max_elevation = obs.elevation*180.0/M_PI;
-	}
-
-	char max_ele_str[MAX_NUM_CHARS] = {0};
-	snprintf(max_ele_str, MAX_NUM_CHARS, "%d", (int)(entry->max_elevation));
-
-	if (can_predict) {
-		snprintf(pass_info, MAX_NUM_CHARS, "%s %6s", max_ele_str, aos_los);
+	if (entry->can_predict && !entry->pending) {
+		snprintf(pass_info, MAX_NUM_CHARS, "%d %6s", (int)(entry->max_elevation), aos_los);
 	} else {
 		snprintf(pass_info, MAX_NUM_CHARS, "%s", aos_los);
 	}
 
-	//altitude and range in km/miles
-	double disp_altitude = orbit.altitude;
-	double disp_range = obs.range;
-
 	//set string to display
-	char disp_string[MAX_NUM_CHARS];
-	sprintf(disp_string, " %-10.8s%5.1f  %5.1f %8s%6.0f %6.0f %c %c %12s ", entry->name, obs.azimuth*180.0/M_PI, obs.elevation*180.0/M_PI, abs_pos_string, disp_altitude, disp_range, sunstat, rangestat, pass_info);
-
-	//overwrite everything if orbit was decayed
-	if (orbit.decayed) {
-		entry->display_attributes = COLOR_PAIR(2);
-		sprintf(disp_string, " %-10.8s ----------------     Decayed       --------------- ", entry->name);
-	}
-
-	memcpy(entry->display_string, disp_string, sizeof(char)*MAX_NUM_CHARS);
-
-	entry->above_horizon = obs.elevation > 0;
-	entry->decayed = orbit.decayed;
-
-	entry->never_visible = !predict_aos_happens(entry->orbital_elements, qth->latitude) || (predict_is_geosynchronous(entry->orbital_elements) && (obs.elevation <= 0.0));
-	return calculate_next_aos || calculate_next_los;
-}
-
-void multitrack_update_listing_data(multitrack_listing_t *listing, predict_julian_date_t time)
-{
-	for (int i=0; i < listing->num_entries; i++) {
-		if (listing->not_displayed) {
-			//display progress information when this is the first time entries are displayed
-			wattrset(listing->window, COLOR_PAIR(1));
-			mvwprintw(listing->window, 0, 1, "Preparing entry %d of %d\n", i, listing->num_entries);
-			wrefresh(listing->window);
-		}
-		multitrack_entry_t *entry = listing->entries[i];
-		bool aoslos_changed = multitrack_update_entry(listing->max_elevation_threshold, listing->qth, entry, time);
-		if (aoslos_changed) {
-			listing->should_sort = true;
-		}
-	}
-
-	if (!listing->not_displayed && !multitrack_option_selector_visible(listing->option_selector) && !multitrack_search_field_visible(listing->search_field) && listing->should_sort) {
-		multitrack_sort_listing(listing); //freeze sorting when option selector is hovering over a satellite
-		listing->should_sort = false;
-	}
-
-	listing->not_displayed = false;
+	snprintf(entry->display_string, MAX_NUM_CHARS, " %-10.8s%5.1f  %5.1f %8s%6.0f %6.0f %c %c %12s ", entry->name, entry->azimuth*180.0/M_PI, entry->elevation*180.0/M_PI, abs_pos_string, entry->altitude, entry->range, sunstat, rangestat, pass_info);
 }
 
 /**
- * Used for sorting according to sort_value using qsort, but retain access to original index.
+ * Data for updating the satellite listing in the worker threads.
  **/
-struct sort_helper {
-	int index;
-	double sort_value;
+struct multitrack_update_task {
+	///Satellite listing
+	multitrack_listing_t *listing;
+	///Ephemeris context at the time at which satellite listing should be calculated
+	const struct ephemeris_context *context;
 };
 
 /**
- * Comparison function for qsort (sort in ascending order).
+ * Update a slice of the satellite listing entries. Run by the worker threads.
+ *
+ * \param data Update task, struct multitrack_update_task
+ * \param slice Slice index
+ * \param num_slices Number of slices
  **/
-int ascending(const void *lvalue, const void *rvalue)
+void multitrack_update_listing_slice(void *data, int slice, int num_slices)
 {
-	return ceil(((struct sort_helper*)lvalue)->sort_value - ((struct sort_helper*)rvalue)->sort_value);
+	struct multitrack_update_task *task = (struct multitrack_update_task*)data;
+	multitrack_listing_t *listing = task->listing;
+
+	int start, end;
+	thread_pool_slice_range(listing->num_due_entries, slice, num_slices, &start, &end);
+	multitrack_observe_due_entries(listing, task->context, start, end);
+	for (int j=start; j < end; j++) {
+		int i = listing->due_entries[j];
+		multitrack_update_entry(listing->max_elevation_threshold, listing->qth, listing->pass_cache, listing->tle_db_mapping[i], listing->entries[i], &(listing->orbits[i]), &(listing->observations[i]));
+	}
 }
 
-/**
- * Comparison function for qsort (sort in descending order).
- **/
-int descending(const void *lvalue, const void *rvalue)
+void multitrack_update_listing_data(multitrack_listing_t *listing, const struct ephemeris_context *context)
 {
-	return ceil(((struct sort_helper*)rvalue)->sort_value - ((struct sort_helper*)lvalue)->sort_value);
-}
+	sgp4_batch_set_context(listing->sgp4_batch, context);
 
-/**
- * Sort entry_mapping according to satellite values and sorting options.
- *
- * \param entries Satellite entries
- * \param num_entries Number of entries in entry_mapping
- * \param entry_mapping Entry mapping, maps indices in entries
- * \param sort_option Sorting option defined in enum sort_options. Currently assumed to be either SORT_BY_AOS (sort by next_aos field in ascending order) or SORT_BY_MAX_ELEVATION (sort by max_elevation in descending order)
- **/
-void sort_satellites(multitrack_entry_t **entries, int num_entries, int *entry_mapping, int sort_option)
-{
-	//prepare array for sorting using stdlib's qsort
-	struct sort_helper *sorting = (struct sort_helper*)malloc(sizeof(struct sort_helper)*num_entries);
-	for (int i=0; i < num_entries; i++) {
-		sorting[i].index = entry_mapping[i];
-		if (sort_option == SORT_BY_MAX_ELEVATION) {
-			sorting[i].sort_value = entries[entry_mapping[i]]->max_elevation;
-		} else if (sort_option == SORT_BY_AOS) {
-			sorting[i].sort_value = entries[entry_mapping[i]]->next_aos;
+	//get entries that are due for update. Everything is due if the clock has gone backwards.
+	if (context->time < listing->last_update_time) {
+		update_schedule_reset(listing->update_schedule);
+	}
+	listing->last_update_time = context->time;
+	listing->num_due_entries = update_schedule_due_items(listing->update_schedule, context->time, listing->due_entries);
+
+	if (listing->thread_pool != NULL) {
+		//update entries in the worker threads
+		struct thread_pool *pool = listing->thread_pool;
+		struct multitrack_update_task task = {.listing = listing, .context = context};
+		thread_pool_run(pool, multitrack_update_listing_slice, &task);
+	} else {
+		multitrack_observe_due_entries(listing, context, 0, listing->num_due_entries);
+		for (int j=0; j < listing->num_due_entries; j++) {
+			int i = listing->due_entries[j];
+			multitrack_update_entry(listing->max_elevation_threshold, listing->qth, listing->pass_cache, listing->tle_db_mapping[i], listing->entries[i], &(listing->orbits[i]), &(listing->observations[i]));
 		}
-
 	}
 
-	if (sort_option == SORT_BY_MAX_ELEVATION) {
-		qsort(sorting, num_entries, sizeof(struct sort_helper), descending);
-	} else if (sort_option == SORT_BY_AOS) {
-		qsort(sorting, num_entries, sizeof(struct sort_helper), ascending);
+	//reschedule the updated entries, and check their order on the next sort
+	for (int j=0; j < listing->num_due_entries; j++) {
+		int i = listing->due_entries[j];
+		update_schedule_set(listing->update_schedule, i, multitrack_entry_next_update(listing->entries[i], context->time));
+		multitrack_mark_order_outdated(listing, i);
 	}
+	listing->num_updates++;
+	listing->num_propagations += listing->num_due_entries;
+	listing->num_saved_propagations += listing->num_entries - listing->num_due_entries;
 
-	//extract results
-	for (int i=0; i < num_entries; i++) {
-		entry_mapping[i] = sorting[i].index;
+	if (!listing->not_displayed && !multitrack_option_selector_visible(listing->option_selector) && !multitrack_search_field_visible(listing->search_field)) {
+		multitrack_sort_listing(listing); //freeze sorting when option selector is hovering over a satellite
 	}
 
-	free(sorting);
+	listing->not_displayed = false;
 }
 
 /**
@@ -699,87 +1119,136 @@ void sort_satellites(multitrack_entry_t **entries, int num_entries, int *entry_m
 
 bool above_horizon(const multitrack_entry_t *entry)
 {
-	return entry->above_horizon && !entry->decayed && entry->above_max_elevation_threshold;
+	return entry->above_horizon && !entry->decayed && entry->above_max_elevation_threshold && !entry->pending;
 }
 
 bool will_rise(const multitrack_entry_t *entry)
 {
-	return !(entry->above_horizon) && !(entry->never_visible) && !(entry->decayed) && entry->above_max_elevation_threshold;
+	return !(entry->above_horizon) && !(entry->never_visible) && !(entry->decayed) && entry->above_max_elevation_threshold && !entry->pending;
 }
 
 bool below_threshold(const multitrack_entry_t *entry)
 {
-	return !entry->never_visible && !entry->above_max_elevation_threshold && !entry->decayed;
+	return !entry->never_visible && !entry->above_max_elevation_threshold && !entry->decayed && !entry->pending;
 }
 
-void multitrack_sort_listing(multitrack_listing_t *listing)
+bool pending(const multitrack_entry_t *entry)
 {
-	int num_orbits = listing->num_entries;
+	return entry->pending && !entry->never_visible && !entry->decayed;
+}
 
-	//those with elevation > 0 at the top
-	int above_horizon_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (above_horizon(listing->entries[i])) {
-			listing->sorted_index[above_horizon_counter] = i;
-			above_horizon_counter++;
-		}
+enum multitrack_category multitrack_entry_category(const multitrack_entry_t *entry)
+{
+	if (above_horizon(entry)) {
+		return MULTITRACK_CATEGORY_ABOVE_HORIZON;
+	} else if (will_rise(entry)) {
+		return MULTITRACK_CATEGORY_BELOW_HORIZON;
+	} else if (below_threshold(entry)) {
+		return MULTITRACK_CATEGORY_BELOW_THRESHOLD;
+	} else if (pending(entry)) {
+		return MULTITRACK_CATEGORY_PENDING;
+	} else if (entry->decayed) {
+		return MULTITRACK_CATEGORY_DECAYED;
 	}
-	listing->num_above_horizon = above_horizon_counter;
+	return MULTITRACK_CATEGORY_NEVER_VISIBLE;
+}
 
-	//satellites that will eventually rise above the horizon
-	int below_horizon_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (will_rise(listing->entries[i])) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter] = i;
-			below_horizon_counter++;
-		}
+/**
+ * Get counter of the number of entries in a category.
+ *
+ * \param listing Satellite listing
+ * \param category Category
+ * \return Pointer to the counter field in the listing
+ **/
+int *multitrack_category_count(multitrack_listing_t *listing, enum multitrack_category category)
+{
+	switch (category) {
+		case MULTITRACK_CATEGORY_ABOVE_HORIZON:
+			return &(listing->num_above_horizon);
+		case MULTITRACK_CATEGORY_BELOW_HORIZON:
+			return &(listing->num_below_horizon);
+		case MULTITRACK_CATEGORY_BELOW_THRESHOLD:
+			return &(listing->num_below_threshold);
+		case MULTITRACK_CATEGORY_PENDING:
+			return &(listing->num_pending);
+		case MULTITRACK_CATEGORY_NEVER_VISIBLE:
+			return &(listing->num_nevervisible);
+		case MULTITRACK_CATEGORY_DECAYED:
+		default:
+			return &(listing->num_decayed);
 	}
-	listing->num_below_horizon = below_horizon_counter;
+}
 
-	//satellites below max elevation threshold
-	int below_threshold_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (below_threshold(listing->entries[i])) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter + below_threshold_counter] = i;
-			below_threshold_counter++;
-		}
-	}
-	listing->num_below_threshold = below_threshold_counter;
-
-	//satellites that will never be visible, with decayed orbits last
-	int nevervisible_counter = 0;
-	int decayed_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (listing->entries[i]->never_visible && !(listing->entries[i]->decayed)) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter + below_threshold_counter + nevervisible_counter] = i;
-			nevervisible_counter++;
-		} else if (listing->entries[i]->decayed) {
-			listing->sorted_index[num_orbits - 1 - decayed_counter] = i;
-			decayed_counter++;
-		}
+void multitrack_reset_category_counts(multitrack_listing_t *listing)
+{
+	listing->num_above_horizon = 0;
+	listing->num_below_horizon = 0;
+	listing->num_below_threshold = 0;
+	listing->num_pending = 0;
+	listing->num_nevervisible = 0;
+	listing->num_decayed = 0;
+}
+
+void multitrack_mark_order_outdated(multitrack_listing_t *listing, int entry_index)
+{
+	multitrack_entry_t *entry = listing->entries[entry_index];
+	if (!entry->order_outdated) {
+		entry->order_outdated = true;
+		listing->outdated_order_entries[listing->num_outdated_order_entries++] = entry_index;
 	}
-	listing->num_nevervisible = nevervisible_counter;
-	listing->num_decayed = decayed_counter;
+}
 
-	if (listing->sort_option == SORT_BY_AOS) {
-		//sort those with nonzero elevation according to max elevation
-		sort_satellites(listing->entries, above_horizon_counter, listing->sorted_index, SORT_BY_MAX_ELEVATION);
+void multitrack_sort_listing(multitrack_listing_t *listing)
+{
+	for (int j=0; j < listing->num_outdated_order_entries; j++) {
+		int i = listing->outdated_order_entries[j];
+		multitrack_entry_t *entry = listing->entries[i];
+		entry->order_outdated = false;
 
-		//sort the rest according to AOS/LOS
-		sort_satellites(listing->entries, below_horizon_counter, listing->sorted_index + above_horizon_counter, SORT_BY_AOS);
-	} else if (listing->sort_option == SORT_BY_MAX_ELEVATION) {
-		//sort all according to max elevation
-		sort_satellites(listing->entries, above_horizon_counter + below_horizon_counter, listing->sorted_index, SORT_BY_MAX_ELEVATION);
-	}
+		enum multitrack_category category = multitrack_entry_category(entry);
+		if ((int)category != entry->category) {
+			if (entry->category >= 0) {
+				(*multitrack_category_count(listing, entry->category))--;
+			}
+			(*multitrack_category_count(listing, category))++;
+			entry->category = category;
+		}
 
-	//sort satellites below threshold according to max elevation
-	sort_satellites(listing->entries, below_threshold_counter, listing->sorted_index + above_horizon_counter + below_horizon_counter, SORT_BY_MAX_ELEVATION);
+		//satellites above the horizon and below the threshold are sorted according to descending max elevation, satellites
+		//below the horizon according to AOS or together with the satellites above the horizon, the rest in TLE database order
+		int group = category;
+		double key = 0;
+		switch (category) {
+			case MULTITRACK_CATEGORY_ABOVE_HORIZON:
+			case MULTITRACK_CATEGORY_BELOW_THRESHOLD:
+				key = -entry->max_elevation;
+				break;
+			case MULTITRACK_CATEGORY_BELOW_HORIZON:
+				if (listing->sort_option == SORT_BY_MAX_ELEVATION) {
+					group = MULTITRACK_CATEGORY_ABOVE_HORIZON;
+					key = -entry->max_elevation;
+				} else {
+					key = entry->next_aos;
+				}
+				break;
+			default:
+				break;
+		}
+		order_tree_set(listing->order, i, group, key);
+	}
+	listing->num_outdated_order_entries = 0;
 }
 
-void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry)
+void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry, bool selected)
 {
-	wattrset(window, entry->display_attributes);
-	mvwprintw(window, row, col, "%s", entry->display_string);
+	multitrack_format_entry(entry);
+	if (selected) {
+		wattrset(window, MULTITRACK_SELECTED_ATTRIBUTE);
+		mvwprintw(window, row, col, "%c%s", MULTITRACK_SELECTED_MARKER, entry->display_string + 1);
+	} else {
+		wattrset(window, entry->display_attributes);
+		mvwprintw(window, row, col, "%s", entry->display_string);
+	}
 }
 
 void multitrack_print_scrollbar(multitrack_listing_t *listing)
@@ -834,15 +1303,12 @@ void multitrack_display_listing(multitrack_listing_t *listing)
 
 	//show entries
 	if (listing->num_entries > 0) {
-		int selected_index = listing->sorted_index[listing->selected_entry_index];
-		listing->entries[selected_index]->display_attributes = MULTITRACK_SELECTED_ATTRIBUTE;
-		listing->entries[selected_index]->display_string[0] = MULTITRACK_SELECTED_MARKER;
-
 		int line = 0;
 		int col = 1;
 
+		//display strings are formatted here, only for the visible entries
 		for (int i=listing->top_index; ((i <= listing->bottom_index) && (i < listing->num_entries)); i++) {
-			multitrack_display_entry(listing->window, line++, col, listing->entries[listing->sorted_index[i]]);
+			multitrack_display_entry(listing->window, line++, col, listing->entries[order_tree_item_at(listing->order, i)], i == listing->selected_entry_index);
 		}
 
 		if (listing->num_entries > listing->displayed_entries_per_page) {
@@ -972,7 +1438,7 @@ bool multitrack_handle_listing(multitrack_listing_t *listing, int input_key)
 
 int multitrack_selected_entry(multitrack_listing_t *listing)
 {
-	int index = listing->sorted_index[listing->selected_entry_index];
+	int index = order_tree_item_at(listing->order, listing->selected_entry_index);
 	return listing->tle_db_mapping[index];
 }
 
@@ -988,6 +1454,7 @@ void multitrack_destroy_listing(multitrack_listing_t **listing)
 	multitrack_search_field_destroy(&((*listing)->search_field));
 	delwin((*listing)->header_window);
 	delwin((*listing)->window);
+	thread_pool_destroy(&((*listing)->thread_pool));
 	free(*listing);
 	*listing = NULL;
 }
@@ -1780,8 +2247,8 @@ void multitrack_edit_settings(multitrack_listing_t *listing)
 	//write settings to file
 	multitrack_settings_to_file(listing);
 
-	//trigger resort
-	listing->should_sort = true;
+	//update all entries, since the display attributes and the order depend on the settings
+	update_schedule_reset(listing->update_schedule);
 }
 
 #include "xdg_basedirs.h"
@@ -4,6 +4,7 @@
 #include "ncurses.h"
 #include "form.h"
 #include "menu.h"
+#include "tle_db.h"
 
 //Width of multitrack window
 #define MULTITRACK_WINDOW_WIDTH 67
@@ -26,8 +27,12 @@ enum sort_options{SORT_BY_AOS, SORT_BY_MAX_ELEVATION};
 typedef struct {
 	///Satellite name
 	char *name;
-	///Orbital elements for satellite
+	///Orbital elements for satellite, owned by the TLE database (see tle_db_entry_to_orbital_elements())
 	predict_orbital_elements_t *orbital_elements;
+	///Line 1 of the TLE the orbital elements were parsed from, for detecting changed TLEs
+	char line1[TLE_LINE_LENGTH+1];
+	///Line 2 of the TLE the orbital elements were parsed from
+	char line2[TLE_LINE_LENGTH+1];
 	///Time for next AOS
 	double next_aos;
 	///Time for next LOS
@@ -44,7 +49,37 @@ typedef struct {
 	bool above_max_elevation_threshold;
 	///Whether satellite has decayed
 	bool decayed;
-	///String used for information displaying in the satellite listing
+	///Whether the next AOS/LOS and maximum elevation are still being predicted in the background (see pass_cache_try_current_pass())
+	bool pending;
+	///Category in the sorted listing (see multitrack_entry_category()), -1 before the entry has been sorted
+	int category;
+	///Whether the entry is in the listing's `outdated_order_entries`
+	bool order_outdated;
+	///Whether AOS/LOS can be predicted for the satellite
+	bool can_predict;
+	///Time of the last update
+	predict_julian_date_t update_time;
+	///Azimuth at the last update, in radians
+	double azimuth;
+	///Elevation at the last update, in radians
+	double elevation;
+	///Range at the last update, in km
+	double range;
+	///Range rate at the last update, in km/s
+	double range_rate;
+	///Whether satellite was visible at the last update
+	bool visible;
+	///Sub-satellite latitude at the last update, in radians
+	double latitude;
+	///Sub-satellite longitude at the last update, in radians
+	double longitude;
+	///Altitude at the last update, in km
+	double altitude;
+	///Whether satellite was eclipsed at the last update
+	bool eclipsed;
+	///Whether the display string has to be formatted from the fields above before it is displayed
+	bool display_string_outdated;
+	///String used for information displaying in the satellite listing, formatted only for displayed entries (see multitrack_format_entry())
 	char display_string[MAX_NUM_CHARS];
 	///Formatting attributes (input to wattrset())
 	int display_attributes;
@@ -96,7 +131,7 @@ typedef struct {
 	int attributes;
 	///Current match number state (used for jumping through the matches)
 	int match_num;
-	///List of match indices in the sorted index array
+	///List of matching entries, as indices in the listing's `entries`-array so that they stay valid when the listing is re-sorted
 	int *matches;
 	///Number of matches
 	int num_matches;
@@ -115,8 +150,12 @@ typedef struct {
 	int num_entries;
 	///Displayed satellites
 	multitrack_entry_t **entries;
-	///Index mapping from index corresponding to displayed entry in menu to index in `entries`-array
-	int *sorted_index;
+	///Order of the displayed entries in menu, mapping from index corresponding to displayed entry to index in `entries`-array (see order_tree_item_at())
+	struct order_tree *order;
+	///Entries that have to be checked for changed positions in `order` on the next sort, see multitrack_mark_order_outdated()
+	int *outdated_order_entries;
+	///Number of entries in `outdated_order_entries`
+	int num_outdated_order_entries;
 	///Currently selected index in menu
 	int selected_entry_index;
 	///Satellite displayed on top of scrolled view
@@ -136,12 +175,16 @@ typedef struct {
 	WINDOW *header_window;
 	///QTH coordinates
 	predict_observer_t *qth;
+	///Cache of upcoming passes, not owned by the listing
+	struct pass_cache *pass_cache;
 	///Current number of satellites above horizon (displayed on top, first part of sorted mapping)
 	int num_above_horizon;
 	///Current number of satellites below the horizon (but will eventually rise) (displayed next, next part of sorted mapping)
 	int num_below_horizon;
 	///Number of satellites below max elevation threshold
 	int num_below_threshold;
+	///Number of satellites waiting for their next pass to be predicted
+	int num_pending;
 	///Number of satellites that will never be visible from the current QTH
 	int num_nevervisible;
 	///Number of decayed satellites (last part of menu listing, last part of sorted mapping)
@@ -152,6 +195,8 @@ typedef struct {
 	multitrack_option_selector_t *option_selector;
 	///Search field
 	multitrack_search_field_t *search_field;
+	///Search index over the names, satellite numbers and international designators of the entries, used by the search field
+	struct search_index *search_index;
 	///Current terminal height
 	int terminal_height;
 	///Current terminal width
@@ -160,8 +205,28 @@ typedef struct {
 	int sort_option;
 	///Max elevation threshold in degrees
 	double max_elevation_threshold;
-	///Whether listing should be sorted in multitrack_update_listing_data().
-	bool should_sort;
+	///Worker threads used for updating the listing entries, NULL if entries are updated in the UI thread
+	struct thread_pool *thread_pool;
+	///Batch propagation of the near-earth entries, rebuilt when the orbital elements of the entries change
+	struct sgp4_batch *sgp4_batch;
+	///Orbits of the entries at the last update, one for each entry
+	struct predict_position *orbits;
+	///Observations of the entries at the last update, one for each entry
+	struct predict_observation *observations;
+	///Schedule of the time at which each entry next has to be updated
+	struct update_schedule *update_schedule;
+	///Indices of the entries that are updated in the current update, in increasing order
+	int *due_entries;
+	///Number of entries in `due_entries`
+	int num_due_entries;
+	///Time of the last update
+	predict_julian_date_t last_update_time;
+	///Number of listing updates
+	unsigned long num_updates;
+	///Total number of entry propagations over all listing updates
+	unsigned long num_propagations;
+	///Total number of entry propagations saved by the update schedule over all listing updates
+	unsigned long num_saved_propagations;
 } multitrack_listing_t;
 
 /**
@@ -169,12 +234,17 @@ typedef struct {
  *
  * \param observer QTH coordinates
  * \param tle_db TLE database
+ * \param pass_cache Cache of upcoming passes, used for the next AOS/LOS and maximum elevation of the entries. Has to be kept up to date with the QTH and the TLE database by the caller
+ * \param num_threads Number of worker threads used for updating the listing, 0 for the number of online CPUs and 1 for updating the listing in the calling thread
  * \return Multitrack satellite listing
  **/
-multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, struct tle_db *tle_db);
+multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, struct tle_db *tle_db, struct pass_cache *pass_cache, int num_threads);
 
 /**
  * Update satellite listing according to the `enabled`-flag within the TLE database (i.e. hide satellites that are disabled, show satellites that are enabled).
+ * Has to be called after TLE entries have been overwritten, since the listing refers to the orbital elements cached within the TLE database.
+ * Entries of satellites that stay enabled are kept along with their predicted passes, unless their TLE has been overwritten,
+ * and entries are created and freed only for satellites that have been enabled or disabled.
  *
  * \param listing Multitrack satellite listing
  * \param tle_db TLE database
@@ -182,12 +252,34 @@ multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, st
 void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_db);
 
 /**
- * Update satellite listing data.
+ * Update listing entries corresponding to TLE entries that have been overwritten in place, without rebuilding the
+ * listing. The next AOS/LOS and maximum elevation of updated entries are recalculated on the next update.
+ *
+ * \param listing Multitrack satellite listing
+ * \param tle_db TLE database
+ * \param updated_tles Array of tle_db->num_tles length, true for entries that have been updated
+ **/
+void multitrack_refresh_updated_tles(multitrack_listing_t *listing, struct tle_db *tle_db, const bool *updated_tles);
+
+/**
+ * Force new AOS/LOS and maximum elevation predictions for all entries on the next update. Has to be called after the
+ * QTH has been changed.
+ *
+ * \param listing Multitrack satellite listing
+ **/
+void multitrack_refresh_passes(multitrack_listing_t *listing);
+
+/**
+ * Update satellite listing data. Entries are updated in slices across the worker threads, if any, and the
+ * results are identical to updating them serially. Near-earth satellites are propagated using the batch
+ * propagation in `sgp4_batch`, deep-space satellites using predict_orbit(). All satellites are observed using
+ * the shared ephemeris context. Only entries that are due according to `update_schedule` are updated, the others
+ * keep their previous status.
  *
  * \param listing Multitrack satellite listing
- * \param time Time at which satellite listing should be calculated
+ * \param context Ephemeris context at the time at which satellite listing should be calculated, for the QTH of the listing
  **/
-void multitrack_update_listing_data(multitrack_listing_t *listing, predict_julian_date_t time);
+void multitrack_update_listing_data(multitrack_listing_t *listing, const struct ephemeris_context *context);
 
 /**
  * Print satellite listing and refresh associated windows.
@@ -0,0 +1,233 @@
+#include "order_tree.h"
+#include <stdlib.h>
+
+/**
+ * Compare the order of two items.
+ *
+ * \param tree Order tree
+ * \param item_1 First item
+ * \param item_2 Second item
+ * \return Negative if item_1 is ordered before item_2, positive if after, 0 if the items are the same
+ **/
+int order_tree_compare(const struct order_tree *tree, int item_1, int item_2)
+{
+	if (tree->groups[item_1] != tree->groups[item_2]) {
+		return (tree->groups[item_1] < tree->groups[item_2]) ? -1 : 1;
+	}
+	if (tree->keys[item_1] != tree->keys[item_2]) {
+		return (tree->keys[item_1] < tree->keys[item_2]) ? -1 : 1;
+	}
+	return item_1 - item_2;
+}
+
+/**
+ * Get size of subtree.
+ **/
+static inline int order_tree_subtree_size(const struct order_tree *tree, int node)
+{
+	return (node < 0) ? 0 : tree->size[node];
+}
+
+/**
+ * Recalculate the subtree size of a node from its children.
+ **/
+static inline void order_tree_update_size(struct order_tree *tree, int node)
+{
+	tree->size[node] = 1 + order_tree_subtree_size(tree, tree->left[node]) + order_tree_subtree_size(tree, tree->right[node]);
+}
+
+/**
+ * Split subtree into the items ordered before the given item, and the item itself and the items ordered after it.
+ *
+ * \param tree Order tree
+ * \param node Root of subtree
+ * \param item Item to split at
+ * \param before Returned root of the items ordered before `item`
+ * \param after Returned root of `item` and the items ordered after it
+ **/
+void order_tree_split(struct order_tree *tree, int node, int item, int *before, int *after)
+{
+	if (node < 0) {
+		*before = -1;
+		*after = -1;
+	} else if (order_tree_compare(tree, node, item) < 0) {
+		order_tree_split(tree, tree->right[node], item, &(tree->right[node]), after);
+		*before = node;
+		order_tree_update_size(tree, node);
+	} else {
+		order_tree_split(tree, tree->left[node], item, before, &(tree->left[node]));
+		*after = node;
+		order_tree_update_size(tree, node);
+	}
+}
+
+/**
+ * Merge two subtrees, where all items in the first are ordered before all items in the second.
+ *
+ * \param tree Order tree
+ * \param first Root of first subtree
+ * \param second Root of second subtree
+ * \return Root of merged subtree
+ **/
+int order_tree_merge(struct order_tree *tree, int first, int second)
+{
+	if (first < 0) {
+		return second;
+	}
+	if (second < 0) {
+		return first;
+	}
+	if (tree->priority[first] > tree->priority[second]) {
+		tree->right[first] = order_tree_merge(tree, tree->right[first], second);
+		order_tree_update_size(tree, first);
+		return first;
+	} else {
+		tree->left[second] = order_tree_merge(tree, first, tree->left[second]);
+		order_tree_update_size(tree, second);
+		return second;
+	}
+}
+
+/**
+ * Remove the first item in the order from a subtree.
+ *
+ * \param tree Order tree
+ * \param node Root of subtree, not empty
+ * \return Root of the remaining subtree
+ **/
+int order_tree_remove_first(struct order_tree *tree, int node)
+{
+	if (tree->left[node] < 0) {
+		return tree->right[node];
+	}
+	tree->left[node] = order_tree_remove_first(tree, tree->left[node]);
+	order_tree_update_size(tree, node);
+	return node;
+}
+
+/**
+ * Pseudo-random heap priority of an item, deterministic so that the tree shape is reproducible.
+ **/
+unsigned int order_tree_item_priority(int item)
+{
+	unsigned int hash = item + 0x9e3779b9u;
+	hash = (hash ^ (hash >> 16))*0x85ebca6bu;
+	hash = (hash ^ (hash >> 13))*0xc2b2ae35u;
+	return hash ^ (hash >> 16);
+}
+
+struct order_tree *order_tree_create(int num_items)
+{
+	struct order_tree *tree = (struct order_tree*)malloc(sizeof(struct order_tree));
+	tree->num_items = num_items;
+	tree->root = -1;
+	tree->left = (int*)malloc(sizeof(int)*(num_items + 1));
+	tree->right = (int*)malloc(sizeof(int)*(num_items + 1));
+	tree->size = (int*)malloc(sizeof(int)*(num_items + 1));
+	tree->priority = (unsigned int*)malloc(sizeof(unsigned int)*(num_items + 1));
+	tree->groups = (int*)calloc(num_items + 1, sizeof(int));
+	tree->keys = (double*)calloc(num_items + 1, sizeof(double));
+	tree->in_tree = (bool*)calloc(num_items + 1, sizeof(bool));
+	for (int i=0; i < num_items; i++) {
+		tree->priority[i] = order_tree_item_priority(i);
+	}
+	return tree;
+}
+
+void order_tree_remove(struct order_tree *tree, int item)
+{
+	if (!tree->in_tree[item]) {
+		return;
+	}
+
+	//split out the item, which is the first item in `after`
+	int before, after;
+	order_tree_split(tree, tree->root, item, &before, &after);
+	after = order_tree_remove_first(tree, after);
+	tree->root = order_tree_merge(tree, before, after);
+	tree->in_tree[item] = false;
+}
+
+bool order_tree_set(struct order_tree *tree, int item, int group, double key)
+{
+	if (tree->in_tree[item]) {
+		if ((tree->groups[item] == group) && (tree->keys[item] == key)) {
+			return false;
+		}
+		order_tree_remove(tree, item);
+	}
+
+	tree->groups[item] = group;
+	tree->keys[item] = key;
+	tree->left[item] = -1;
+	tree->right[item] = -1;
+	tree->size[item] = 1;
+	int before, after;
+	order_tree_split(tree, tree->root, item, &before, &after);
+	tree->root = order_tree_merge(tree, order_tree_merge(tree, before, item), after);
+	tree->in_tree[item] = true;
+	return true;
+}
+
+int order_tree_size(const struct order_tree *tree)
+{
+	return order_tree_subtree_size(tree, tree->root);
+}
+
+int order_tree_item_at(const struct order_tree *tree, int position)
+{
+	int node = tree->root;
+	while (node >= 0) {
+		int left_size = order_tree_subtree_size(tree, tree->left[node]);
+		if (position < left_size) {
+			node = tree->left[node];
+		} else if (position == left_size) {
+			return node;
+		} else {
+			position -= left_size + 1;
+			node = tree->right[node];
+		}
+	}
+	return -1;
+}
+
+int order_tree_position(const struct order_tree *tree, int item)
+{
+	if (!tree->in_tree[item]) {
+		return -1;
+	}
+
+	//search for the item using its key, counting the items ordered before it
+	int position = 0;
+	int node = tree->root;
+	while (node >= 0) {
+		int comparison = order_tree_compare(tree, item, node);
+		if (comparison < 0) {
+			node = tree->left[node];
+		} else {
+			position += order_tree_subtree_size(tree, tree->left[node]);
+			if (comparison == 0) {
+				return position;
+			}
+			position++;
+			node = tree->right[node];
+		}
+	}
+	return -1;
+}
+
+void order_tree_destroy(struct order_tree **tree)
+{
+	if (*tree == NULL) {
+		return;
+	}
+	free((*tree)->left);
+	free((*tree)->right);
+	free((*tree)->size);
+	free((*tree)->priority);
+	free((*tree)->groups);
+	free((*tree)->keys);
+	free((*tree)->in_tree);
+	free(*tree);
+	*tree = NULL;
+}
@@ -0,0 +1,99 @@
+#ifndef ORDER_TREE_H_DEFINED
+#define ORDER_TREE_H_DEFINED
+
+#include <stdbool.h>
+
+/**
+ * Ordered set of items keyed by a group and a sort key within the group, supporting lookup of the item at a given
+ * position in the order. Used for keeping the satellite listing sorted incrementally, so that only items with
+ * changed keys have to be moved instead of sorting all items again. Implemented as a treap with subtree sizes, so
+ * that changing the key of an item and looking up positions are O(log n).
+ *
+ * Items are ordered by group, then by key, then by item index. Keys are compared at full precision.
+ **/
+
+/**
+ * Order tree.
+ **/
+struct order_tree {
+	///Number of items that can be stored in the tree
+	int num_items;
+	///Root node, -1 if the tree is empty
+	int root;
+	///Left child of each item, -1 if none
+	int *left;
+	///Right child of each item, -1 if none
+	int *right;
+	///Number of items in the subtree rooted at each item
+	int *size;
+	///Heap priority of each item
+	unsigned int *priority;
+	///Group of each item
+	int *groups;
+	///Sort key of each item
+	double *keys;
+	///Whether each item is in the tree
+	bool *in_tree;
+};
+
+/**
+ * Create empty order tree.
+ *
+ * \param num_items Number of items, indexed from 0 to num_items-1
+ * \return Order tree
+ **/
+struct order_tree *order_tree_create(int num_items);
+
+/**
+ * Insert item into the tree, or move it if its group or key has changed.
+ *
+ * \param tree Order tree
+ * \param item Item index
+ * \param group Group. Lower groups are ordered first
+ * \param key Sort key within the group. Lower keys are ordered first
+ * \return True if the item was inserted or moved, false if it already was in the tree with the same group and key
+ **/
+bool order_tree_set(struct order_tree *tree, int item, int group, double key);
+
+/**
+ * Remove item from the tree.
+ *
+ * \param tree Order tree
+ * \param item Item index
+ **/
+void order_tree_remove(struct order_tree *tree, int item);
+
+/**
+ * Get number of items in the tree.
+ *
+ * \param tree Order tree
+ * \return Number of items
+ **/
+int order_tree_size(const struct order_tree *tree);
+
+/**
+ * Get item at the given position in the order.
+ *
+ * \param tree Order tree
+ * \param position Position, from 0 to order_tree_size()-1
+ * \return Item index, -1 if the position is out of range
+ **/
+int order_tree_item_at(const struct order_tree *tree, int position);
+
+/**
+ * Get position of an item in the order.
+ *
+ * \param tree Order tree
+ * \param item Item index
+ * \return Position, -1 if the item is not in the tree
+ **/
+int order_tree_position(const struct order_tree *tree, int item);
+
+/**
+ * Free order tree.
+ *
+ * \param tree Order tree
+ **/
+void order_tree_destroy(struct order_tree **tree);
+
+#endif
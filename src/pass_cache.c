@@ -0,0 +1,435 @@
+//for SCHED_IDLE
+#define _GNU_SOURCE
+#include "pass_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+//time after a LOS from which the next pass is searched for, in days
+#define PASS_CACHE_LOS_MARGIN (10.0/86400.0)
+
+//interval at which the background thread checks for expired passes when the cache is full, in milliseconds
+#define PASS_CACHE_IDLE_INTERVAL 1000
+
+/**
+ * Predict the current pass of a satellite if it is above the horizon at the given time, and the next pass otherwise.
+ *
+ * \param observer QTH
+ * \param orbital_elements Orbital elements
+ * \param time Time
+ * \param pass Returned pass
+ **/
+void pass_cache_predict_pass(const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass)
+{
+	struct predict_position orbit;
+	struct predict_observation obs;
+	predict_orbit(orbital_elements, &orbit, time);
+	predict_observe_orbit(observer, &orbit, &obs);
+
+	struct predict_observation aos;
+	if (obs.elevation > 0) {
+		aos = obs;
+	} else {
+		aos = predict_next_aos(observer, orbital_elements, time);
+	}
+	struct predict_observation tca = predict_at_max_elevation(observer, orbital_elements, aos.time);
+	struct predict_observation los = predict_next_los(observer, orbital_elements, aos.time);
+
+	pass->aos_time = aos.time;
+	pass->aos_azimuth = aos.azimuth;
+	pass->tca_time = tca.time;
+	pass->tca_azimuth = tca.azimuth;
+	pass->max_elevation = tca.elevation;
+	pass->los_time = los.time;
+	pass->los_azimuth = los.azimuth;
+}
+
+/**
+ * Find an entry that has room for more passes, starting from `next_entry`. Passes that have ended are removed.
+ * Has to be called with the cache lock held.
+ *
+ * \param cache Pass cache
+ * \param time Current time
+ * \return Entry index, -1 if all entries are full
+ **/
+int pass_cache_find_incomplete_entry(struct pass_cache *cache, predict_julian_date_t time)
+{
+	for (int i=0; i < cache->num_entries; i++) {
+		int index = (cache->next_entry + i) % cache->num_entries;
+		struct pass_cache_entry *entry = cache->entries[index];
+		if ((entry == NULL) || !entry->can_predict) {
+			continue;
+		}
+
+		//remove passes that have ended
+		int num_ended = 0;
+		while ((num_ended < entry->num_passes) && (entry->passes[num_ended].los_time < time)) {
+			num_ended++;
+		}
+		if (num_ended > 0) {
+			memmove(entry->passes, entry->passes + num_ended, sizeof(struct pass_cache_pass)*(entry->num_passes - num_ended));
+			entry->num_passes -= num_ended;
+			entry->start_time = time;
+		}
+
+		if (entry->num_passes < PASS_CACHE_NUM_PASSES) {
+			cache->next_entry = (index + 1) % cache->num_entries;
+			return index;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Background thread. Adds one pass at a time to the entries with free room, going through the entries in turn so
+ * that the first pass of all satellites is available before the later passes.
+ *
+ * \param data Pass cache
+ * \return NULL
+ **/
+void *pass_cache_thread(void *data)
+{
+	struct pass_cache *cache = (struct pass_cache*)data;
+
+	//only use the CPU when it is otherwise idle
+	struct sched_param param = {0};
+	pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+	while (true) {
+		pthread_mutex_lock(&(cache->prediction_lock));
+		pthread_mutex_lock(&(cache->lock));
+		if (cache->stop) {
+			pthread_mutex_unlock(&(cache->lock));
+			pthread_mutex_unlock(&(cache->prediction_lock));
+			break;
+		}
+
+		//let waiting invalidations through
+		if (cache->num_pending_invalidations > 0) {
+			pthread_mutex_unlock(&(cache->prediction_lock));
+			pthread_cond_wait(&(cache->changed), &(cache->lock));
+			pthread_mutex_unlock(&(cache->lock));
+			continue;
+		}
+
+		predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+		int index = pass_cache_find_incomplete_entry(cache, curr_time);
+		if (index < 0) {
+			//wait for passes to end, or for the cache to be invalidated
+			pthread_mutex_unlock(&(cache->prediction_lock));
+			struct timespec deadline;
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += PASS_CACHE_IDLE_INTERVAL/1000;
+			if (!cache->stop) {
+				pthread_cond_timedwait(&(cache->changed), &(cache->lock), &deadline);
+			}
+			pthread_mutex_unlock(&(cache->lock));
+			continue;
+		}
+
+		//continue after the last cached pass
+		struct pass_cache_entry *entry = cache->entries[index];
+		predict_observer_t observer = cache->observer;
+		predict_julian_date_t start_time = curr_time;
+		if (entry->num_passes > 0) {
+			start_time = entry->passes[entry->num_passes-1].los_time + PASS_CACHE_LOS_MARGIN;
+		}
+		pthread_mutex_unlock(&(cache->lock));
+
+		//predict without holding the cache lock. The entry can't be invalidated while the prediction lock is held.
+		struct predict_position orbit;
+		predict_orbit(entry->orbital_elements, &orbit, start_time);
+		struct pass_cache_pass pass;
+		if (!orbit.decayed) {
+			pass_cache_predict_pass(&observer, entry->orbital_elements, start_time, &pass);
+		}
+
+		pthread_mutex_lock(&(cache->lock));
+		if (orbit.decayed) {
+			entry->can_predict = false;
+		} else {
+			if (entry->num_passes == 0) {
+				entry->start_time = start_time;
+			}
+			entry->passes[entry->num_passes++] = pass;
+		}
+		pthread_mutex_unlock(&(cache->lock));
+		pthread_mutex_unlock(&(cache->prediction_lock));
+	}
+	return NULL;
+}
+
+struct pass_cache *pass_cache_create(const predict_observer_t *observer, struct tle_db *tle_db)
+{
+	struct pass_cache *cache = (struct pass_cache*)calloc(1, sizeof(struct pass_cache));
+	cache->observer = *observer;
+	pthread_mutex_init(&(cache->lock), NULL);
+	pthread_mutex_init(&(cache->prediction_lock), NULL);
+	pthread_cond_init(&(cache->changed), NULL);
+	pass_cache_update_satellites(cache, tle_db);
+
+	//passes are predicted on demand if the thread can't be started
+	cache->thread_running = (pthread_create(&(cache->thread), NULL, pass_cache_thread, cache) == 0);
+	return cache;
+}
+
+/**
+ * Check whether passes can be predicted for a satellite.
+ *
+ * \param observer QTH
+ * \param orbital_elements Orbital elements
+ * \return True if the satellite rises above the horizon and is not geosynchronous
+ **/
+bool pass_cache_can_predict(const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements)
+{
+	return (orbital_elements != NULL) && predict_aos_happens(orbital_elements, observer->latitude) && !predict_is_geosynchronous(orbital_elements);
+}
+
+/**
+ * Lock the cache for invalidating entries, waiting for the background thread to finish its current prediction.
+ *
+ * \param cache Pass cache
+ **/
+void pass_cache_lock_for_invalidation(struct pass_cache *cache)
+{
+	//make the background thread release the prediction lock instead of starting a new prediction
+	pthread_mutex_lock(&(cache->lock));
+	cache->num_pending_invalidations++;
+	pthread_mutex_unlock(&(cache->lock));
+
+	pthread_mutex_lock(&(cache->prediction_lock));
+	pthread_mutex_lock(&(cache->lock));
+	cache->num_pending_invalidations--;
+}
+
+/**
+ * Unlock the cache after invalidating entries, and wake up the background thread.
+ *
+ * \param cache Pass cache
+ **/
+void pass_cache_unlock_after_invalidation(struct pass_cache *cache)
+{
+	pthread_cond_broadcast(&(cache->changed));
+	pthread_mutex_unlock(&(cache->lock));
+	pthread_mutex_unlock(&(cache->prediction_lock));
+}
+
+/**
+ * Remove satellite from the cache. Has to be called with both the prediction lock and the cache lock held.
+ *
+ * \param cache Pass cache
+ * \param index Entry index
+ **/
+void pass_cache_remove_entry(struct pass_cache *cache, int index)
+{
+	struct pass_cache_entry *entry = cache->entries[index];
+	if (entry != NULL) {
+		if (entry->orbital_elements != NULL) {
+			predict_destroy_orbital_elements(entry->orbital_elements);
+		}
+		free(entry);
+		cache->entries[index] = NULL;
+	}
+}
+
+void pass_cache_set_observer(struct pass_cache *cache, const predict_observer_t *observer)
+{
+	pass_cache_lock_for_invalidation(cache);
+	cache->observer = *observer;
+	for (int i=0; i < cache->num_entries; i++) {
+		struct pass_cache_entry *entry = cache->entries[i];
+		if (entry != NULL) {
+			entry->num_passes = 0;
+			entry->can_predict = pass_cache_can_predict(&(cache->observer), entry->orbital_elements);
+		}
+	}
+	pass_cache_unlock_after_invalidation(cache);
+}
+
+void pass_cache_update_satellites(struct pass_cache *cache, struct tle_db *tle_db)
+{
+	pass_cache_lock_for_invalidation(cache);
+
+	//remove satellites that are no longer in the TLE database
+	int num_tles = tle_db->num_tles;
+	for (int i=num_tles; i < cache->num_entries; i++) {
+		pass_cache_remove_entry(cache, i);
+	}
+	cache->entries = (struct pass_cache_entry**)realloc(cache->entries, sizeof(struct pass_cache_entry*)*(num_tles + 1));
+	for (int i=cache->num_entries; i < num_tles; i++) {
+		cache->entries[i] = NULL;
+	}
+	cache->num_entries = num_tles;
+	cache->next_entry = 0;
+
+	for (int i=0; i < num_tles; i++) {
+		if (!tle_db_entry_enabled(tle_db, i)) {
+			pass_cache_remove_entry(cache, i);
+			continue;
+		}
+
+		//keep cached passes when the TLE is unchanged
+		const struct tle_db_entry *tle = &(tle_db->tles[i]);
+		struct pass_cache_entry *entry = cache->entries[i];
+		if ((entry != NULL) && (strcmp(entry->line1, tle->line1) == 0) && (strcmp(entry->line2, tle->line2) == 0)) {
+			continue;
+		}
+
+		pass_cache_remove_entry(cache, i);
+		entry = (struct pass_cache_entry*)calloc(1, sizeof(struct pass_cache_entry));
+		strncpy(entry->line1, tle->line1, TLE_LINE_LENGTH);
+		strncpy(entry->line2, tle->line2, TLE_LINE_LENGTH);
+		entry->orbital_elements = predict_parse_tle(entry->line1, entry->line2);
+		entry->can_predict = pass_cache_can_predict(&(cache->observer), entry->orbital_elements);
+		cache->entries[i] = entry;
+	}
+
+	pass_cache_unlock_after_invalidation(cache);
+}
+
+/**
+ * Check whether a cache entry has been predicted for the given QTH and orbital elements. Has to be called with the
+ * cache lock held.
+ *
+ * \param cache Pass cache
+ * \param entry Cache entry, can be NULL
+ * \param observer QTH
+ * \param orbital_elements Orbital elements
+ * \return True if the entry matches
+ **/
+bool pass_cache_entry_matches(const struct pass_cache *cache, const struct pass_cache_entry *entry, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements)
+{
+	bool same_observer = (observer->latitude == cache->observer.latitude) && (observer->longitude == cache->observer.longitude) && (observer->altitude == cache->observer.altitude);
+	return (entry != NULL) && same_observer && (entry->orbital_elements != NULL) && (entry->orbital_elements->satellite_number == orbital_elements->satellite_number) && (entry->orbital_elements->epoch_year == orbital_elements->epoch_year) && (entry->orbital_elements->epoch_day == orbital_elements->epoch_day);
+}
+
+/**
+ * Look up pass in the cache.
+ *
+ * \param cache Pass cache, can be NULL
+ * \param tle_index Index of the satellite in the TLE database
+ * \param observer QTH. Has to be equal to the QTH of the cache
+ * \param orbital_elements Orbital elements. Have to have the same epoch as the cached TLE
+ * \param time Time
+ * \param upcoming Whether the pass has to start after the given time, or only end after the given time
+ * \param pass Returned pass
+ * \return True if the pass was found in the cache, false otherwise
+ **/
+bool pass_cache_lookup(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, bool upcoming, struct pass_cache_pass *pass)
+{
+	if ((cache == NULL) || (tle_index < 0)) {
+		return false;
+	}
+
+	bool found = false;
+	pthread_mutex_lock(&(cache->lock));
+	struct pass_cache_entry *entry = NULL;
+	if (tle_index < cache->num_entries) {
+		entry = cache->entries[tle_index];
+	}
+	if (pass_cache_entry_matches(cache, entry, observer, orbital_elements) && (entry->start_time <= time)) {
+		for (int i=0; i < entry->num_passes; i++) {
+			const struct pass_cache_pass *cached_pass = &(entry->passes[i]);
+			if ((cached_pass->los_time > time) && (!upcoming || (cached_pass->aos_time > time))) {
+				*pass = *cached_pass;
+				found = true;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&(cache->lock));
+	return found;
+}
+
+void pass_cache_current_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass)
+{
+	if (!pass_cache_lookup(cache, tle_index, observer, orbital_elements, time, false, pass)) {
+		pass_cache_predict_pass(observer, orbital_elements, time, pass);
+	}
+}
+
+/**
+ * Check whether the background thread eventually will predict passes of a satellite for the given QTH and orbital
+ * elements.
+ *
+ * \param cache Pass cache, can be NULL
+ * \param tle_index Index of the satellite in the TLE database
+ * \param observer QTH
+ * \param orbital_elements Orbital elements
+ * \return True if the passes will be cached
+ **/
+bool pass_cache_will_predict(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements)
+{
+	if ((cache == NULL) || (tle_index < 0) || !cache->thread_running) {
+		return false;
+	}
+
+	pthread_mutex_lock(&(cache->lock));
+	struct pass_cache_entry *entry = NULL;
+	if (tle_index < cache->num_entries) {
+		entry = cache->entries[tle_index];
+	}
+	bool will_predict = pass_cache_entry_matches(cache, entry, observer, orbital_elements) && entry->can_predict;
+	pthread_mutex_unlock(&(cache->lock));
+	return will_predict;
+}
+
+bool pass_cache_try_current_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass)
+{
+	if (pass_cache_lookup(cache, tle_index, observer, orbital_elements, time, false, pass)) {
+		return true;
+	}
+	if (pass_cache_will_predict(cache, tle_index, observer, orbital_elements)) {
+		return false;
+	}
+	pass_cache_predict_pass(observer, orbital_elements, time, pass);
+	return true;
+}
+
+void pass_cache_next_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass)
+{
+	if (!pass_cache_lookup(cache, tle_index, observer, orbital_elements, time, true, pass)) {
+		pass_cache_predict_pass(observer, orbital_elements, time, pass);
+		if (pass->aos_time <= time) {
+			//pass in progress, use the one after
+			pass_cache_predict_pass(observer, orbital_elements, pass->los_time + PASS_CACHE_LOS_MARGIN, pass);
+		}
+	}
+}
+
+int pass_cache_num_passes(struct pass_cache *cache, int tle_index)
+{
+	int num_passes = 0;
+	pthread_mutex_lock(&(cache->lock));
+	if ((tle_index >= 0) && (tle_index < cache->num_entries) && (cache->entries[tle_index] != NULL)) {
+		num_passes = cache->entries[tle_index]->num_passes;
+	}
+	pthread_mutex_unlock(&(cache->lock));
+	return num_passes;
+}
+
+void pass_cache_destroy(struct pass_cache **cache)
+{
+	if (*cache == NULL) {
+		return;
+	}
+
+	if ((*cache)->thread_running) {
+		pthread_mutex_lock(&((*cache)->lock));
+		(*cache)->stop = true;
+		pthread_cond_broadcast(&((*cache)->changed));
+		pthread_mutex_unlock(&((*cache)->lock));
+		pthread_join((*cache)->thread, NULL);
+	}
+
+	for (int i=0; i < (*cache)->num_entries; i++) {
+		pass_cache_remove_entry(*cache, i);
+	}
+	free((*cache)->entries);
+	pthread_mutex_destroy(&((*cache)->lock));
+	pthread_mutex_destroy(&((*cache)->prediction_lock));
+	pthread_cond_destroy(&((*cache)->changed));
+	free(*cache);
+	*cache = NULL;
+}
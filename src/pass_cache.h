@@ -0,0 +1,171 @@
+#ifndef PASS_CACHE_H_DEFINED
+#define PASS_CACHE_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <predict/predict.h>
+#include "tle_db.h"
+
+/**
+ * Cache of the upcoming passes of the enabled satellites in the TLE database, filled by a low-priority background
+ * thread. Used by the satellite listing, singletrack and the pass schedules instead of calling predict_next_aos(),
+ * predict_next_los() and predict_at_max_elevation() inline, so that passes ending at the same time do not have to
+ * be predicted synchronously. Passes are predicted from copies of the TLEs and the QTH, and have to be invalidated
+ * using pass_cache_update_satellites() and pass_cache_set_observer() when these change.
+ **/
+
+//Number of upcoming passes cached for each satellite
+#define PASS_CACHE_NUM_PASSES 5
+
+/**
+ * Satellite pass.
+ **/
+struct pass_cache_pass {
+	///AOS time. For a pass that is in progress at the time the pass is predicted from, that time
+	predict_julian_date_t aos_time;
+	///Azimuth at AOS, in radians
+	double aos_azimuth;
+	///Time of closest approach, i.e. of maximum elevation
+	predict_julian_date_t tca_time;
+	///Azimuth at closest approach, in radians
+	double tca_azimuth;
+	///Maximum elevation, in radians
+	double max_elevation;
+	///LOS time
+	predict_julian_date_t los_time;
+	///Azimuth at LOS, in radians
+	double los_azimuth;
+};
+
+/**
+ * Cached passes of a satellite.
+ **/
+struct pass_cache_entry {
+	///TLE lines the passes are predicted from
+	char line1[TLE_LINE_LENGTH+1];
+	char line2[TLE_LINE_LENGTH+1];
+	///Orbital elements parsed from the TLE lines, owned by the cache
+	predict_orbital_elements_t *orbital_elements;
+	///Whether passes can be predicted for the satellite (will rise above the horizon, not geosynchronous, not decayed)
+	bool can_predict;
+	///Time from which the cached passes are contiguous
+	predict_julian_date_t start_time;
+	///Number of cached passes
+	int num_passes;
+	///Cached passes, in chronological order
+	struct pass_cache_pass passes[PASS_CACHE_NUM_PASSES];
+};
+
+/**
+ * Pass cache.
+ **/
+struct pass_cache {
+	///Copy of the QTH the passes are predicted for
+	predict_observer_t observer;
+	///Number of entries, equal to the number of TLEs in the TLE database
+	int num_entries;
+	///Cached passes, one entry for each TLE in the TLE database. NULL for satellites that are not enabled
+	struct pass_cache_entry **entries;
+	///Lock protecting the fields above, held only for short periods
+	pthread_mutex_t lock;
+	///Held by the background thread while it uses orbital elements owned by the cache, and while entries are invalidated
+	pthread_mutex_t prediction_lock;
+	///Signalled when the cache is invalidated or should stop
+	pthread_cond_t changed;
+	///Background thread
+	pthread_t thread;
+	///Whether the background thread is running
+	bool thread_running;
+	///Whether the background thread should exit
+	bool stop;
+	///Number of threads waiting for the prediction lock in order to invalidate entries
+	int num_pending_invalidations;
+	///Entry the background thread continues from, so that all satellites are filled evenly
+	int next_entry;
+};
+
+/**
+ * Create pass cache and start the background thread.
+ *
+ * \param observer QTH, copied into the cache
+ * \param tle_db TLE database. Passes are cached for the enabled satellites
+ * \return Pass cache
+ **/
+struct pass_cache *pass_cache_create(const predict_observer_t *observer, struct tle_db *tle_db);
+
+/**
+ * Set the QTH the passes are predicted for, and invalidate all cached passes.
+ *
+ * \param cache Pass cache
+ * \param observer QTH, copied into the cache
+ **/
+void pass_cache_set_observer(struct pass_cache *cache, const predict_observer_t *observer);
+
+/**
+ * Update the cache after TLE entries have been changed, added, enabled or disabled. Cached passes of satellites with
+ * changed TLEs are invalidated.
+ *
+ * \param cache Pass cache
+ * \param tle_db TLE database
+ **/
+void pass_cache_update_satellites(struct pass_cache *cache, struct tle_db *tle_db);
+
+/**
+ * Get the current or next pass of a satellite, i.e. the first pass with LOS after the given time. Corresponds to
+ * predict_next_los(), predict_at_max_elevation() and predict_next_aos() called at the given time. Taken from the cache
+ * when available, and predicted using the supplied orbital elements and observer otherwise.
+ *
+ * \param cache Pass cache, or NULL for always predicting the pass
+ * \param tle_index Index of the satellite in the TLE database, -1 if the satellite is not in the TLE database
+ * \param observer QTH
+ * \param orbital_elements Orbital elements of the satellite. Passes have to be possible (see predict_aos_happens(), predict_is_geosynchronous())
+ * \param time Time
+ * \param pass Returned pass
+ **/
+void pass_cache_current_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass);
+
+/**
+ * Get the current or next pass of a satellite like pass_cache_current_pass(), but without blocking on predictions
+ * that the background thread is going to make. The pass is predicted inline only when it never will be cached
+ * (no cache, background thread not running, satellite not in the cache or with different TLE or QTH).
+ *
+ * \param cache Pass cache, or NULL for always predicting the pass
+ * \param tle_index Index of the satellite in the TLE database, -1 if the satellite is not in the TLE database
+ * \param observer QTH
+ * \param orbital_elements Orbital elements of the satellite. Passes have to be possible (see predict_aos_happens(), predict_is_geosynchronous())
+ * \param time Time
+ * \param pass Returned pass
+ * \return True if the pass was returned, false if the pass has not been cached yet
+ **/
+bool pass_cache_try_current_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass);
+
+/**
+ * Get the next pass of a satellite, i.e. the first pass with AOS after the given time. Corresponds to predict_next_aos()
+ * called at the given time, and predict_next_los() and predict_at_max_elevation() called at the AOS.
+ *
+ * \param cache Pass cache, or NULL for always predicting the pass
+ * \param tle_index Index of the satellite in the TLE database, -1 if the satellite is not in the TLE database
+ * \param observer QTH
+ * \param orbital_elements Orbital elements of the satellite. Passes have to be possible (see predict_aos_happens(), predict_is_geosynchronous())
+ * \param time Time
+ * \param pass Returned pass
+ **/
+void pass_cache_next_pass(struct pass_cache *cache, int tle_index, const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_cache_pass *pass);
+
+/**
+ * Get number of cached passes of a satellite.
+ *
+ * \param cache Pass cache
+ * \param tle_index Index of the satellite in the TLE database
+ * \return Number of cached passes
+ **/
+int pass_cache_num_passes(struct pass_cache *cache, int tle_index);
+
+/**
+ * Stop the background thread and free the pass cache.
+ *
+ * \param cache Pass cache
+ **/
+void pass_cache_destroy(struct pass_cache **cache);
+
+#endif
@@ -0,0 +1,290 @@
+#include "pass_sampler.h"
+#include "ephemeris_context.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//Number of seconds in a day
+#define SECONDS_PER_DAY 86400.0
+
+//Samples at angular resolution are moved closer when further apart than this factor times the step
+#define PASS_SAMPLER_ANGULAR_MARGIN 1.25
+
+//Maximum number of times the time step to a sample at angular resolution is shortened
+#define PASS_SAMPLER_MAX_STEP_ADJUSTMENTS 5
+
+/**
+ * Propagated anchor points of a pass.
+ **/
+struct pass_sampler_anchors {
+	///Number of anchors
+	int num_anchors;
+	///Propagated orbits, in chronological order
+	struct predict_position *anchors;
+	///Available size in the `anchors` array
+	int available_size;
+	///Number of orbit propagations
+	int num_propagations;
+};
+
+/**
+ * Add anchor to the end of the anchor array.
+ *
+ * \param anchors Anchors
+ * \param orbit Propagated orbit
+ **/
+void pass_sampler_add_anchor(struct pass_sampler_anchors *anchors, const struct predict_position *orbit)
+{
+	if (anchors->num_anchors == anchors->available_size) {
+		anchors->available_size = (anchors->available_size > 0) ? anchors->available_size*2 : 16;
+		anchors->anchors = (struct predict_position*)realloc(anchors->anchors, sizeof(struct predict_position)*anchors->available_size);
+	}
+	anchors->anchors[anchors->num_anchors] = *orbit;
+	anchors->num_anchors++;
+}
+
+/**
+ * Propagate orbit using the full model.
+ *
+ * \param orbital_elements Orbital elements
+ * \param anchors Anchors, for counting the propagations
+ * \param time Time
+ * \param orbit Returned orbit
+ **/
+void pass_sampler_propagate(const predict_orbital_elements_t *orbital_elements, struct pass_sampler_anchors *anchors, predict_julian_date_t time, struct predict_position *orbit)
+{
+	predict_orbit(orbital_elements, orbit, time);
+	anchors->num_propagations++;
+}
+
+/**
+ * Cubic Hermite interpolation of one coordinate.
+ *
+ * \param start_value Value at start of interval
+ * \param start_derivative Derivative at start of interval
+ * \param end_value Value at end of interval
+ * \param end_derivative Derivative at end of interval
+ * \param length Length of interval
+ * \param tau Fraction of the interval, from 0 to 1
+ * \param derivative Returned interpolated derivative
+ * \return Interpolated value
+ **/
+static inline double pass_sampler_hermite(double start_value, double start_derivative, double end_value, double end_derivative, double length, double tau, double *derivative)
+{
+	double tau2 = tau*tau;
+	double tau3 = tau2*tau;
+	*derivative = (6*tau2 - 6*tau)*(start_value - end_value)/length + (3*tau2 - 4*tau + 1)*start_derivative + (3*tau2 - 2*tau)*end_derivative;
+	return (2*tau3 - 3*tau2 + 1)*start_value + (tau3 - 2*tau2 + tau)*length*start_derivative + (-2*tau3 + 3*tau2)*end_value + (tau3 - tau2)*length*end_derivative;
+}
+
+/**
+ * Interpolate the ECI position, velocity and phase of the orbit between two anchors. The other quantities are copied
+ * from the closest anchor, and the geodetic position and eclipse status have to be calculated using
+ * ephemeris_context_geodetic_position().
+ *
+ * \param start Anchor at start of interval
+ * \param end Anchor at end of interval
+ * \param time Time within the interval
+ * \param orbit Returned orbit
+ **/
+void pass_sampler_interpolate(const struct predict_position *start, const struct predict_position *end, predict_julian_date_t time, struct predict_position *orbit)
+{
+	double length = (end->time - start->time)*SECONDS_PER_DAY;
+	double tau = (time - start->time)*SECONDS_PER_DAY/length;
+	*orbit = (tau < 0.5) ? *start : *end;
+	orbit->time = time;
+	for (int i=0; i < 3; i++) {
+		orbit->position[i] = pass_sampler_hermite(start->position[i], start->velocity[i], end->position[i], end->velocity[i], length, tau, &(orbit->velocity[i]));
+	}
+
+	//phase advances less than one revolution between anchors
+	double phase_change = fmod(end->phase - start->phase + 2*M_PI, 2*M_PI);
+	orbit->phase = fmod(start->phase + tau*phase_change, 2*M_PI);
+}
+
+/**
+ * Add anchors between two anchors until the interpolation is accurate over the interval. The midpoint of the
+ * interval is propagated and compared to the interpolated position, and the interval is split at the midpoint if
+ * the difference is larger than PASS_SAMPLER_POSITION_TOLERANCE or the revolution number changes within the interval.
+ * The midpoint is added as an anchor in either case. Intervals ending after the orbit has decayed are not refined.
+ *
+ * \param orbital_elements Orbital elements
+ * \param start Anchor at start of interval, already added
+ * \param end Anchor at end of interval, added after this call
+ * \param anchors Anchors
+ **/
+void pass_sampler_refine(const predict_orbital_elements_t *orbital_elements, const struct predict_position *start, const struct predict_position *end, struct pass_sampler_anchors *anchors)
+{
+	if (((end->time - start->time)*SECONDS_PER_DAY < PASS_SAMPLER_MIN_INTERVAL) || end->decayed) {
+		return;
+	}
+
+	struct predict_position midpoint, interpolated;
+	pass_sampler_propagate(orbital_elements, anchors, (start->time + end->time)/2.0, &midpoint);
+	pass_sampler_interpolate(start, end, midpoint.time, &interpolated);
+
+	double error = 0;
+	for (int i=0; i < 3; i++) {
+		error += (midpoint.position[i] - interpolated.position[i])*(midpoint.position[i] - interpolated.position[i]);
+	}
+	bool accurate = (sqrt(error) < PASS_SAMPLER_POSITION_TOLERANCE) && (start->revolutions == end->revolutions);
+
+	//splitting does not help where the model fails to give a position
+	if (!isfinite(error)) {
+		accurate = true;
+	}
+
+	if (!accurate) {
+		pass_sampler_refine(orbital_elements, start, &midpoint, anchors);
+	}
+	pass_sampler_add_anchor(anchors, &midpoint);
+	if (!accurate) {
+		pass_sampler_refine(orbital_elements, &midpoint, end, anchors);
+	}
+}
+
+/**
+ * Add sample to the end of the sample array. The orbit is interpolated from the anchors, or taken directly from an
+ * anchor at the same time.
+ *
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation below which samples in sunlight are marked as visible, in degrees
+ * \param anchors Anchors covering the time of the sample
+ * \param anchor_index Index of the anchor at or before the time of the previous sample. Updated to the anchor at or before the time of the new sample
+ * \param time Time
+ * \param samples Samples
+ **/
+void pass_sampler_add_sample(const predict_observer_t *observer, double sun_elevation_limit, const struct pass_sampler_anchors *anchors, int *anchor_index, predict_julian_date_t time, struct pass_samples *samples)
+{
+	if (samples->num_samples == samples->available_size) {
+		samples->available_size = (samples->available_size > 0) ? samples->available_size*2 : 64;
+		samples->samples = (struct pass_sample*)realloc(samples->samples, sizeof(struct pass_sample)*samples->available_size);
+	}
+	struct pass_sample *sample = &(samples->samples[samples->num_samples]);
+	samples->num_samples++;
+
+	while ((*anchor_index + 1 < anchors->num_anchors) && (anchors->anchors[*anchor_index + 1].time <= time)) {
+		(*anchor_index)++;
+	}
+
+	struct ephemeris_context context;
+	ephemeris_context_update(&context, observer, time);
+	context.sun_elevation_limit = sun_elevation_limit;
+	const struct predict_position *anchor = &(anchors->anchors[*anchor_index]);
+	if ((anchor->time == time) || (*anchor_index + 1 == anchors->num_anchors)) {
+		sample->orbit = *anchor;
+	} else {
+		pass_sampler_interpolate(anchor, anchor + 1, time, &(sample->orbit));
+		ephemeris_context_geodetic_position(&context, &(sample->orbit));
+	}
+	ephemeris_context_observe_orbit(&context, &(sample->orbit), &(sample->obs));
+}
+
+/**
+ * Get the angular distance on the sky between two observations.
+ *
+ * \param first First observation
+ * \param second Second observation
+ * \return Angular distance, in radians
+ **/
+double pass_sampler_angular_distance(const struct predict_observation *first, const struct predict_observation *second)
+{
+	double cos_distance = sin(first->elevation)*sin(second->elevation) + cos(first->elevation)*cos(second->elevation)*cos(first->azimuth - second->azimuth);
+	return acos(fmax(fmin(cos_distance, 1.0), -1.0));
+}
+
+void pass_sampler_sample(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, const struct pass_cache_pass *pass, const struct pass_sampler_resolution *resolution, double sun_elevation_limit, struct pass_samples *samples)
+{
+	samples->num_samples = 0;
+
+	//propagate anchors at AOS, TCA and LOS, and refine the intervals in between
+	struct pass_sampler_anchors anchors = {0};
+	struct predict_position aos, tca, los;
+	pass_sampler_propagate(orbital_elements, &anchors, pass->aos_time, &aos);
+	pass_sampler_add_anchor(&anchors, &aos);
+	if (pass->los_time > pass->aos_time) {
+		pass_sampler_propagate(orbital_elements, &anchors, pass->los_time, &los);
+		if ((pass->tca_time > pass->aos_time) && (pass->tca_time < pass->los_time)) {
+			pass_sampler_propagate(orbital_elements, &anchors, pass->tca_time, &tca);
+			pass_sampler_refine(orbital_elements, &aos, &tca, &anchors);
+			pass_sampler_add_anchor(&anchors, &tca);
+			pass_sampler_refine(orbital_elements, &tca, &los, &anchors);
+		} else {
+			pass_sampler_refine(orbital_elements, &aos, &los, &anchors);
+		}
+		pass_sampler_add_anchor(&anchors, &los);
+	}
+
+	//samples from AOS to LOS at the given resolution
+	int anchor_index = 0;
+	pass_sampler_add_sample(observer, sun_elevation_limit, &anchors, &anchor_index, pass->aos_time, samples);
+	predict_julian_date_t curr_time = pass->aos_time;
+	double step_radians = resolution->step*M_PI/180.0;
+	while (true) {
+		//time step to the next sample, in seconds
+		double time_step = resolution->step;
+		const struct predict_observation *curr_obs = &(samples->samples[samples->num_samples-1].obs);
+		if (resolution->type == PASS_SAMPLER_ANGULAR_RESOLUTION) {
+			double angular_rate = sqrt(curr_obs->elevation_rate*curr_obs->elevation_rate + pow(curr_obs->azimuth_rate*cos(curr_obs->elevation), 2));
+			time_step = (angular_rate > 0) ? step_radians/angular_rate : (pass->los_time - curr_time)*SECONDS_PER_DAY;
+		}
+		time_step = fmax(time_step, PASS_SAMPLER_MIN_INTERVAL);
+
+		predict_julian_date_t next_time = curr_time + time_step/SECONDS_PER_DAY;
+		if (next_time >= pass->los_time - PASS_SAMPLER_MIN_INTERVAL/SECONDS_PER_DAY) {
+			break;
+		}
+		int prev_anchor_index = anchor_index;
+		pass_sampler_add_sample(observer, sun_elevation_limit, &anchors, &anchor_index, next_time, samples);
+
+		//the angular rate changes along the pass, shorten the step when the sample ended up too far away
+		if (resolution->type == PASS_SAMPLER_ANGULAR_RESOLUTION) {
+			for (int i=0; i < PASS_SAMPLER_MAX_STEP_ADJUSTMENTS; i++) {
+				curr_obs = &(samples->samples[samples->num_samples-2].obs);
+				double distance = pass_sampler_angular_distance(curr_obs, &(samples->samples[samples->num_samples-1].obs));
+				if ((distance <= PASS_SAMPLER_ANGULAR_MARGIN*step_radians) || (time_step <= PASS_SAMPLER_MIN_INTERVAL)) {
+					break;
+				}
+				time_step = fmax(time_step*step_radians/distance, PASS_SAMPLER_MIN_INTERVAL);
+				next_time = curr_time + time_step/SECONDS_PER_DAY;
+				samples->num_samples--;
+				anchor_index = prev_anchor_index;
+				pass_sampler_add_sample(observer, sun_elevation_limit, &anchors, &anchor_index, next_time, samples);
+			}
+		}
+		curr_time = next_time;
+	}
+	if (pass->los_time > pass->aos_time) {
+		pass_sampler_add_sample(observer, sun_elevation_limit, &anchors, &anchor_index, pass->los_time, samples);
+	}
+
+	samples->num_propagations = anchors.num_propagations;
+	free(anchors.anchors);
+}
+
+void pass_samples_free(struct pass_samples *samples)
+{
+	free(samples->samples);
+	samples->samples = NULL;
+	samples->num_samples = 0;
+	samples->available_size = 0;
+	samples->num_propagations = 0;
+}
+
+bool pass_sampler_parse_resolution(const char *string, struct pass_sampler_resolution *resolution)
+{
+	char *unit = NULL;
+	double step = strtod(string, &unit);
+	if ((unit == string) || !(step > 0)) {
+		return false;
+	}
+	if (strcmp(unit, "s") == 0) {
+		resolution->type = PASS_SAMPLER_TIME_RESOLUTION;
+	} else if (strcmp(unit, "deg") == 0) {
+		resolution->type = PASS_SAMPLER_ANGULAR_RESOLUTION;
+	} else {
+		return false;
+	}
+	resolution->step = step;
+	return true;
+}
@@ -0,0 +1,98 @@
+#ifndef PASS_SAMPLER_H_DEFINED
+#define PASS_SAMPLER_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+#include "pass_cache.h"
+
+/**
+ * Sampling of the orbit over a satellite pass, for the pass schedules. The orbit is propagated at a few anchor
+ * points (AOS, TCA, LOS and points in between), and interpolated between them using cubic Hermite interpolation
+ * of the ECI position and velocity. Each interval between anchors is checked against the full model at its
+ * midpoint and subdivided until the interpolation error is below PASS_SAMPLER_POSITION_TOLERANCE, so that the
+ * rows can be produced at any resolution with only a few propagations per pass.
+ **/
+
+//Maximum difference between the interpolated and the propagated position at the midpoint of an interval between anchors, in km
+#define PASS_SAMPLER_POSITION_TOLERANCE 0.1
+
+//Intervals between anchors are not subdivided further when shorter than this, in seconds
+#define PASS_SAMPLER_MIN_INTERVAL 1.0
+
+/**
+ * Type of resolution.
+ **/
+enum pass_sampler_resolution_type {
+	///Fixed time step between samples, in seconds
+	PASS_SAMPLER_TIME_RESOLUTION,
+	///Fixed angular distance on the sky between samples, in degrees
+	PASS_SAMPLER_ANGULAR_RESOLUTION
+};
+
+/**
+ * Resolution of the samples.
+ **/
+struct pass_sampler_resolution {
+	///Type of resolution
+	enum pass_sampler_resolution_type type;
+	///Time step in seconds or angular step in degrees, depending on the type
+	double step;
+};
+
+//Default resolution of the pass schedules, giving about as many rows per pass as PREDICT's time increment did
+#define PASS_SAMPLER_DEFAULT_RESOLUTION {PASS_SAMPLER_ANGULAR_RESOLUTION, 17.0}
+
+/**
+ * Sample of a pass.
+ **/
+struct pass_sample {
+	///Orbit, in the same form as predict_orbit()
+	struct predict_position orbit;
+	///Observation of the orbit, in the same form as predict_observe_orbit()
+	struct predict_observation obs;
+};
+
+/**
+ * Samples of a pass.
+ **/
+struct pass_samples {
+	///Number of samples
+	int num_samples;
+	///Samples, in chronological order. The first sample is at AOS and the last sample at LOS
+	struct pass_sample *samples;
+	///Available size in the `samples` array, reallocated at need
+	int available_size;
+	///Number of orbit propagations used for the samples
+	int num_propagations;
+};
+
+/**
+ * Sample the orbit over a pass.
+ *
+ * \param orbital_elements Orbital elements
+ * \param observer Observer
+ * \param pass Pass, with AOS, TCA and LOS times
+ * \param resolution Resolution of the samples
+ * \param sun_elevation_limit Sun elevation below which samples in sunlight are marked as visible, in degrees (e.g. NAUTICAL_TWILIGHT_SUN_ELEVATION)
+ * \param samples Returned samples. Should be initialized to zero, and freed using pass_samples_free()
+ **/
+void pass_sampler_sample(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, const struct pass_cache_pass *pass, const struct pass_sampler_resolution *resolution, double sun_elevation_limit, struct pass_samples *samples);
+
+/**
+ * Free the sample array.
+ *
+ * \param samples Samples
+ **/
+void pass_samples_free(struct pass_samples *samples);
+
+/**
+ * Parse resolution from string, on the format NUMs for a time step in seconds (e.g. 30s) or NUMdeg for an angular
+ * step in degrees (e.g. 5deg).
+ *
+ * \param string String
+ * \param resolution Returned resolution
+ * \return True if the string could be parsed, false otherwise
+ **/
+bool pass_sampler_parse_resolution(const char *string, struct pass_sampler_resolution *resolution);
+
+#endif
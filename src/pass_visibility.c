@@ -0,0 +1,119 @@
+#include "pass_visibility.h"
+#include <math.h>
+
+//Number of seconds in a day
+#define SECONDS_PER_DAY 86400.0
+
+//Largest rate of change of the sun elevation in radians per second: the earth's angular velocity, with a margin for
+//the motion of the sun
+#define SUN_ELEVATION_MAX_RATE (1.1*7.292115E-5)
+
+//Smallest step when searching for darkness windows, in days
+#define DARKNESS_MIN_STEP (10.0/SECONDS_PER_DAY)
+
+//Accuracy of the start and end times of darkness windows, in days
+#define DARKNESS_TIME_TOLERANCE (1.0/SECONDS_PER_DAY)
+
+/**
+ * Get the sun elevation relative to the darkness limit, negative in darkness.
+ *
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees
+ * \param time Time
+ * \return Sun elevation minus the limit, in radians
+ **/
+double pass_visibility_sun_elevation(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t time)
+{
+	struct predict_observation sun;
+	predict_observe_sun(observer, time, &sun);
+	return sun.elevation - sun_elevation_limit*M_PI/180.0;
+}
+
+/**
+ * Search for the first time where the observer goes into or out of darkness. The sun elevation is stepped through
+ * with steps limited by how fast it can change, and the crossing is refined using bisection.
+ *
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \param darkness True for searching for darkness, false for searching for the end of darkness
+ * \return Time of crossing, `start_time` if already in the searched state, or `end_time` if there is no crossing
+ **/
+predict_julian_date_t pass_visibility_search(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time, bool darkness)
+{
+	predict_julian_date_t time = start_time;
+	double elevation = pass_visibility_sun_elevation(observer, sun_elevation_limit, time);
+	if ((elevation < 0) == darkness) {
+		return start_time;
+	}
+
+	while (time < end_time) {
+		double step = fmax(fabs(elevation)/SUN_ELEVATION_MAX_RATE/SECONDS_PER_DAY, DARKNESS_MIN_STEP);
+		predict_julian_date_t next_time = fmin(time + step, end_time);
+		double next_elevation = pass_visibility_sun_elevation(observer, sun_elevation_limit, next_time);
+		if ((next_elevation < 0) == darkness) {
+			//bisect the crossing, keeping `next_time` in the searched state
+			while (next_time - time > DARKNESS_TIME_TOLERANCE) {
+				predict_julian_date_t midpoint = (time + next_time)/2.0;
+				if ((pass_visibility_sun_elevation(observer, sun_elevation_limit, midpoint) < 0) == darkness) {
+					next_time = midpoint;
+				} else {
+					time = midpoint;
+				}
+			}
+			return next_time;
+		}
+		time = next_time;
+		elevation = next_elevation;
+	}
+	return end_time;
+}
+
+predict_julian_date_t pass_visibility_next_darkness(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time)
+{
+	return pass_visibility_search(observer, sun_elevation_limit, start_time, end_time, true);
+}
+
+predict_julian_date_t pass_visibility_darkness_end(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time)
+{
+	return pass_visibility_search(observer, sun_elevation_limit, start_time, end_time, false);
+}
+
+double pass_visibility_visible_time(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, double sun_elevation_limit, const struct pass_cache_pass *pass, struct eclipse_intervals *intervals, bool *decayed)
+{
+	*decayed = false;
+	double visible_time = 0;
+	predict_julian_date_t time = pass->aos_time;
+	while (time < pass->los_time) {
+		//darkness window within the pass
+		predict_julian_date_t darkness_start = pass_visibility_next_darkness(observer, sun_elevation_limit, time, pass->los_time);
+		if (darkness_start >= pass->los_time) {
+			break;
+		}
+		predict_julian_date_t darkness_end = pass_visibility_darkness_end(observer, sun_elevation_limit, darkness_start, pass->los_time);
+
+		//sunlit time within the window, up to the decay of the orbit
+		eclipse_intervals_find(orbital_elements, darkness_start, darkness_end, intervals);
+		if (intervals->decayed) {
+			*decayed = true;
+			darkness_end = intervals->decay_time;
+		}
+		visible_time += darkness_end - darkness_start;
+		for (int i=0; i < intervals->num_intervals; i++) {
+			visible_time -= intervals->intervals[i].exit_time - intervals->intervals[i].entry_time;
+		}
+		if (*decayed) {
+			break;
+		}
+		time = darkness_end;
+	}
+	return fmax(visible_time, 0.0)*SECONDS_PER_DAY;
+}
+
+bool pass_visibility_shown(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, double sun_elevation_limit, const struct pass_cache_pass *pass, struct eclipse_intervals *intervals)
+{
+	bool decayed;
+	double visible_time = pass_visibility_visible_time(orbital_elements, observer, sun_elevation_limit, pass, intervals, &decayed);
+	return decayed || (visible_time >= PASS_VISIBILITY_MIN_VISIBLE_TIME);
+}
@@ -0,0 +1,75 @@
+#ifndef PASS_VISIBILITY_H_DEFINED
+#define PASS_VISIBILITY_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+#include "pass_cache.h"
+#include "eclipse_intervals.h"
+
+/**
+ * Prefilter for the visible pass predictions. A satellite can only be optically visible while the observer is in
+ * darkness (the sun below a given elevation) and the satellite is in sunlight. Darkness windows are found from the
+ * sun elevation alone, which is cheap to calculate, and the sunlit intervals within them from the eclipse intervals
+ * of the satellite. Passes that do not intersect both can be skipped without being sampled, and the passes during
+ * periods without darkness do not have to be predicted at all.
+ **/
+
+//Maximum time searched for darkness, in days
+#define PASS_VISIBILITY_MAX_DARKNESS_SEARCH 366.0
+
+//Shortest visible time for a pass to be shown in the visible pass predictions, in seconds. Replaces PREDICT's rule of
+//more than three visible rows, or more than two visible and two sunlit rows, at its time increment: the rule depended
+//on the row density, and every pass it accepted is visible for at least this long
+#define PASS_VISIBILITY_MIN_VISIBLE_TIME 180.0
+
+/**
+ * Get the start of the next darkness window, i.e. the first time at or after the given time where the sun is below
+ * the given elevation.
+ *
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees (e.g. NAUTICAL_TWILIGHT_SUN_ELEVATION)
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \return Start of darkness, or `end_time` if the observer is not in darkness before it
+ **/
+predict_julian_date_t pass_visibility_next_darkness(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time);
+
+/**
+ * Get the end of a darkness window, i.e. the first time at or after the given time where the sun is at or above the
+ * given elevation.
+ *
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \return End of darkness, or `end_time` if the observer is in darkness until it
+ **/
+predict_julian_date_t pass_visibility_darkness_end(const predict_observer_t *observer, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time);
+
+/**
+ * Get the time during a pass where the satellite is visible, i.e. sunlit while the observer is in darkness.
+ *
+ * \param orbital_elements Orbital elements
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees
+ * \param pass Pass
+ * \param intervals Eclipse intervals used for the calculation, to avoid reallocating them for each pass. Should be initialized to zero, and freed using eclipse_intervals_free()
+ * \param decayed Returned decay status, true if the orbit decays during a darkness window within the pass. The visible time is then counted up to the decay
+ * \return Visible time, in seconds
+ **/
+double pass_visibility_visible_time(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, double sun_elevation_limit, const struct pass_cache_pass *pass, struct eclipse_intervals *intervals, bool *decayed);
+
+/**
+ * Check whether a pass is visible long enough to be shown in the visible pass predictions, i.e. for at least
+ * PASS_VISIBILITY_MIN_VISIBLE_TIME.
+ *
+ * \param orbital_elements Orbital elements
+ * \param observer Observer
+ * \param sun_elevation_limit Sun elevation limit, in degrees
+ * \param pass Pass
+ * \param intervals Eclipse intervals used for the calculation, to avoid reallocating them for each pass. Should be initialized to zero, and freed using eclipse_intervals_free()
+ * \return True if the pass should be shown, false otherwise. Passes where the orbit decays are always shown
+ **/
+bool pass_visibility_shown(const predict_orbital_elements_t *orbital_elements, const predict_observer_t *observer, double sun_elevation_limit, const struct pass_cache_pass *pass, struct eclipse_intervals *intervals);
+
+#endif
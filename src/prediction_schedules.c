@@ -1,5 +1,8 @@
 #include "prediction_schedules.h"
 #include "ui.h"
+#include "eclipse_intervals.h"
+#include "pass_visibility.h"
+#include "schedule_worker.h"
 #include <math.h>
 
 #include <time.h>
@@ -169,7 +172,60 @@ double prompt_user_for_time(const char* info_str)
 	return ((double)date_to_daynumber(mm,dd,yy)+((hr/24.0)+(min/1440.0)+(sec/86400.0)));
 }
 
-/* This function buffers and displays orbital predictions.
+//Number of pages calculated ahead of the displayed page in the pass and solar illumination schedules
+#define SCHEDULE_PREFETCH_PAGES 2
+
+//Number of displayed pages kept for going back in schedule_print()
+#define SCHEDULE_PRINT_CACHED_PAGES 16
+
+/**
+ * Display a page of predictions.
+ *
+ * \param title Title to show on top of the screen
+ * \param type Type of predictions
+ * \param head2 Column headers
+ * \param page Rows of the page
+ * \param log_on Whether logging is on
+ * \param has_previous_page Whether the user can go back to the previous page
+ **/
+void schedule_print_page(const char *title, const char *type, const char *head2, const char *page, bool log_on, bool has_previous_page)
+{
+	attrset(COLOR_PAIR(6)|A_REVERSE|A_BOLD);
+	clear();
+	mvprintw(0,0,"                                                                                ");
+	mvprintw(1,0,"  flyby Calendar :                                                              ");
+	mvprintw(1,21,"%-24s", type);
+	mvprintw(2,0,"                                                                                ");
+	int title_col = 79-strlen(title);
+	mvprintw(1,title_col, "%s", title);
+	attrset(COLOR_PAIR(2)|A_REVERSE|A_BOLD);
+	mvprintw(3,0,head2);
+
+	attrset(COLOR_PAIR(2)|A_BOLD);
+	mvprintw(4,0,"\n");
+
+	addstr(page);
+	attrset(COLOR_PAIR(4)|A_BOLD);
+
+	if (page[0]=='\n')
+		printw("\n");
+
+	if (!log_on)
+		mvprintw(LINES-2,63,"        ");
+	else
+		mvprintw(LINES-2,63,"Log = ON");
+
+	if (has_previous_page)
+		mvprintw(LINES-2,6,"More? [y/n/b] >> ");
+	else
+		mvprintw(LINES-2,6,"More? [y/n] >> ");
+	curs_set(1);
+	refresh();
+}
+
+/* This function buffers and displays orbital predictions. The last
+ * SCHEDULE_PRINT_CACHED_PAGES pages are kept, so that the user can go
+ * back to previous pages without recalculating them.
  *
  * \param title Title to show on top of the screen
  * \param string Data string to display
@@ -184,6 +240,8 @@ int schedule_print(const char *title, const char *string, char mode)
 	int key, ans=0;
 	static char buffer[5000], lines, quit;
 	static FILE *fd;
+	static char *pages[SCHEDULE_PRINT_CACHED_PAGES];
+	static int first_page, num_pages;
 
 	/* Pass a NULL string to initialize the buffer, counter, and flags */
 
@@ -192,6 +250,11 @@ int schedule_print(const char *title, const char *string, char mode)
 		quit=0;
 		buffer[0]=0;
 		fd=NULL;
+		for (int i=0; i < num_pages; i++) {
+			free(pages[(first_page + i) % SCHEDULE_PRINT_CACHED_PAGES]);
+		}
+		first_page=0;
+		num_pages=0;
 	} else {
 		if (mode=='p')
 			strcpy(type,"Satellite Passes");
@@ -226,42 +289,38 @@ int schedule_print(const char *title, const char *string, char mode)
 		lines++;
 //JHJHJH
 		if (lines==(LINES-8)) {
-			attrset(COLOR_PAIR(6)|A_REVERSE|A_BOLD);
-			clear();
-			mvprintw(0,0,"                                                                                ");
-			mvprintw(1,0,"  flyby Calendar :                                                              ");
-			mvprintw(1,21,"%-24s", type);
-			mvprintw(2,0,"                                                                                ");
-			int title_col = 79-strlen(title);
-			mvprintw(1,title_col, "%s", title);
-			attrset(COLOR_PAIR(2)|A_REVERSE|A_BOLD);
-			mvprintw(3,0,head2);
-
-			attrset(COLOR_PAIR(2)|A_BOLD);
-	                mvprintw(4,0,"\n");
-
-			addstr(buffer);
-			attrset(COLOR_PAIR(4)|A_BOLD);
-
-			if (buffer[0]=='\n')
-                              printw("\n");
-
-			if (fd==NULL)
-				mvprintw(LINES-2,63,"        ");
-			else
-				mvprintw(LINES-2,63,"Log = ON");
-
-			mvprintw(LINES-2,6,"More? [y/n] >> ");
-			curs_set(1);
-			refresh();
+			//keep the page, dropping the oldest page when the cache is full
+			if (num_pages == SCHEDULE_PRINT_CACHED_PAGES) {
+				free(pages[first_page]);
+				first_page = (first_page + 1) % SCHEDULE_PRINT_CACHED_PAGES;
+				num_pages--;
+			}
+			pages[(first_page + num_pages) % SCHEDULE_PRINT_CACHED_PAGES] = strdup(buffer);
+			num_pages++;
+			buffer[0]=0;
+
+			//displayed page, counted from the oldest cached page
+			int page = num_pages-1;
+			schedule_print_page(title, type, head2, pages[(first_page + page) % SCHEDULE_PRINT_CACHED_PAGES], fd!=NULL, page > 0);
 
 			while (ans==0) {
 				key=toupper(getch());
 
 				if (key=='Y' || key=='\n' || key==' ') {
-					key='Y';
-					ans=1;
-					quit=0;
+					if (page < num_pages-1) {
+						//forward through the cached pages before continuing with new rows
+						page++;
+						schedule_print_page(title, type, head2, pages[(first_page + page) % SCHEDULE_PRINT_CACHED_PAGES], fd!=NULL, page > 0);
+					} else {
+						key='Y';
+						ans=1;
+						quit=0;
+					}
+				}
+
+				if (key=='B' && page > 0) {
+					page--;
+					schedule_print_page(title, type, head2, pages[(first_page + page) % SCHEDULE_PRINT_CACHED_PAGES], fd!=NULL, page > 0);
 				}
 
 				if (key=='N' || key=='Q' || key==27) {
@@ -269,8 +328,6 @@ int schedule_print(const char *title, const char *string, char mode)
 					ans=1;
 					quit=1;
 				}
-
-				buffer[0]=0;
 			}
 
 			lines=0;
@@ -280,80 +337,190 @@ int schedule_print(const char *title, const char *string, char mode)
 	return (quit);
 }
 
-/* This function acts as a filter to display passes that could
- * possibly be visible to the ground station.  It works by first
- * buffering prediction data generated by the Predict() function
- * and then checking it to see if at least a part of the pass
- * is visible.  If it is, then the buffered prediction data
- * is sent to the Print() function so it can be displayed
- * to the user.
+/**
+ * Render the rows calculated by a schedule worker, until the calculation has finished or the user quits. The
+ * keyboard is polled for ESC only while waiting for rows.
  *
+ * \param worker Schedule worker
  * \param title Title to show on top of the screen
- * \param string Data to display
- * \return 1 if user wants to quit, 0 otherwise
+ * \param mode Display mode, as in schedule_print()
+ * \return True if the user quit before the calculation finished, false otherwise
  **/
-int visible_schedule_print(const char *title, const char *string)
+bool schedule_worker_display(struct schedule_worker *worker, const char *title, char mode)
 {
-	static char buffer[10000];
-	char line[80], plus, asterisk, visible;
-	int x, y, quit=0;
+	char row[MAX_NUM_CHARS];
+	bool should_quit = false;
+	while (!should_quit) {
+		enum schedule_worker_status status = schedule_worker_pop(worker, row);
+		if (status == SCHEDULE_WORKER_FINISHED) {
+			break;
+		}
 
-	if (string[0]==0)
-		buffer[0]=0;
-	else {
-		strcat(buffer,string);
+		if (status == SCHEDULE_WORKER_ROW) {
+			should_quit=schedule_print(title,row,mode);
+			continue;
+		}
 
-		if (string[0]=='\n') {
-			plus=0;
-			visible=0;
-			asterisk=0;
+		//wait for more rows while allowing a way out
+		attrset(COLOR_PAIR(4));
+		mvprintw(LINES - 2,6,"                 Calculating... Press [ESC] To Quit");
+		refresh();
+		timeout(SCHEDULE_WORKER_POLL_INTERVAL);
+		if (getch()==27) {
+			should_quit = true;
+		}
+		timeout(-1);
+	}
+	return should_quit;
+}
+
+/**
+ * Display error for when the schedule worker thread could not be started.
+ **/
+void schedule_worker_display_error(void)
+{
+	bkgdset(COLOR_PAIR(5)|A_BOLD);
+	clear();
+	mvprintw(12,5,"*** Could not start the calculation of the predictions! ***\n");
+	beep();
+	bkgdset(COLOR_PAIR(7)|A_BOLD);
+	any_key();
+	bkgdset(COLOR_PAIR(1));
+	refresh();
+}
 
-			for (x=0; buffer[x]!=0 && visible==0; x++) {
-				if (buffer[x]=='+')
-					plus++;
+/**
+ * Data for calculating the pass schedule in the worker thread.
+ **/
+struct satellite_pass_schedule {
+	///Orbital elements of the satellite
+	const predict_orbital_elements_t *orbital_elements;
+	///QTH
+	const predict_observer_t *qth;
+	///Cache of upcoming passes
+	struct pass_cache *pass_cache;
+	///Index of the satellite in the TLE database
+	int tle_index;
+	///Resolution of the rows within each pass
+	const struct pass_sampler_resolution *resolution;
+	///Sun elevation below which satellites in sunlight are visible, in degrees
+	double sun_elevation_limit;
+	///'p' for all passes, 'v' for visible passes only
+	char mode;
+	///Time to start predicting passes from
+	predict_julian_date_t start_time;
+	///Set to false when the sun does not set far enough for visible passes within PASS_VISIBILITY_MAX_DARKNESS_SEARCH
+	bool has_darkness;
+};
 
-				if (buffer[x]=='*')
-					asterisk++;
+/**
+ * Search for the next darkness window for visible passes, one day at a time so that the search can be cancelled.
+ *
+ * \param worker Schedule worker
+ * \param qth QTH
+ * \param sun_elevation_limit Sun elevation limit of the darkness, in degrees
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \return Start of darkness, or `end_time` if there is no darkness or the search was cancelled
+ **/
+predict_julian_date_t satellite_pass_schedule_next_darkness(struct schedule_worker *worker, const predict_observer_t *qth, double sun_elevation_limit, predict_julian_date_t start_time, predict_julian_date_t end_time)
+{
+	for (predict_julian_date_t time = start_time; (time < end_time) && !schedule_worker_cancelled(worker); time += 1.0) {
+		predict_julian_date_t day_end = fmin(time + 1.0, end_time);
+		predict_julian_date_t darkness_start = pass_visibility_next_darkness(qth, sun_elevation_limit, time, day_end);
+		if (darkness_start < day_end) {
+			return darkness_start;
+		}
+	}
+	return end_time;
+}
 
-				/* At least 3 +'s or at least 2 +'s
-				   combined with at least 2 *'s is
-				   worth displaying as a visible pass. */
+/**
+ * Calculate the rows of the pass schedule, with an empty line after each pass. Only the visible passes are
+ * included for 'v', so that the queue of the schedule worker contains only displayed rows. Run by the schedule worker.
+ *
+ * \param worker Schedule worker
+ * \param data Pass schedule
+ **/
+void satellite_pass_schedule_calculate(struct schedule_worker *worker, void *data)
+{
+	struct satellite_pass_schedule *schedule = (struct satellite_pass_schedule*)data;
+	const predict_orbital_elements_t *orbital_elements = schedule->orbital_elements;
+	const predict_observer_t *qth = schedule->qth;
+	char data_string[MAX_NUM_CHARS];
+	char time_string[MAX_NUM_CHARS];
+	bool should_continue = true;
 
-				if ((plus>3) || (plus>2 && asterisk>2))
-					visible=1;
+	predict_julian_date_t curr_time = schedule->start_time;
+	struct predict_position orbit;
+	struct pass_samples samples = {0};
+	struct eclipse_intervals eclipse_intervals = {0};
+	do {
+		if (schedule->mode=='v') {
+			//passes in daylight cannot be visible, search for passes from one orbit before the next darkness
+			predict_julian_date_t search_end = curr_time + PASS_VISIBILITY_MAX_DARKNESS_SEARCH;
+			predict_julian_date_t darkness_start = satellite_pass_schedule_next_darkness(worker, qth, schedule->sun_elevation_limit, curr_time, search_end);
+			if (schedule_worker_cancelled(worker)) {
+				break;
 			}
+			if (darkness_start >= search_end) {
+				schedule->has_darkness = false;
+				break;
+			}
+			curr_time = fmax(curr_time, darkness_start - 1.0/orbital_elements->mean_motion);
+		}
 
-			if (visible) {
-				/* Dump buffer to Print() line by line */
+		struct pass_cache_pass next_pass;
+		pass_cache_next_pass(schedule->pass_cache, schedule->tle_index, qth, orbital_elements, curr_time, &next_pass);
 
-				for (x=0, y=0; buffer[x]!=0 && quit==0; x++) {
-					line[y]=buffer[x];
+		//sample only the passes that are visible long enough, independently of the pass resolution
+		if ((schedule->mode=='v') && !pass_visibility_shown(orbital_elements, qth, schedule->sun_elevation_limit, &next_pass, &eclipse_intervals)) {
+			curr_time = next_pass.los_time;
+			predict_orbit(orbital_elements, &orbit, curr_time);
+			should_continue = !schedule_worker_cancelled(worker);
+			continue;
+		}
 
-					if (line[y]=='\n') {
-						line[y+1]=0;
-						quit=schedule_print(title,line,'v');
-						line[0]=0;
-						y=0;
-					} else
-						y++;
-				}
+		//rows from AOS to LOS, interpolated from a few propagations over the pass
+		pass_sampler_sample(orbital_elements, qth, &next_pass, schedule->resolution, schedule->sun_elevation_limit, &samples);
+		for (int i=0; (i < samples.num_samples) && should_continue; i++) {
+			orbit = samples.samples[i].orbit;
+			const struct predict_observation *obs = &(samples.samples[i].obs);
+
+			//get formatted time
+			time_t epoch = predict_from_julian(orbit.time);
+			strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
+
+			//modulo 256 phase
+			int ma256 = (int)rint(256.0*(orbit.phase/(2*M_PI)));
+
+			//satellite visibility status
+			char visibility;
+			if (obs->visible) {
+				visibility = '+';
+			} else if (!(orbit.eclipsed)) {
+				visibility = '*';
+			} else {
+				visibility = ' ';
 			}
 
-			buffer[0]=0;
+			//format line of data
+			sprintf(data_string,"      %s%4d %4d  %4d  %4d   %4d   %6ld  %6ld %c\n", time_string, (int)(obs->elevation*180.0/M_PI), (int)(obs->azimuth*180.0/M_PI), ma256, (int)(orbit.latitude*180.0/M_PI), (int)(orbit.longitude*180.0/M_PI), (long)(obs->range), orbit.revolutions, visibility);
+			should_continue = schedule_worker_push(worker, data_string);
 		}
-	}
+		curr_time = next_pass.los_time;
 
-	return quit;
+		if (should_continue) {
+			should_continue = schedule_worker_push(worker, "\n");
+		}
+	} while (should_continue && !(orbit.decayed));
+	pass_samples_free(&samples);
+	eclipse_intervals_free(&eclipse_intervals);
 }
 
-void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, char mode)
+void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, const struct pass_sampler_resolution *resolution, double sun_elevation_limit, char mode)
 {
 	schedule_print("","",0);
-	visible_schedule_print("","");
-	bool should_quit = false;
-	bool should_break = false;
-	char data_string[MAX_NUM_CHARS];
-	char time_string[MAX_NUM_CHARS];
 
 	predict_julian_date_t curr_time = prompt_user_for_time(name);
 
@@ -365,85 +532,27 @@ void satellite_pass_display_schedule(const char *name, predict_orbital_elements_
 	sprintf(title, "%s (%d)", name, orbital_elements->satellite_number);
 
 	if (predict_aos_happens(orbital_elements, qth->latitude) && !predict_is_geosynchronous(orbital_elements) && !(orbit.decayed)) {
-		do {
-			predict_julian_date_t next_aos = predict_next_aos(qth, orbital_elements, curr_time).time;
-			predict_julian_date_t next_los = predict_next_los(qth, orbital_elements, next_aos).time;
-			curr_time = next_aos;
-
-			struct predict_observation obs;
-			predict_orbit(orbital_elements, &orbit, curr_time);
-			predict_observe_orbit(qth, &orbit, &obs);
-			bool has_printed_last_entry = false;
-			int last_printed_elevation = 1;
-			do {
-				//get formatted time
-				time_t epoch = predict_from_julian(curr_time);
-				strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
-
-				//modulo 256 phase
-				int ma256 = (int)rint(256.0*(orbit.phase/(2*M_PI)));
-
-				//satellite visibility status
-				char visibility;
-				if (obs.visible) {
-					visibility = '+';
-				} else if (!(orbit.eclipsed)) {
-					visibility = '*';
-				} else {
-					visibility = ' ';
-				}
-
-				//format line of data
-				sprintf(data_string,"      %s%4d %4d  %4d  %4d   %4d   %6ld  %6ld %c\n", time_string, (int)(obs.elevation*180.0/M_PI), (int)(obs.azimuth*180.0/M_PI), ma256, (int)(orbit.latitude*180.0/M_PI), (int)(orbit.longitude*180.0/M_PI), (long)(obs.range), orbit.revolutions, visibility);
-				last_printed_elevation = obs.elevation*180.0/M_PI;
-
-				//print data to screen
-				if (mode=='p') {
-					should_quit=schedule_print(title,data_string,'p');
-				}
-
-				//print only visible passes to screen
-				if (mode=='v') {
-					nodelay(stdscr,TRUE);
-					attrset(COLOR_PAIR(4));
-					mvprintw(LINES - 2,6,"                 Calculating... Press [ESC] To Quit");
-
-					/* Allow a way out if this
-					   should continue forever... */
-
-					if (getch()==27) {
-						//will continue through the pass, and then break the outer whileloop
-						should_break = true;
-					}
-
-					nodelay(stdscr,FALSE);
-
-					should_quit=visible_schedule_print(title,data_string);
-				}
-
-				//calculate results for next timestep
-				curr_time += cos((obs.elevation*180/M_PI-1.0)*M_PI/180.0)*sqrt(orbit.altitude)/25000.0; //predict's magic time increment formula
-				predict_orbit(orbital_elements, &orbit, curr_time);
-				predict_observe_orbit(qth, &orbit, &obs);
-
-				//make sure that the last printed line is at elevation 0 (since that looks nicer)
-				if ((last_printed_elevation != 0) && (obs.elevation < 0) && !has_printed_last_entry) {
-					has_printed_last_entry = true;
-					curr_time = next_los;
-
-					predict_orbit(orbital_elements, &orbit, curr_time);
-					predict_observe_orbit(qth, &orbit, &obs);
-				}
-			} while (((obs.elevation >= 0) || (curr_time <= next_los)) && !should_quit);
-
-			if (mode=='p') {
-				should_quit=schedule_print(title,"\n",'p');
-			}
+		//passes are calculated in a worker thread while the rows are displayed
+		struct satellite_pass_schedule schedule = {.orbital_elements = orbital_elements, .qth = qth, .pass_cache = pass_cache, .tle_index = tle_index, .resolution = resolution, .sun_elevation_limit = sun_elevation_limit, .mode = mode, .start_time = curr_time, .has_darkness = true};
+		struct schedule_worker *worker = schedule_worker_start(satellite_pass_schedule_calculate, &schedule, SCHEDULE_PREFETCH_PAGES*(LINES-8));
+		if (worker == NULL) {
+			schedule_worker_display_error();
+			return;
+		}
+		bool should_quit = schedule_worker_display(worker, title, mode);
+		schedule_worker_destroy(&worker);
 
-			if (mode=='v') {
-				should_quit=visible_schedule_print(title,"\n");
-			}
-		} while (!should_quit && !should_break && !(orbit.decayed));
+		if (!should_quit && !schedule.has_darkness) {
+			//display warning that no passes can be visible
+			bkgdset(COLOR_PAIR(5)|A_BOLD);
+			clear();
+			mvprintw(12,5,"*** No visible passes for %s: the sun stays up for the next year! ***\n",name);
+			beep();
+			bkgdset(COLOR_PAIR(7)|A_BOLD);
+			any_key();
+			bkgdset(COLOR_PAIR(1));
+			refresh();
+		}
 	} else {
 		//display warning that passes are impossible
 		bkgdset(COLOR_PAIR(5)|A_BOLD);
@@ -600,109 +709,118 @@ void sun_moon_pass_display_schedule(enum astronomical_body object, predict_obser
 	} while (quit==0);
 }
 
-void solar_illumination_display_predictions(const char *name, predict_orbital_elements_t *orbital_elements)
+/**
+ * Format the solar illumination of a day for the solar illumination predictions.
+ *
+ * \param string Returned string, of size MAX_NUM_CHARS
+ * \param day Start of the day
+ * \param sunlit_minutes Number of sunlit minutes in the day
+ * \param decayed Whether the orbit has decayed by the end of the day
+ **/
+void solar_illumination_format_day(char *string, predict_julian_date_t day, int sunlit_minutes, bool decayed)
 {
-	double startday, oneminute, sunpercent;
-	int eclipses, minutes, quit, breakout=0, count;
-	char string1[MAX_NUM_CHARS], string[MAX_NUM_CHARS], datestring[MAX_NUM_CHARS];
-
-	schedule_print("","",0);
-
-	oneminute=1.0/(24.0*60.0);
-
-	predict_julian_date_t daynum = floor(prompt_user_for_time(name));
-	startday=daynum;
-	count=0;
-
-	curs_set(0);
-	clear();
-
-	const int NUM_MINUTES = 1440;
-
-	struct predict_position orbit;
-
-
-	do {
-		attrset(COLOR_PAIR(4));
-		mvprintw(LINES - 2,6,"                 Calculating... Press [ESC] To Quit");
-		refresh();
+	char datestring[MAX_NUM_CHARS];
+	double sunpercent=100.0*((double)sunlit_minutes)/((double)ECLIPSE_MINUTES_PER_DAY);
 
-		count++;
-		daynum=startday;
+	time_t epoch = predict_from_julian(day);
+	strftime(datestring, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
+	datestring[11]=0;
 
-		mvprintw(1,60, "%s (%d)", name, orbital_elements->satellite_number);
+	if (decayed)
+		snprintf(string, MAX_NUM_CHARS, "%s    Decayed", datestring);
+	else
+		snprintf(string, MAX_NUM_CHARS, "%s    %4d    %6.2f%c",datestring,sunlit_minutes,sunpercent,37);
+}
 
-		for (minutes=0, eclipses=0; minutes<NUM_MINUTES; minutes++) {
-			predict_orbit(orbital_elements, &orbit, daynum);
+/**
+ * Data for calculating the solar illumination predictions in the worker thread.
+ **/
+struct solar_illumination_schedule {
+	///Orbital elements of the satellite
+	const predict_orbital_elements_t *orbital_elements;
+	///First day
+	predict_julian_date_t start_day;
+	///Number of rows on each page
+	int num_rows;
+	///Number of worker threads, 0 for the number of online CPUs and 1 for calculating in the schedule worker thread
+	int num_threads;
+};
 
-			if (orbit.eclipsed) {
-				eclipses++;
-			}
+/**
+ * Calculate the rows of the solar illumination predictions, page by page. Each page has two columns of consecutive
+ * days. Run by the schedule worker.
+ *
+ * \param worker Schedule worker
+ * \param data Solar illumination schedule
+ **/
+void solar_illumination_calculate(struct schedule_worker *worker, void *data)
+{
+	struct solar_illumination_schedule *schedule = (struct solar_illumination_schedule*)data;
+	char string1[MAX_NUM_CHARS], string2[MAX_NUM_CHARS], string[MAX_NUM_CHARS];
+	bool should_continue = true;
+	bool decayed = false;
+
+	//the days of each page are calculated in parallel from the eclipse intervals, unless only one thread is to be used
+	struct thread_pool *pool = NULL;
+	if (schedule->num_threads != 1) {
+		pool = thread_pool_create(schedule->num_threads);
+	}
 
-			daynum=startday+(oneminute*(double)minutes);
+	int num_rows = schedule->num_rows;
+	int num_days = 2*num_rows;
+	int *sunlit_minutes = (int*)malloc(sizeof(int)*num_days);
+	bool *decayed_days = (bool*)calloc(num_days, sizeof(bool));
+	predict_julian_date_t startday = schedule->start_day;
+	while (should_continue && !decayed) {
+		//one day per worker thread at a time, so that the calculation can be cancelled between the days
+		int num_parallel_days = (pool != NULL) ? pool->num_threads : 1;
+		for (int day=0; (day < num_days) && should_continue; day += num_parallel_days) {
+			int num_calculated_days = (num_days - day < num_parallel_days) ? num_days - day : num_parallel_days;
+			eclipse_sunlit_minutes(pool, schedule->orbital_elements, startday + day, num_calculated_days, sunlit_minutes + day, decayed_days + day);
+			should_continue = !schedule_worker_cancelled(worker);
 		}
 
-		sunpercent=((double)eclipses)/((double)minutes);
-		sunpercent=100.0-(sunpercent*100.0);
-
-		time_t epoch = predict_from_julian(startday);
-		strftime(datestring, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
-		datestring[11]=0;
-
-		sprintf(string1,"      %s    %4d    %6.2f%c",datestring,NUM_MINUTES-eclipses,sunpercent,37);
-
-		/* Allow a quick way out */
-
-		nodelay(stdscr,TRUE);
-
-		if (getch()==27)
-			breakout=1;
-
-		nodelay(stdscr,FALSE);
-
-		startday+= (LINES-8);
-
-		daynum=startday;
-
-		for (minutes=0, eclipses=0; minutes<NUM_MINUTES; minutes++) {
-			predict_orbit(orbital_elements, &orbit, daynum);
-
-			if (orbit.eclipsed) {
-				eclipses++;
+		//days after the decay are marked as such, and the predictions end at the first row that starts with a decayed day
+		for (int row=0; (row < num_rows) && should_continue; row++) {
+			decayed=decayed_days[row];
+			if (decayed) {
+				break;
 			}
-
-			daynum=startday+(oneminute*(double)minutes);
+			solar_illumination_format_day(string1, startday+row, sunlit_minutes[row], false);
+			solar_illumination_format_day(string2, startday+row+num_rows, sunlit_minutes[row+num_rows], decayed_days[row+num_rows]);
+			sprintf(string,"      %s\t %s\n",string1,string2);
+			should_continue = schedule_worker_push(worker, string);
 		}
+		decayed = decayed || decayed_days[num_days-1];
+		startday+=num_days;
+	}
 
-		sunpercent=((double)eclipses)/((double)minutes);
-		sunpercent=100.0-(sunpercent*100.0);
-
-		epoch = predict_from_julian(startday);
-		strftime(datestring, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
-
-		datestring[11]=0;
-		sprintf(string,"%s\t %s    %4d    %6.2f%c\n",string1,datestring,1440-eclipses,sunpercent,37);
-
-		char title[MAX_NUM_CHARS] = {0};
-		sprintf(title, "%s (%d)", name, orbital_elements->satellite_number);
-
-		quit=schedule_print(title,string,'s');
-
-		/* Allow a quick way out */
+	free(sunlit_minutes);
+	free(decayed_days);
+	thread_pool_destroy(&pool);
+}
 
-		nodelay(stdscr,TRUE);
+void solar_illumination_display_predictions(const char *name, predict_orbital_elements_t *orbital_elements, int num_threads)
+{
+	schedule_print("","",0);
 
-		if (getch()==27)
-			breakout=1;
+	predict_julian_date_t startday = floor(prompt_user_for_time(name));
 
-		nodelay(stdscr,FALSE);
+	curs_set(0);
+	clear();
 
-		if (count< (LINES-8))
-			startday-= (LINES-9);
-		else {
-			count=0;
-			startday+=1.0;
-		}
+	char title[MAX_NUM_CHARS] = {0};
+	sprintf(title, "%s (%d)", name, orbital_elements->satellite_number);
+	attrset(COLOR_PAIR(4));
+	mvprintw(1,60, "%s (%d)", name, orbital_elements->satellite_number);
+
+	//days are calculated in a worker thread while the rows are displayed
+	struct solar_illumination_schedule schedule = {.orbital_elements = orbital_elements, .start_day = startday, .num_rows = LINES-8, .num_threads = num_threads};
+	struct schedule_worker *worker = schedule_worker_start(solar_illumination_calculate, &schedule, SCHEDULE_PREFETCH_PAGES*(LINES-8));
+	if (worker == NULL) {
+		schedule_worker_display_error();
+		return;
 	}
-	while (quit!=1 && breakout!=1 && !(orbit.decayed));
+	schedule_worker_display(worker, title, 's');
+	schedule_worker_destroy(&worker);
 }
@@ -1,22 +1,29 @@
 #include <predict/predict.h>
 #include "track_astronomical_bodies.h"
+#include "pass_cache.h"
+#include "pass_sampler.h"
 
 /* This function predicts satellite passes.
  *
  * \param name Name of satellite
  * \param orbital_elements Orbital elements of satellite
  * \param qth QTH at which satellite is to be observed
+ * \param pass_cache Cache of upcoming passes, or NULL
+ * \param tle_index Index of the satellite in the TLE database
+ * \param resolution Resolution of the rows within each pass
+ * \param sun_elevation_limit Sun elevation below which satellites in sunlight are visible, in degrees
  * \param mode 'p' for all passes, 'v' for visible passes only
  **/
-void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, char mode);
+void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, const struct pass_sampler_resolution *resolution, double sun_elevation_limit, char mode);
 
 /**
  * Display solar illumination predictions.
  *
  * \param name Name of satellite
  * \param orbital_elements Orbital elements for satellite
+ * \param num_threads Number of worker threads used for the calculation, 0 for the number of online CPUs
  **/
-void solar_illumination_display_predictions(const char *name, predict_orbital_elements_t *orbital_elements);
+void solar_illumination_display_predictions(const char *name, predict_orbital_elements_t *orbital_elements, int num_threads);
 
 /**
  * Predict passes of sun and moon, similar to Predict().
@@ -0,0 +1,113 @@
+#include "schedule_worker.h"
+#include "defines.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Run the task in the worker thread.
+ *
+ * \param arg Worker
+ * \return NULL
+ **/
+void *schedule_worker_thread(void *arg)
+{
+	struct schedule_worker *worker = (struct schedule_worker*)arg;
+	worker->task(worker, worker->data);
+
+	pthread_mutex_lock(&(worker->lock));
+	worker->finished = true;
+	pthread_mutex_unlock(&(worker->lock));
+	return NULL;
+}
+
+struct schedule_worker *schedule_worker_start(schedule_worker_task_t task, void *data, int queue_size)
+{
+	struct schedule_worker *worker = (struct schedule_worker*)calloc(1, sizeof(struct schedule_worker));
+	worker->queue_size = (queue_size > 0) ? queue_size : 1;
+	worker->rows = (char**)malloc(sizeof(char*)*worker->queue_size);
+	pthread_mutex_init(&(worker->lock), NULL);
+	pthread_cond_init(&(worker->changed), NULL);
+	worker->task = task;
+	worker->data = data;
+
+	if (pthread_create(&(worker->thread), NULL, schedule_worker_thread, worker) != 0) {
+		free(worker->rows);
+		pthread_mutex_destroy(&(worker->lock));
+		pthread_cond_destroy(&(worker->changed));
+		free(worker);
+		return NULL;
+	}
+	return worker;
+}
+
+bool schedule_worker_push(struct schedule_worker *worker, const char *row)
+{
+	pthread_mutex_lock(&(worker->lock));
+	while ((worker->num_rows == worker->queue_size) && !(worker->cancelled)) {
+		pthread_cond_wait(&(worker->changed), &(worker->lock));
+	}
+
+	bool should_continue = !(worker->cancelled);
+	if (should_continue) {
+		int index = (worker->first_row + worker->num_rows) % worker->queue_size;
+		worker->rows[index] = strdup(row);
+		worker->num_rows++;
+	}
+	pthread_mutex_unlock(&(worker->lock));
+	return should_continue;
+}
+
+bool schedule_worker_cancelled(struct schedule_worker *worker)
+{
+	pthread_mutex_lock(&(worker->lock));
+	bool cancelled = worker->cancelled;
+	pthread_mutex_unlock(&(worker->lock));
+	return cancelled;
+}
+
+enum schedule_worker_status schedule_worker_pop(struct schedule_worker *worker, char *row)
+{
+	enum schedule_worker_status status;
+	pthread_mutex_lock(&(worker->lock));
+	if (worker->num_rows > 0) {
+		char *first_row = worker->rows[worker->first_row];
+		strncpy(row, first_row, MAX_NUM_CHARS-1);
+		row[MAX_NUM_CHARS-1] = '\0';
+		free(first_row);
+		worker->first_row = (worker->first_row + 1) % worker->queue_size;
+		worker->num_rows--;
+		pthread_cond_broadcast(&(worker->changed));
+		status = SCHEDULE_WORKER_ROW;
+	} else if (worker->finished) {
+		status = SCHEDULE_WORKER_FINISHED;
+	} else {
+		status = SCHEDULE_WORKER_EMPTY;
+	}
+	pthread_mutex_unlock(&(worker->lock));
+	return status;
+}
+
+void schedule_worker_cancel(struct schedule_worker *worker)
+{
+	pthread_mutex_lock(&(worker->lock));
+	worker->cancelled = true;
+	pthread_cond_broadcast(&(worker->changed));
+	pthread_mutex_unlock(&(worker->lock));
+}
+
+void schedule_worker_destroy(struct schedule_worker **worker)
+{
+	if (*worker == NULL) {
+		return;
+	}
+	schedule_worker_cancel(*worker);
+	pthread_join((*worker)->thread, NULL);
+	for (int i=0; i < (*worker)->num_rows; i++) {
+		free((*worker)->rows[((*worker)->first_row + i) % (*worker)->queue_size]);
+	}
+	free((*worker)->rows);
+	pthread_mutex_destroy(&((*worker)->lock));
+	pthread_cond_destroy(&((*worker)->changed));
+	free(*worker);
+	*worker = NULL;
+}
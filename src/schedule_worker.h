@@ -0,0 +1,120 @@
+#ifndef SCHEDULE_WORKER_H_DEFINED
+#define SCHEDULE_WORKER_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Worker thread for the long-running prediction schedules. The calculation runs in a separate thread and pushes
+ * finished rows into a bounded queue, which the UI thread pops and renders. The worker runs ahead of the UI thread
+ * until the queue is full, so that the next pages are calculated while the current page is shown. The UI thread can
+ * cancel the calculation by setting a flag that the worker checks when pushing rows, so that the calculation itself
+ * does not have to poll the terminal.
+ **/
+
+//Time the UI thread waits for a keypress while no rows are available, in milliseconds
+#define SCHEDULE_WORKER_POLL_INTERVAL 50
+
+struct schedule_worker;
+
+/**
+ * Calculation run by the worker thread.
+ *
+ * \param worker Worker, for pushing rows using schedule_worker_push()
+ * \param data Task data
+ **/
+typedef void (*schedule_worker_task_t)(struct schedule_worker *worker, void *data);
+
+/**
+ * Status returned when popping rows.
+ **/
+enum schedule_worker_status {
+	///A row was popped
+	SCHEDULE_WORKER_ROW,
+	///No rows are available yet
+	SCHEDULE_WORKER_EMPTY,
+	///The calculation has finished, and all rows have been popped
+	SCHEDULE_WORKER_FINISHED
+};
+
+/**
+ * Schedule worker.
+ **/
+struct schedule_worker {
+	///Worker thread
+	pthread_t thread;
+	///Lock protecting the fields below
+	pthread_mutex_t lock;
+	///Signalled when a row is popped or the calculation is cancelled
+	pthread_cond_t changed;
+	///Rows in the queue, as a ring buffer
+	char **rows;
+	///Maximum number of rows in the queue before the worker waits for the UI thread
+	int queue_size;
+	///Index of the first row in the queue
+	int first_row;
+	///Number of rows in the queue
+	int num_rows;
+	///Set by the UI thread to stop the calculation
+	bool cancelled;
+	///Set when the task has returned
+	bool finished;
+	///Task
+	schedule_worker_task_t task;
+	///Task data
+	void *data;
+};
+
+/**
+ * Start calculation in a worker thread. The tasks run until they are cancelled, so they are never run in the calling
+ * thread instead: nobody would pop their rows.
+ *
+ * \param task Task
+ * \param data Task data, has to be valid until the worker has been destroyed
+ * \param queue_size Maximum number of rows the worker can be ahead of the UI thread
+ * \return Worker, or NULL if the worker thread could not be created
+ **/
+struct schedule_worker *schedule_worker_start(schedule_worker_task_t task, void *data, int queue_size);
+
+/**
+ * Push row to the queue. Called from the task. Waits while the queue is full.
+ *
+ * \param worker Worker
+ * \param row Row, copied into the queue
+ * \return True if the calculation should continue, false if it has been cancelled and the task should return
+ **/
+bool schedule_worker_push(struct schedule_worker *worker, const char *row);
+
+/**
+ * Check whether the calculation has been cancelled. Called from the task.
+ *
+ * \param worker Worker
+ * \return True if cancelled, false otherwise
+ **/
+bool schedule_worker_cancelled(struct schedule_worker *worker);
+
+/**
+ * Pop the first row from the queue, without waiting.
+ *
+ * \param worker Worker
+ * \param row Returned row, MAX_NUM_CHARS long. Set only when a row was popped
+ * \return SCHEDULE_WORKER_ROW if a row was popped, SCHEDULE_WORKER_EMPTY if no rows are available yet and SCHEDULE_WORKER_FINISHED if there will be no more rows
+ **/
+enum schedule_worker_status schedule_worker_pop(struct schedule_worker *worker, char *row);
+
+/**
+ * Cancel the calculation. The task returns at the next row it pushes, or the next time it checks
+ * schedule_worker_cancelled().
+ *
+ * \param worker Worker
+ **/
+void schedule_worker_cancel(struct schedule_worker *worker);
+
+/**
+ * Cancel the calculation, wait for the worker thread to finish and free the worker.
+ *
+ * \param worker Worker, set to NULL
+ **/
+void schedule_worker_destroy(struct schedule_worker **worker);
+
+#endif
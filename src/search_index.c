@@ -0,0 +1,177 @@
+#include "search_index.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * Get lower-cased copy of a string.
+ *
+ * \param string String
+ * \return Allocated lower-cased string
+ **/
+char *search_index_lowercase(const char *string)
+{
+	char *ret_string = strdup(string);
+	for (int i=0; ret_string[i] != '\0'; i++) {
+		ret_string[i] = tolower((unsigned char)ret_string[i]);
+	}
+	return ret_string;
+}
+
+/**
+ * Get hash bucket of the trigram starting at the given character.
+ *
+ * \param trigram Pointer to the first of three characters
+ * \return Bucket index
+ **/
+static inline int search_index_bucket(const char *trigram)
+{
+	unsigned int value = ((unsigned char)trigram[0] << 16) | ((unsigned char)trigram[1] << 8) | (unsigned char)trigram[2];
+	return (value*2654435761u) >> 20;
+}
+
+/**
+ * Rebuild the item lists of the trigram buckets from the item texts.
+ *
+ * \param index Search index
+ **/
+void search_index_build(struct search_index *index)
+{
+	//count the items in each bucket, counting each item once
+	int *last_items = (int*)malloc(sizeof(int)*SEARCH_INDEX_NUM_BUCKETS);
+	for (int i=0; i < SEARCH_INDEX_NUM_BUCKETS; i++) {
+		last_items[i] = -1;
+	}
+	int *counts = (int*)calloc(SEARCH_INDEX_NUM_BUCKETS, sizeof(int));
+	for (int item=0; item < index->num_items; item++) {
+		int length = strlen(index->texts[item]);
+		for (int i=0; i + 3 <= length; i++) {
+			int bucket = search_index_bucket(index->texts[item] + i);
+			if (last_items[bucket] != item) {
+				last_items[bucket] = item;
+				counts[bucket]++;
+			}
+		}
+	}
+
+	index->bucket_offsets[0] = 0;
+	for (int i=0; i < SEARCH_INDEX_NUM_BUCKETS; i++) {
+		index->bucket_offsets[i+1] = index->bucket_offsets[i] + counts[i];
+	}
+
+	//fill the buckets, in ascending item order
+	free(index->bucket_items);
+	index->bucket_items = (int*)malloc(sizeof(int)*(index->bucket_offsets[SEARCH_INDEX_NUM_BUCKETS] + 1));
+	for (int i=0; i < SEARCH_INDEX_NUM_BUCKETS; i++) {
+		last_items[i] = -1;
+		counts[i] = 0;
+	}
+	for (int item=0; item < index->num_items; item++) {
+		int length = strlen(index->texts[item]);
+		for (int i=0; i + 3 <= length; i++) {
+			int bucket = search_index_bucket(index->texts[item] + i);
+			if (last_items[bucket] != item) {
+				last_items[bucket] = item;
+				index->bucket_items[index->bucket_offsets[bucket] + counts[bucket]++] = item;
+			}
+		}
+	}
+	free(last_items);
+	free(counts);
+	index->outdated = false;
+}
+
+struct search_index *search_index_create(int num_items)
+{
+	struct search_index *index = (struct search_index*)malloc(sizeof(struct search_index));
+	index->num_items = num_items;
+	index->texts = (char**)malloc(sizeof(char*)*(num_items + 1));
+	for (int i=0; i < num_items; i++) {
+		index->texts[i] = strdup("");
+	}
+	index->outdated = true;
+	index->bucket_offsets = (int*)calloc(SEARCH_INDEX_NUM_BUCKETS + 1, sizeof(int));
+	index->bucket_items = NULL;
+	index->query = NULL;
+	index->matches = NULL;
+	index->num_matches = 0;
+	return index;
+}
+
+void search_index_set_item(struct search_index *index, int item, const char *name, long satellite_number, const char *designator)
+{
+	int length = strlen(name) + strlen(designator) + 32;
+	char *text = (char*)malloc(sizeof(char)*length);
+	snprintf(text, length, "%s\n%ld\n%s", name, satellite_number, designator);
+	free(index->texts[item]);
+	index->texts[item] = search_index_lowercase(text);
+	free(text);
+
+	//the matches of the last search can no longer be narrowed
+	index->outdated = true;
+	free(index->query);
+	index->query = NULL;
+}
+
+const int *search_index_search(struct search_index *index, const char *query, int *num_matches)
+{
+	if (index->outdated) {
+		search_index_build(index);
+	}
+	char *lowercase_query = search_index_lowercase(query);
+
+	//candidates: all items, the matches of the last search when the query contains the last query, or the items in the
+	//smallest trigram bucket of the query, whichever is smallest. NULL means all items.
+	const int *candidates = NULL;
+	int num_candidates = index->num_items;
+	if ((index->query != NULL) && (strstr(lowercase_query, index->query) != NULL)) {
+		candidates = index->matches;
+		num_candidates = index->num_matches;
+	}
+	int length = strlen(lowercase_query);
+	for (int i=0; i + 3 <= length; i++) {
+		int bucket = search_index_bucket(lowercase_query + i);
+		int bucket_size = index->bucket_offsets[bucket+1] - index->bucket_offsets[bucket];
+		if (bucket_size < num_candidates) {
+			candidates = index->bucket_items + index->bucket_offsets[bucket];
+			num_candidates = bucket_size;
+		}
+	}
+
+	//check the candidates
+	int *matches = (int*)malloc(sizeof(int)*(num_candidates + 1));
+	int num_new_matches = 0;
+	for (int i=0; i < num_candidates; i++) {
+		int item = (candidates != NULL) ? candidates[i] : i;
+		if (strstr(index->texts[item], lowercase_query) != NULL) {
+			matches[num_new_matches++] = item;
+		}
+	}
+
+	free(index->matches);
+	index->matches = matches;
+	index->num_matches = num_new_matches;
+	free(index->query);
+	index->query = lowercase_query;
+
+	*num_matches = num_new_matches;
+	return index->matches;
+}
+
+void search_index_destroy(struct search_index **index)
+{
+	if (*index == NULL) {
+		return;
+	}
+	for (int i=0; i < (*index)->num_items; i++) {
+		free((*index)->texts[i]);
+	}
+	free((*index)->texts);
+	free((*index)->bucket_offsets);
+	free((*index)->bucket_items);
+	free((*index)->query);
+	free((*index)->matches);
+	free(*index);
+	*index = NULL;
+}
@@ -0,0 +1,74 @@
+#ifndef SEARCH_INDEX_H_DEFINED
+#define SEARCH_INDEX_H_DEFINED
+
+#include <stdbool.h>
+
+/**
+ * Case-insensitive substring search over the name, satellite number and international designator of a set of
+ * satellites. Used by the search field of the satellite listing. Searches are narrowed using a trigram index, and
+ * using the matches of the previous search when the query is extended, so that the search can be repeated on
+ * every keypress also for large catalogs.
+ **/
+
+//Number of hash buckets for the trigrams
+#define SEARCH_INDEX_NUM_BUCKETS 4096
+
+/**
+ * Search index.
+ **/
+struct search_index {
+	///Number of items
+	int num_items;
+	///Lower-cased searchable text of each item: Name, satellite number and international designator, separated by newlines
+	char **texts;
+	///Whether the trigram lists have to be rebuilt before the next search
+	bool outdated;
+	///Start of the item list of each trigram bucket in `bucket_items`, SEARCH_INDEX_NUM_BUCKETS + 1 elements
+	int *bucket_offsets;
+	///Items containing a trigram in each bucket, in ascending order
+	int *bucket_items;
+	///Lower-cased query of the last search, NULL if none
+	char *query;
+	///Matches of the last search, in ascending order
+	int *matches;
+	///Number of matches of the last search
+	int num_matches;
+};
+
+/**
+ * Create search index with empty items.
+ *
+ * \param num_items Number of items, indexed from 0 to num_items-1
+ * \return Search index
+ **/
+struct search_index *search_index_create(int num_items);
+
+/**
+ * Set searchable fields of an item.
+ *
+ * \param index Search index
+ * \param item Item index
+ * \param name Satellite name
+ * \param satellite_number Satellite number
+ * \param designator International designator, e.g. "98067A"
+ **/
+void search_index_set_item(struct search_index *index, int item, const char *name, long satellite_number, const char *designator);
+
+/**
+ * Search for items containing the query in any of their fields, ignoring case.
+ *
+ * \param index Search index
+ * \param query Query
+ * \param num_matches Returned number of matches
+ * \return Matching items in ascending order, owned by the index and valid until the next call
+ **/
+const int *search_index_search(struct search_index *index, const char *query, int *num_matches);
+
+/**
+ * Free search index.
+ *
+ * \param index Search index
+ **/
+void search_index_destroy(struct search_index **index);
+
+#endif
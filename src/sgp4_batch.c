@@ -0,0 +1,651 @@
+#include "sgp4_batch.h"
+#include <math.h>
+#include <stdlib.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SGP4_BATCH_HAS_AVX2
+#include <immintrin.h>
+#define SGP4_BATCH_AVX2 __attribute__((target("avx2")))
+#endif
+
+//SGP4 model constants, WGS 72 gravity model as in libpredict
+#define XKE 7.43669161E-2
+#define CK2 5.413079E-4
+#define CK4 6.209887E-7
+#define QOMS2T 1.880279E-09
+#define S_DENSITY_PARAM 1.012229
+#define XJ3 -2.53881E-6
+#define AE 1.0
+#define TWO_THIRD (2.0/3.0)
+#define E6A 1.0E-6
+
+//Eccentricity below which the terms dividing by the eccentricity are dropped, as in Spacetrack Report #3 and libpredict
+#define SGP4_BATCH_MIN_ECCENTRICITY 1.0E-4
+
+//Maximum number of iterations when solving Kepler's equation
+#define SGP4_BATCH_KEPLER_ITERATIONS 11
+
+#define MINUTES_PER_DAY 1440.0
+#define SECONDS_PER_DAY 86400.0
+#define EARTH_RADIUS_KM_WGS84 6.378137E3
+
+//number of arrays in struct sgp4_batch_model
+#define SGP4_BATCH_NUM_ARRAYS 41
+
+/**
+ * Reduce angle to [0, 2*pi).
+ *
+ * \param x Angle
+ * \return Reduced angle
+ **/
+static inline double sgp4_batch_fmod2p(double x)
+{
+	double ret_val = fmod(x, 2*M_PI);
+	if (ret_val < 0.0) {
+		ret_val += 2*M_PI;
+	}
+	return ret_val;
+}
+
+/**
+ * Get epoch of orbital elements in the same day numbers as predict_julian_date_t (days since 31Dec79 00:00:00 UTC).
+ *
+ * \param elements Orbital elements
+ * \return Epoch
+ **/
+double sgp4_batch_epoch(const predict_orbital_elements_t *elements)
+{
+	//day 0 of the epoch year, two-digit years as in the TLE
+	int year = elements->epoch_year % 100;
+	year = (year < 57) ? year + 99 : year - 1;
+	double day_zero = floor(365.25*(year - 80.0)) - floor(19.0 + year/100.0) + floor(4.75 + year/400.0) - 16.0 + 13*30 + floor(0.6*13 - 0.3);
+	return day_zero + elements->epoch_day;
+}
+
+/**
+ * Precompute SGP4 model constants of a near-earth element set.
+ *
+ * \param model Model
+ * \param slot Batch slot
+ * \param elements Orbital elements
+ **/
+void sgp4_batch_init_slot(struct sgp4_batch_model *model, int slot, const predict_orbital_elements_t *elements)
+{
+	double bstar = elements->bstar_drag_term/AE;
+	double xincl = elements->inclination*M_PI/180.0;
+	double eo = elements->eccentricity;
+	double omegao = elements->argument_of_perigee*M_PI/180.0;
+	double xmo = elements->mean_anomaly*M_PI/180.0;
+	double xno = elements->mean_motion*2*M_PI/MINUTES_PER_DAY;
+
+	//recover original mean motion and semimajor axis from the input elements
+	double a1 = pow(XKE/xno, TWO_THIRD);
+	double cosio = cos(xincl);
+	double theta2 = cosio*cosio;
+	double x3thm1 = 3*theta2 - 1.0;
+	double eosq = eo*eo;
+	double betao2 = 1.0 - eosq;
+	double betao = sqrt(betao2);
+	double del1 = 1.5*CK2*x3thm1/(a1*a1*betao*betao2);
+	double ao = a1*(1.0 - del1*(0.5*TWO_THIRD + del1*(1.0 + 134.0/81.0*del1)));
+	double delo = 1.5*CK2*x3thm1/(ao*ao*betao*betao2);
+	double xnodp = xno/(1.0 + delo);
+	double aodp = ao/(1.0 - delo);
+
+	//for perigees below 220 km, the equations are truncated to linear variation in sqrt a and quadratic variation in mean anomaly
+	bool simple = (aodp*(1 - eo)/AE) < (220/EARTH_RADIUS_KM_WGS84 + AE);
+
+	//for perigees below 156 km, the values of s and qoms2t are altered
+	double s4 = S_DENSITY_PARAM;
+	double qoms24 = QOMS2T;
+	double perigee = (aodp*(1 - eo) - AE)*EARTH_RADIUS_KM_WGS84;
+	if (perigee < 156.0) {
+		if (perigee <= 98.0) {
+			s4 = 20;
+		} else {
+			s4 = perigee - 78.0;
+		}
+		qoms24 = pow((120 - s4)*AE/EARTH_RADIUS_KM_WGS84, 4);
+		s4 = s4/EARTH_RADIUS_KM_WGS84 + AE;
+	}
+
+	double pinvsq = 1/(aodp*aodp*betao2*betao2);
+	double tsi = 1/(aodp - s4);
+	double eta = aodp*eo*tsi;
+	double etasq = eta*eta;
+	double eeta = eo*eta;
+	double psisq = fabs(1 - etasq);
+	double coef = qoms24*pow(tsi, 4);
+	double coef1 = coef/pow(psisq, 3.5);
+	double c2 = coef1*xnodp*(aodp*(1 + 1.5*etasq + eeta*(4 + etasq)) + 0.75*CK2*tsi/psisq*x3thm1*(8 + 3*etasq*(8 + etasq)));
+	double c1 = bstar*c2;
+	double sinio = sin(xincl);
+	double a3ovk2 = -XJ3/CK2*pow(AE, 3);
+	double c3 = 0;
+	if (eo > SGP4_BATCH_MIN_ECCENTRICITY) {
+		c3 = coef*tsi*a3ovk2*xnodp*AE*sinio/eo;
+	}
+	double x1mth2 = 1 - theta2;
+	double c4 = 2*xnodp*coef1*aodp*betao2*(eta*(2 + 0.5*etasq) + eo*(0.5 + 2*etasq) - 2*CK2*tsi/(aodp*psisq)*(-3*x3thm1*(1 - 2*eeta + etasq*(1.5 - 0.5*eeta)) + 0.75*x1mth2*(2*etasq - eeta*(1 + etasq))*cos(2*omegao)));
+	double c5 = 2*coef1*aodp*betao2*(1 + 2.75*(etasq + eeta) + eeta*etasq);
+	double theta4 = theta2*theta2;
+	double temp1 = 3*CK2*pinvsq*xnodp;
+	double temp2 = temp1*CK2*pinvsq;
+	double temp3 = 1.25*CK4*pinvsq*pinvsq*xnodp;
+	double x1m5th = 1 - 5*theta2;
+	double xhdot1 = -temp1*cosio;
+
+	model->epoch[slot] = sgp4_batch_epoch(elements);
+	model->xmo[slot] = xmo;
+	model->xmdot[slot] = xnodp + 0.5*temp1*betao*x3thm1 + 0.0625*temp2*betao*(13 - 78*theta2 + 137*theta4);
+	model->omegao[slot] = omegao;
+	model->omgdot[slot] = -0.5*temp1*x1m5th + 0.0625*temp2*(7 - 114*theta2 + 395*theta4) + temp3*(3 - 36*theta2 + 49*theta4);
+	model->xnodeo[slot] = elements->right_ascension*M_PI/180.0;
+	model->xnodot[slot] = xhdot1 + (0.5*temp2*(4 - 19*theta2) + 2*temp3*(3 - 7*theta2))*cosio;
+	model->xnodcf[slot] = 3.5*betao2*xhdot1*c1;
+	model->c1[slot] = c1;
+	model->c4bstar[slot] = bstar*c4;
+	model->t2cof[slot] = 1.5*c1;
+	model->eta[slot] = eta;
+	model->delmo[slot] = pow(1 + eta*cos(xmo), 3);
+	model->sinmo[slot] = sin(xmo);
+	model->aodp[slot] = aodp;
+	model->xnodp[slot] = xnodp;
+	model->eo[slot] = eo;
+	model->xlcof[slot] = 0.125*a3ovk2*sinio*(3 + 5*cosio)/(1 + cosio);
+	model->aycof[slot] = 0.25*a3ovk2*sinio;
+	model->xincl[slot] = xincl;
+	model->cosio[slot] = cosio;
+	model->sinio[slot] = sinio;
+	model->x3thm1[slot] = x3thm1;
+	model->x1mth2[slot] = x1mth2;
+	model->x7thm1[slot] = 7*theta2 - 1;
+
+	//the terms dropped for low perigees are set to zero, so that all slots can be propagated using the same equations.
+	//The terms that divide by the eccentricity are also dropped for nearly circular orbits
+	model->omgcof[slot] = 0;
+	model->xmcof[slot] = 0;
+	model->c5bstar[slot] = 0;
+	model->d2[slot] = 0;
+	model->d3[slot] = 0;
+	model->d4[slot] = 0;
+	model->t3cof[slot] = 0;
+	model->t4cof[slot] = 0;
+	model->t5cof[slot] = 0;
+	if (!simple) {
+		double c1sq = c1*c1;
+		double d2 = 4*aodp*tsi*c1sq;
+		double temp = d2*tsi*c1/3;
+		double d3 = (17*aodp + s4)*temp;
+		double d4 = 0.5*temp*aodp*tsi*(221*aodp + 31*s4)*c1;
+		model->omgcof[slot] = bstar*c3*cos(omegao);
+		if (eo > SGP4_BATCH_MIN_ECCENTRICITY) {
+			model->xmcof[slot] = -TWO_THIRD*coef*bstar*AE/eeta;
+		}
+		model->c5bstar[slot] = bstar*c5;
+		model->d2[slot] = d2;
+		model->d3[slot] = d3;
+		model->d4[slot] = d4;
+		model->t3cof[slot] = d2 + 2*c1sq;
+		model->t4cof[slot] = 0.25*(3*d3 + c1*(12*d2 + 10*c1sq));
+		model->t5cof[slot] = 0.2*(3*d4 + 12*c1*d3 + 6*d2*d2 + 15*c1sq*(2*d2 + c1sq));
+	}
+}
+
+struct sgp4_batch *sgp4_batch_create(int num_elements, predict_orbital_elements_t **elements)
+{
+	struct sgp4_batch *batch = (struct sgp4_batch*)calloc(1, sizeof(struct sgp4_batch));
+	batch->num_elements = num_elements;
+	batch->elements = (const predict_orbital_elements_t**)malloc(sizeof(predict_orbital_elements_t*)*(num_elements + 1));
+	batch->slots = (int*)malloc(sizeof(int)*(num_elements + 1));
+	batch->slot_offsets = (int*)malloc(sizeof(int)*(num_elements + 1));
+
+	for (int i=0; i < num_elements; i++) {
+		batch->elements[i] = elements[i];
+		batch->slot_offsets[i] = batch->num_slots;
+		batch->slots[i] = -1;
+		if (elements[i]->ephemeris == EPHEMERIS_SGP4) {
+			batch->slots[i] = batch->num_slots++;
+		}
+	}
+	batch->slot_offsets[num_elements] = batch->num_slots;
+
+	//one contiguous block for all model arrays
+	int num_slots = batch->num_slots + 1;
+	batch->model_data = (double*)calloc(num_slots*SGP4_BATCH_NUM_ARRAYS, sizeof(double));
+	double **arrays[SGP4_BATCH_NUM_ARRAYS] = {&batch->model.epoch, &batch->model.xmo, &batch->model.xmdot, &batch->model.omegao,
+		&batch->model.omgdot, &batch->model.xnodeo, &batch->model.xnodot, &batch->model.xnodcf, &batch->model.c1,
+		&batch->model.d2, &batch->model.d3, &batch->model.d4, &batch->model.c4bstar, &batch->model.c5bstar,
+		&batch->model.t2cof, &batch->model.t3cof, &batch->model.t4cof, &batch->model.t5cof, &batch->model.omgcof,
+		&batch->model.xmcof, &batch->model.eta, &batch->model.delmo, &batch->model.sinmo, &batch->model.aodp,
+		&batch->model.xnodp, &batch->model.eo, &batch->model.xlcof, &batch->model.aycof, &batch->model.xincl,
+		&batch->model.cosio, &batch->model.sinio, &batch->model.x3thm1, &batch->model.x1mth2, &batch->model.x7thm1,
+		&batch->model.position[0], &batch->model.position[1], &batch->model.position[2], &batch->model.velocity[0],
+		&batch->model.velocity[1], &batch->model.velocity[2], &batch->model.phase};
+	for (int i=0; i < SGP4_BATCH_NUM_ARRAYS; i++) {
+		*(arrays[i]) = batch->model_data + i*num_slots;
+	}
+
+	for (int i=0; i < num_elements; i++) {
+		if (batch->slots[i] != -1) {
+			sgp4_batch_init_slot(&(batch->model), batch->slots[i], elements[i]);
+		}
+	}
+
+#ifdef SGP4_BATCH_HAS_AVX2
+	batch->use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+	return batch;
+}
+
+void sgp4_batch_set_context(struct sgp4_batch *batch, const struct ephemeris_context *context)
+{
+	batch->context = *context;
+}
+
+/**
+ * Propagate a single batch slot.
+ *
+ * \param m Model
+ * \param slot Batch slot
+ * \param time Time
+ **/
+void sgp4_batch_propagate_slot(struct sgp4_batch_model *m, int slot, predict_julian_date_t time)
+{
+	int i = slot;
+	double tsince = (time - m->epoch[i])*MINUTES_PER_DAY;
+
+	//update for secular gravity and atmospheric drag
+	double xmdf = m->xmo[i] + m->xmdot[i]*tsince;
+	double omgadf = m->omegao[i] + m->omgdot[i]*tsince;
+	double xnoddf = m->xnodeo[i] + m->xnodot[i]*tsince;
+	double tsq = tsince*tsince;
+	double xnode = xnoddf + m->xnodcf[i]*tsq;
+	double delomg = m->omgcof[i]*tsince;
+	double delmcub = 1 + m->eta[i]*cos(xmdf);
+	double delm = m->xmcof[i]*(delmcub*delmcub*delmcub - m->delmo[i]);
+	double temp = delomg + delm;
+	double xmp = xmdf + temp;
+	double omega = omgadf - temp;
+	double tcube = tsq*tsince;
+	double tfour = tsince*tcube;
+	double tempa = 1 - m->c1[i]*tsince - m->d2[i]*tsq - m->d3[i]*tcube - m->d4[i]*tfour;
+	double tempe = m->c4bstar[i]*tsince + m->c5bstar[i]*(sin(xmp) - m->sinmo[i]);
+	double templ = m->t2cof[i]*tsq + m->t3cof[i]*tcube + tfour*(m->t4cof[i] + tsince*m->t5cof[i]);
+	double a = m->aodp[i]*tempa*tempa;
+	double e = m->eo[i] - tempe;
+	double xl = xmp + omega + xnode + m->xnodp[i]*templ;
+	double beta = sqrt(1 - e*e);
+	double xn = XKE/(a*sqrt(a));
+
+	//long period periodics
+	double axn = e*cos(omega);
+	temp = 1/(a*beta*beta);
+	double xll = temp*m->xlcof[i]*axn;
+	double aynl = temp*m->aycof[i];
+	double xlt = xl + xll;
+	double ayn = e*sin(omega) + aynl;
+
+	//solve Kepler's equation
+	double capu = sgp4_batch_fmod2p(xlt - xnode);
+	double temp2 = capu;
+	double sinepw = 0, cosepw = 0;
+	for (int iteration=0; iteration < SGP4_BATCH_KEPLER_ITERATIONS; iteration++) {
+		sinepw = sin(temp2);
+		cosepw = cos(temp2);
+		double epw = (capu - ayn*cosepw + axn*sinepw - temp2)/(1 - axn*cosepw - ayn*sinepw) + temp2;
+		if (fabs(epw - temp2) <= E6A) {
+			break;
+		}
+		temp2 = epw;
+	}
+
+	//short period preliminary quantities
+	double ecose = axn*cosepw + ayn*sinepw;
+	double esine = axn*sinepw - ayn*cosepw;
+	double elsq = axn*axn + ayn*ayn;
+	temp = 1 - elsq;
+	double pl = a*temp;
+	double r = a*(1 - ecose);
+	double temp1 = 1/r;
+	double rdot = XKE*sqrt(a)*esine*temp1;
+	double rfdot = XKE*sqrt(pl)*temp1;
+	temp2 = a*temp1;
+	double betal = sqrt(temp);
+	double temp3 = 1/(1 + betal);
+	double cosu = temp2*(cosepw - axn + ayn*esine*temp3);
+	double sinu = temp2*(sinepw - ayn - axn*esine*temp3);
+	double u = atan2(sinu, cosu);
+	double sin2u = 2*sinu*cosu;
+	double cos2u = 2*cosu*cosu - 1;
+	temp = 1/pl;
+	temp1 = CK2*temp;
+	temp2 = temp1*temp;
+
+	//update for short periodics
+	double rk = r*(1 - 1.5*temp2*betal*m->x3thm1[i]) + 0.5*temp1*m->x1mth2[i]*cos2u;
+	double uk = u - 0.25*temp2*m->x7thm1[i]*sin2u;
+	double xnodek = xnode + 1.5*temp2*m->cosio[i]*sin2u;
+	double xinck = m->xincl[i] + 1.5*temp2*m->cosio[i]*m->sinio[i]*cos2u;
+	double rdotk = rdot - xn*temp1*m->x1mth2[i]*sin2u;
+	double rfdotk = rfdot + xn*temp1*(m->x1mth2[i]*cos2u + 1.5*m->x3thm1[i]);
+
+	//orientation vectors
+	double sinuk = sin(uk);
+	double cosuk = cos(uk);
+	double sinik = sin(xinck);
+	double cosik = cos(xinck);
+	double sinnok = sin(xnodek);
+	double cosnok = cos(xnodek);
+	double xmx = -sinnok*cosik;
+	double xmy = cosnok*cosik;
+	double ux = xmx*sinuk + cosnok*cosuk;
+	double uy = xmy*sinuk + sinnok*cosuk;
+	double uz = sinik*sinuk;
+	double vx = xmx*cosuk - cosnok*sinuk;
+	double vy = xmy*cosuk - sinnok*sinuk;
+	double vz = sinik*cosuk;
+
+	//position and velocity in km and km/s
+	const double velocity_scale = EARTH_RADIUS_KM_WGS84*MINUTES_PER_DAY/SECONDS_PER_DAY;
+	m->position[0][i] = rk*ux*EARTH_RADIUS_KM_WGS84;
+	m->position[1][i] = rk*uy*EARTH_RADIUS_KM_WGS84;
+	m->position[2][i] = rk*uz*EARTH_RADIUS_KM_WGS84;
+	m->velocity[0][i] = (rdotk*ux + rfdotk*vx)*velocity_scale;
+	m->velocity[1][i] = (rdotk*uy + rfdotk*vy)*velocity_scale;
+	m->velocity[2][i] = (rdotk*uz + rfdotk*vz)*velocity_scale;
+	m->phase[i] = xlt - xnode - omgadf + 2*M_PI;
+}
+
+#ifdef SGP4_BATCH_HAS_AVX2
+
+//pi/4 split into three parts for exact range reduction (from Cephes)
+#define SGP4_BATCH_DP1 7.85398125648498535156E-1
+#define SGP4_BATCH_DP2 3.77489470793079817668E-8
+#define SGP4_BATCH_DP3 2.69515142907905952645E-15
+
+/**
+ * Select between vectors.
+ *
+ * \param mask Lane mask (all bits set for true)
+ * \param a Values where mask is false
+ * \param b Values where mask is true
+ * \return Selected values
+ **/
+static inline SGP4_BATCH_AVX2 __m256d sgp4_batch_v_select(__m256d mask, __m256d a, __m256d b)
+{
+	return _mm256_blendv_pd(a, b, mask);
+}
+
+/**
+ * Vectorized sine and cosine, accurate to a few ULPs for |x| < 2^29. Polynomials from Cephes.
+ *
+ * \param x Angles
+ * \param ret_sin Returned sines
+ * \param ret_cos Returned cosines
+ **/
+static inline SGP4_BATCH_AVX2 void sgp4_batch_v_sincos(__m256d x, __m256d *ret_sin, __m256d *ret_cos)
+{
+	const __m256d sign_bit = _mm256_set1_pd(-0.0);
+	__m256d sign = _mm256_and_pd(x, sign_bit);
+	__m256d ax = _mm256_andnot_pd(sign_bit, x);
+
+	//reduce to [-pi/4, pi/4] around the nearest multiple of pi/2
+	__m128i j = _mm256_cvttpd_epi32(ax*(4.0/M_PI));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	__m256d y = _mm256_cvtepi32_pd(j);
+	__m256d z = ((ax - y*SGP4_BATCH_DP1) - y*SGP4_BATCH_DP2) - y*SGP4_BATCH_DP3;
+	__m256i quadrant = _mm256_cvtepi32_epi64(_mm_srli_epi32(j, 1));
+
+	__m256d zz = z*z;
+	__m256d sin_z = z + z*zz*(((((1.58962301576546568060E-10*zz - 2.50507477628578072866E-8)*zz + 2.75573136213857245213E-6)*zz - 1.98412698295895385996E-4)*zz + 8.33333333332211858878E-3)*zz - 1.66666666666666307295E-1);
+	__m256d cos_z = 1.0 - 0.5*zz + zz*zz*(((((-1.13585365213876817300E-11*zz + 2.08757008419747316778E-9)*zz - 2.75573141792967388112E-7)*zz + 2.48015872888517045348E-5)*zz - 1.38888888888730564116E-3)*zz + 4.16666666666665929218E-2);
+
+	//odd quadrants swap sine and cosine, sine is negative in quadrants 2 and 3, cosine in quadrants 1 and 2
+	const __m256i one = _mm256_set1_epi64x(1);
+	const __m256i two = _mm256_set1_epi64x(2);
+	__m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quadrant, one), one));
+	__m256d sin_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(quadrant, two), 62));
+	__m256d cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(quadrant, one), two), 62));
+	*ret_sin = _mm256_xor_pd(_mm256_xor_pd(sgp4_batch_v_select(swap, sin_z, cos_z), sin_sign), sign);
+	*ret_cos = _mm256_xor_pd(sgp4_batch_v_select(swap, cos_z, sin_z), cos_sign);
+}
+
+/**
+ * Vectorized cosine.
+ **/
+static inline SGP4_BATCH_AVX2 __m256d sgp4_batch_v_cos(__m256d x)
+{
+	__m256d ret_sin, ret_cos;
+	sgp4_batch_v_sincos(x, &ret_sin, &ret_cos);
+	return ret_cos;
+}
+
+/**
+ * Vectorized sine.
+ **/
+static inline SGP4_BATCH_AVX2 __m256d sgp4_batch_v_sin(__m256d x)
+{
+	__m256d ret_sin, ret_cos;
+	sgp4_batch_v_sincos(x, &ret_sin, &ret_cos);
+	return ret_sin;
+}
+
+/**
+ * Vectorized atan2(), accurate to a few ULPs. Rational approximation from Cephes.
+ *
+ * \param y Y coordinates
+ * \param x X coordinates
+ * \return Angles
+ **/
+static inline SGP4_BATCH_AVX2 __m256d sgp4_batch_v_atan2(__m256d y, __m256d x)
+{
+	const __m256d sign_bit = _mm256_set1_pd(-0.0);
+	const __m256d zero = _mm256_setzero_pd();
+	const double morebits = 6.123233995736765886130E-17;
+	__m256d t = y/x;
+	__m256d t_sign = _mm256_and_pd(t, sign_bit);
+	__m256d at = _mm256_andnot_pd(sign_bit, t);
+
+	//range reduction
+	__m256d big = _mm256_cmp_pd(at, _mm256_set1_pd(2.41421356237309504880), _CMP_GT_OQ);
+	__m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(at, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+	__m256d offset = sgp4_batch_v_select(big, sgp4_batch_v_select(mid, zero, _mm256_set1_pd(M_PI/4)), _mm256_set1_pd(M_PI/2));
+	__m256d correction = sgp4_batch_v_select(big, sgp4_batch_v_select(mid, zero, _mm256_set1_pd(0.5*morebits)), _mm256_set1_pd(morebits));
+	__m256d xr = sgp4_batch_v_select(big, sgp4_batch_v_select(mid, at, (at - 1.0)/(at + 1.0)), -1.0/at);
+
+	__m256d z = xr*xr;
+	__m256d p = (((-8.750608600031904122785E-1*z - 1.615753718733365076637E1)*z - 7.500855792314704667340E1)*z - 1.228866684490136173410E2)*z - 6.485021904942025371773E1;
+	__m256d q = ((((z + 2.485846490142306297962E1)*z + 1.650270098316988542046E2)*z + 4.328810604912902668951E2)*z + 4.853903996359136964868E2)*z + 1.945506571482613964425E2;
+	__m256d ret = offset + (xr*z*p/q + xr + correction);
+	ret = _mm256_xor_pd(ret, t_sign);
+
+	//add +/- pi for the left half-plane
+	__m256d left = _mm256_cmp_pd(x, zero, _CMP_LT_OQ);
+	__m256d pi = _mm256_or_pd(_mm256_set1_pd(M_PI), _mm256_and_pd(y, sign_bit));
+	return ret + _mm256_and_pd(left, pi);
+}
+
+/**
+ * Vectorized version of sgp4_batch_propagate_slot(), propagating SGP4_BATCH_WIDTH consecutive slots.
+ *
+ * \param m Model
+ * \param slot First batch slot
+ * \param time Time
+ **/
+static SGP4_BATCH_AVX2 void sgp4_batch_propagate_avx2(struct sgp4_batch_model *m, int slot, predict_julian_date_t time)
+{
+	#define LOAD(array) _mm256_loadu_pd(m->array + slot)
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d sign_bit = _mm256_set1_pd(-0.0);
+	const __m256d two_pi = _mm256_set1_pd(2*M_PI);
+
+	__m256d tsince = (_mm256_set1_pd(time) - LOAD(epoch))*MINUTES_PER_DAY;
+
+	//update for secular gravity and atmospheric drag
+	__m256d xmdf = LOAD(xmo) + LOAD(xmdot)*tsince;
+	__m256d omgadf = LOAD(omegao) + LOAD(omgdot)*tsince;
+	__m256d xnoddf = LOAD(xnodeo) + LOAD(xnodot)*tsince;
+	__m256d tsq = tsince*tsince;
+	__m256d xnode = xnoddf + LOAD(xnodcf)*tsq;
+	__m256d delomg = LOAD(omgcof)*tsince;
+	__m256d delmcub = one + LOAD(eta)*sgp4_batch_v_cos(xmdf);
+	__m256d delm = LOAD(xmcof)*(delmcub*delmcub*delmcub - LOAD(delmo));
+	__m256d temp = delomg + delm;
+	__m256d xmp = xmdf + temp;
+	__m256d omega = omgadf - temp;
+	__m256d tcube = tsq*tsince;
+	__m256d tfour = tsince*tcube;
+	__m256d tempa = one - LOAD(c1)*tsince - LOAD(d2)*tsq - LOAD(d3)*tcube - LOAD(d4)*tfour;
+	__m256d tempe = LOAD(c4bstar)*tsince + LOAD(c5bstar)*(sgp4_batch_v_sin(xmp) - LOAD(sinmo));
+	__m256d templ = LOAD(t2cof)*tsq + LOAD(t3cof)*tcube + tfour*(LOAD(t4cof) + tsince*LOAD(t5cof));
+	__m256d a = LOAD(aodp)*tempa*tempa;
+	__m256d e = LOAD(eo) - tempe;
+	__m256d xl = xmp + omega + xnode + LOAD(xnodp)*templ;
+	__m256d beta = _mm256_sqrt_pd(one - e*e);
+	__m256d xn = XKE/(a*_mm256_sqrt_pd(a));
+
+	//long period periodics
+	__m256d sin_omega, cos_omega;
+	sgp4_batch_v_sincos(omega, &sin_omega, &cos_omega);
+	__m256d axn = e*cos_omega;
+	temp = one/(a*beta*beta);
+	__m256d xll = temp*LOAD(xlcof)*axn;
+	__m256d aynl = temp*LOAD(aycof);
+	__m256d xlt = xl + xll;
+	__m256d ayn = e*sin_omega + aynl;
+
+	//solve Kepler's equation, lanes stop iterating independently when converged
+	__m256d capu = xlt - xnode;
+	capu = capu - two_pi*_mm256_floor_pd(capu/two_pi);
+	__m256d temp2 = capu;
+	__m256d sinepw = _mm256_setzero_pd(), cosepw = _mm256_setzero_pd();
+	__m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	for (int iteration=0; iteration < SGP4_BATCH_KEPLER_ITERATIONS; iteration++) {
+		__m256d sin_temp2, cos_temp2;
+		sgp4_batch_v_sincos(temp2, &sin_temp2, &cos_temp2);
+		sinepw = sgp4_batch_v_select(active, sinepw, sin_temp2);
+		cosepw = sgp4_batch_v_select(active, cosepw, cos_temp2);
+		__m256d epw = (capu - ayn*cos_temp2 + axn*sin_temp2 - temp2)/(one - axn*cos_temp2 - ayn*sin_temp2) + temp2;
+		__m256d converged = _mm256_cmp_pd(_mm256_andnot_pd(sign_bit, epw - temp2), _mm256_set1_pd(E6A), _CMP_LE_OQ);
+		active = _mm256_andnot_pd(converged, active);
+		temp2 = sgp4_batch_v_select(active, temp2, epw);
+		if (_mm256_movemask_pd(active) == 0) {
+			break;
+		}
+	}
+
+	//short period preliminary quantities
+	__m256d ecose = axn*cosepw + ayn*sinepw;
+	__m256d esine = axn*sinepw - ayn*cosepw;
+	__m256d elsq = axn*axn + ayn*ayn;
+	temp = one - elsq;
+	__m256d pl = a*temp;
+	__m256d r = a*(one - ecose);
+	__m256d temp1 = one/r;
+	__m256d rdot = XKE*_mm256_sqrt_pd(a)*esine*temp1;
+	__m256d rfdot = XKE*_mm256_sqrt_pd(pl)*temp1;
+	temp2 = a*temp1;
+	__m256d betal = _mm256_sqrt_pd(temp);
+	__m256d temp3 = one/(one + betal);
+	__m256d cosu = temp2*(cosepw - axn + ayn*esine*temp3);
+	__m256d sinu = temp2*(sinepw - ayn - axn*esine*temp3);
+	__m256d u = sgp4_batch_v_atan2(sinu, cosu);
+	__m256d sin2u = 2.0*sinu*cosu;
+	__m256d cos2u = 2.0*cosu*cosu - one;
+	temp = one/pl;
+	temp1 = CK2*temp;
+	temp2 = temp1*temp;
+
+	//update for short periodics
+	__m256d rk = r*(one - 1.5*temp2*betal*LOAD(x3thm1)) + 0.5*temp1*LOAD(x1mth2)*cos2u;
+	__m256d uk = u - 0.25*temp2*LOAD(x7thm1)*sin2u;
+	__m256d xnodek = xnode + 1.5*temp2*LOAD(cosio)*sin2u;
+	__m256d xinck = LOAD(xincl) + 1.5*temp2*LOAD(cosio)*LOAD(sinio)*cos2u;
+	__m256d rdotk = rdot - xn*temp1*LOAD(x1mth2)*sin2u;
+	__m256d rfdotk = rfdot + xn*temp1*(LOAD(x1mth2)*cos2u + 1.5*LOAD(x3thm1));
+
+	//orientation vectors
+	__m256d sinuk, cosuk, sinik, cosik, sinnok, cosnok;
+	sgp4_batch_v_sincos(uk, &sinuk, &cosuk);
+	sgp4_batch_v_sincos(xinck, &sinik, &cosik);
+	sgp4_batch_v_sincos(xnodek, &sinnok, &cosnok);
+	__m256d xmx = -sinnok*cosik;
+	__m256d xmy = cosnok*cosik;
+	__m256d ux = xmx*sinuk + cosnok*cosuk;
+	__m256d uy = xmy*sinuk + sinnok*cosuk;
+	__m256d uz = sinik*sinuk;
+	__m256d vx = xmx*cosuk - cosnok*sinuk;
+	__m256d vy = xmy*cosuk - sinnok*sinuk;
+	__m256d vz = sinik*cosuk;
+
+	//position and velocity in km and km/s
+	const double velocity_scale = EARTH_RADIUS_KM_WGS84*MINUTES_PER_DAY/SECONDS_PER_DAY;
+	_mm256_storeu_pd(m->position[0] + slot, rk*ux*EARTH_RADIUS_KM_WGS84);
+	_mm256_storeu_pd(m->position[1] + slot, rk*uy*EARTH_RADIUS_KM_WGS84);
+	_mm256_storeu_pd(m->position[2] + slot, rk*uz*EARTH_RADIUS_KM_WGS84);
+	_mm256_storeu_pd(m->velocity[0] + slot, (rdotk*ux + rfdotk*vx)*velocity_scale);
+	_mm256_storeu_pd(m->velocity[1] + slot, (rdotk*uy + rfdotk*vy)*velocity_scale);
+	_mm256_storeu_pd(m->velocity[2] + slot, (rdotk*uz + rfdotk*vz)*velocity_scale);
+	_mm256_storeu_pd(m->phase + slot, xlt - xnode - omgadf + 2*M_PI);
+	#undef LOAD
+}
+#endif
+
+void sgp4_batch_propagate(struct sgp4_batch *batch, int start, int end)
+{
+	int slot = batch->slot_offsets[start];
+	int end_slot = batch->slot_offsets[end];
+
+#ifdef SGP4_BATCH_HAS_AVX2
+	if (batch->use_avx2) {
+		for (; slot + SGP4_BATCH_WIDTH <= end_slot; slot += SGP4_BATCH_WIDTH) {
+			sgp4_batch_propagate_avx2(&(batch->model), slot, batch->context.time);
+		}
+	}
+#endif
+
+	//remaining slots
+	for (; slot < end_slot; slot++) {
+		sgp4_batch_propagate_slot(&(batch->model), slot, batch->context.time);
+	}
+}
+
+bool sgp4_batch_orbit(const struct sgp4_batch *batch, int index, struct predict_position *orbit)
+{
+	int slot = batch->slots[index];
+	if (slot == -1) {
+		return false;
+	}
+	const struct sgp4_batch_model *m = &(batch->model);
+	const predict_orbital_elements_t *elements = batch->elements[index];
+
+	orbit->time = batch->context.time;
+	orbit->orbital_elements = elements;
+	for (int i=0; i < 3; i++) {
+		orbit->position[i] = m->position[i][slot];
+		orbit->velocity[i] = m->velocity[i][slot];
+	}
+	orbit->phase = sgp4_batch_fmod2p(m->phase[slot]);
+
+	ephemeris_context_geodetic_position(&(batch->context), orbit);
+
+	//revolutions and decay, as in predict_orbit() and predict_decayed()
+	double age = batch->context.time - m->epoch[slot];
+	orbit->revolutions = (long)floor((elements->mean_motion + age*elements->bstar_drag_term)*age + elements->mean_anomaly/360.0) + elements->revolutions_at_epoch;
+	orbit->decayed = (m->epoch[slot] + (16.666666 - elements->mean_motion)/(10.0*fabs(elements->derivative_mean_motion))) < batch->context.time;
+	return true;
+}
+
+void sgp4_batch_destroy(struct sgp4_batch **batch)
+{
+	if (*batch == NULL) {
+		return;
+	}
+	free((*batch)->elements);
+	free((*batch)->slots);
+	free((*batch)->slot_offsets);
+	free((*batch)->model_data);
+	free(*batch);
+	*batch = NULL;
+}
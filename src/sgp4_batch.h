@@ -0,0 +1,145 @@
+#ifndef SGP4_BATCH_H_DEFINED
+#define SGP4_BATCH_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+#include "ephemeris_context.h"
+
+/**
+ * Batch propagation of near-earth (SGP4) orbital elements. The SGP4 model constants of all near-earth element
+ * sets are precomputed and stored as structure-of-arrays, and all satellites are propagated to the same time
+ * in one pass, four at a time using AVX2 when the CPU supports it, and one at a time otherwise. Deep-space
+ * (SDP4) element sets are not part of the batch, and have to be propagated using predict_orbit().
+ *
+ * The same model as libpredict is used, and the resulting orbits agree with predict_orbit() to within
+ * SGP4_BATCH_POSITION_TOLERANCE and SGP4_BATCH_VELOCITY_TOLERANCE. The difference is caused by the vectorized
+ * sine, cosine and arctangent, and by the order of the floating point operations.
+ **/
+
+//Maximum difference in position from predict_orbit(), in km
+#define SGP4_BATCH_POSITION_TOLERANCE 1.0E-3
+
+//Maximum difference in velocity from predict_orbit(), in km/s
+#define SGP4_BATCH_VELOCITY_TOLERANCE 1.0E-6
+
+//Number of satellites propagated at a time by the vectorized kernel
+#define SGP4_BATCH_WIDTH 4
+
+/**
+ * Precomputed SGP4 model constants and propagation results. One array per quantity, with one entry per batch
+ * slot. Names follow the original SGP4 implementation.
+ **/
+struct sgp4_batch_model {
+	///Epoch, in the same day numbers as predict_julian_date_t
+	double *epoch;
+	///Mean anomaly at epoch
+	double *xmo;
+	///Secular rate of the mean anomaly
+	double *xmdot;
+	///Argument of perigee at epoch
+	double *omegao;
+	///Secular rate of the argument of perigee
+	double *omgdot;
+	///Right ascension of the ascending node at epoch
+	double *xnodeo;
+	///Secular rate of the right ascension of the ascending node
+	double *xnodot;
+	///Drag coefficient of the right ascension of the ascending node
+	double *xnodcf;
+	///Drag coefficients of the semimajor axis
+	double *c1, *d2, *d3, *d4;
+	///BSTAR multiplied by the C4 and C5 drag coefficients
+	double *c4bstar, *c5bstar;
+	///Drag coefficients of the mean longitude
+	double *t2cof, *t3cof, *t4cof, *t5cof;
+	///Drag coefficients of the argument of perigee and the mean anomaly
+	double *omgcof, *xmcof;
+	///Eta, (1 + eta*cos(xmo))^3 and sin(xmo)
+	double *eta, *delmo, *sinmo;
+	///Recovered semimajor axis and mean motion
+	double *aodp, *xnodp;
+	///Eccentricity at epoch
+	double *eo;
+	///Long period periodic coefficients
+	double *xlcof, *aycof;
+	///Inclination at epoch, and functions of it
+	double *xincl, *cosio, *sinio, *x3thm1, *x1mth2, *x7thm1;
+	///Propagated position in km, TEME frame
+	double *position[3];
+	///Propagated velocity in km/s, TEME frame
+	double *velocity[3];
+	///Propagated orbital phase
+	double *phase;
+};
+
+/**
+ * Batch of orbital elements propagated together.
+ **/
+struct sgp4_batch {
+	///Number of orbital elements the batch was created from
+	int num_elements;
+	///Orbital elements, owned by the caller
+	const predict_orbital_elements_t **elements;
+	///Batch slot of each orbital element, -1 for element sets that are not near-earth
+	int *slots;
+	///Number of batch slots before each orbital element, num_elements + 1 entries
+	int *slot_offsets;
+	///Number of batch slots (i.e. number of near-earth element sets)
+	int num_slots;
+	///Model constants and results
+	struct sgp4_batch_model model;
+	///Memory backing the arrays in `model`
+	double *model_data;
+	///Whether the AVX2 kernel is used. Set according to the CPU in sgp4_batch_create()
+	bool use_avx2;
+	///Time and sun position set using sgp4_batch_set_context()
+	struct ephemeris_context context;
+};
+
+/**
+ * Create batch from orbital elements. Only near-earth element sets are included in the batch, the others
+ * are skipped.
+ *
+ * \param num_elements Number of orbital elements
+ * \param elements Orbital elements. Pointers are kept, and have to be valid for the lifetime of the batch
+ * \return Batch
+ **/
+struct sgp4_batch *sgp4_batch_create(int num_elements, predict_orbital_elements_t **elements);
+
+/**
+ * Set the time the batch is propagated to in subsequent calls to sgp4_batch_propagate(). The sidereal time and
+ * the sun position of the context are used for the geodetic positions and the eclipse checks.
+ *
+ * \param batch Batch
+ * \param context Ephemeris context at the time the batch should be propagated to, copied into the batch
+ **/
+void sgp4_batch_set_context(struct sgp4_batch *batch, const struct ephemeris_context *context);
+
+/**
+ * Propagate a range of the orbital elements to the time set using sgp4_batch_set_context(). Different ranges
+ * can be propagated concurrently from different threads.
+ *
+ * \param batch Batch
+ * \param start First orbital element index
+ * \param end Orbital element index after the last one to propagate
+ **/
+void sgp4_batch_propagate(struct sgp4_batch *batch, int start, int end);
+
+/**
+ * Get the propagated orbit of an orbital element, in the same form as predict_orbit().
+ *
+ * \param batch Batch
+ * \param index Orbital element index
+ * \param orbit Returned orbit
+ * \return True if the orbit was propagated by the batch, false if the orbital element is not near-earth and has to be propagated using predict_orbit()
+ **/
+bool sgp4_batch_orbit(const struct sgp4_batch *batch, int index, struct predict_position *orbit);
+
+/**
+ * Free batch.
+ *
+ * \param batch Batch
+ **/
+void sgp4_batch_destroy(struct sgp4_batch **batch);
+
+#endif
@@ -141,15 +141,17 @@ void singletrack_handle_transponder_key(struct singletrack_link *link_status, in
  *
  * \param satellite_name Satellite name
  * \param qth Ground station
+ * \param pass_cache Cache of upcoming passes
+ * \param tle_index Index of the tracked satellite in the TLE database
  * \param orbital_elements Orbital elements for tracked satellite
  * \param satellite_transponders Satellite transponders
  * \param rotctld Rotctld connection
  * \param downlink_info Downlink rigctld connection
  * \param uplink_info Uplink rigctld connection
  **/
-int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
+int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
 
-void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *sat_db, struct tle_db *tle_db, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
+void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *sat_db, struct tle_db *tle_db, struct pass_cache *pass_cache, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
 {
 	struct sat_db_entry *sat_db_entries = sat_db->sats;
 	struct tle_db_entry *tle_db_entries = tle_db->tles;
@@ -162,8 +164,7 @@ void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *
 		struct sat_db_entry satellite_transponders = sat_db_entries[orbit_ind];
 
 		//track satellite until keyboard input breaks the loop
-		input_key = singletrack_track_satellite(satellite_name, qth, orbital_elements, satellite_transponders, rotctld, downlink_info, uplink_info);
-		predict_destroy_orbital_elements(orbital_elements);
+		input_key = singletrack_track_satellite(satellite_name, qth, pass_cache, orbit_ind, orbital_elements, satellite_transponders, rotctld, downlink_info, uplink_info);
 
 		//handle keyboard input not handled by singletrack_track_satellite(...):
 		//track next satellite
@@ -708,7 +709,7 @@ void singletrack_handle_transponder_key(struct singletrack_link *link_status, in
 //column for QTH box
 #define QTH_COLUMN (MOON_COLUMN + SUN_MOON_COLUMN_DIFF)
 
-int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
+int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, struct pass_cache *pass_cache, int tle_index, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
 {
 	int input_key;
 	int    transponder_index=0;
@@ -717,9 +718,9 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 	link_status.uplink_update = true;
 	link_status.readfreq = false;
 
-	struct predict_observation aos = {0};
-	struct predict_observation los = {0};
-	struct predict_observation max_elevation = {0};
+	//current or next pass, and the next pass with AOS in the future
+	struct pass_cache_pass current_pass = {0};
+	struct pass_cache_pass next_pass = {0};
 
 	char ephemeris_string[MAX_NUM_CHARS];
 
@@ -777,20 +778,24 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 		time_t epoch = time(NULL);
 		daynum = predict_to_julian(epoch);
 		predict_orbit(orbital_elements, &orbit, daynum);
+		struct ephemeris_context context;
+		ephemeris_context_update(&context, qth, daynum);
+		ephemeris_context_update_moon(&context);
 		struct predict_observation obs;
-		predict_observe_orbit(qth, &orbit, &obs);
+		ephemeris_context_observe_orbit(&context, &orbit, &obs);
 		double squint = predict_squint_angle(qth, &orbit, satellite_transponders.alon, satellite_transponders.alat);
 
 		//update pass information
-		if (!decayed && aos_happens && !geosynchronous && (daynum > los.time)) {
-			//aos of next pass
-			aos = predict_next_aos(qth, orbital_elements, daynum);
-
-			//los of current or next pass
-			los = predict_next_los(qth, orbital_elements, daynum);
+		if (!decayed && aos_happens && !geosynchronous && (daynum > current_pass.los_time)) {
+			//los and max elevation of current or next pass
+			pass_cache_current_pass(pass_cache, tle_index, qth, orbital_elements, daynum, &current_pass);
 
-			//max elevation of current or next pass
-			max_elevation = predict_at_max_elevation(qth, orbital_elements, daynum);
+			//aos of next pass
+			if (current_pass.aos_time > daynum) {
+				next_pass = current_pass;
+			} else {
+				pass_cache_next_pass(pass_cache, tle_index, qth, orbital_elements, daynum, &next_pass);
+			}
 		}
 
 		//display current time
@@ -815,29 +820,29 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 		} else if (decayed || !aos_happens || (geosynchronous && (obs.elevation<0.0))){
 			mvprintw(AOSLOS_INFORMATION_ROW,1,"This satellite never reaches AOS");
 		} else if (obs.elevation >= 0.0) {
-			time_t epoch = predict_from_julian(los.time);
+			time_t epoch = predict_from_julian(current_pass.los_time);
 			strftime(time_string, MAX_NUM_CHARS, "%H:%M:%S", gmtime(&epoch));
-			mvprintw(AOSLOS_INFORMATION_ROW,1,"LOS at:   %s UTC (%0.f Az)   ",time_string,los.azimuth*RAD2DEG);
+			mvprintw(AOSLOS_INFORMATION_ROW,1,"LOS at:   %s UTC (%0.f Az)   ",time_string,current_pass.los_azimuth*RAD2DEG);
 		} else if (obs.elevation < 0.0) {
-			time_t epoch = predict_from_julian(aos.time);
+			time_t epoch = predict_from_julian(next_pass.aos_time);
 			strftime(time_string, MAX_NUM_CHARS, "%H:%M:%S", gmtime(&epoch));
-			mvprintw(AOSLOS_INFORMATION_ROW,1,"Next AOS: %s UTC (%0.f Az)   ",time_string, aos.azimuth*RAD2DEG);
+			mvprintw(AOSLOS_INFORMATION_ROW,1,"Next AOS: %s UTC (%0.f Az)   ",time_string, next_pass.aos_azimuth*RAD2DEG);
 		}
 
 		//display max elevation information
 		if (!geosynchronous && !decayed && aos_happens) {
 			//max elevation time
-			time_t epoch = predict_from_julian(max_elevation.time);
+			time_t epoch = predict_from_julian(current_pass.tca_time);
 			char time_string[MAX_NUM_CHARS];
 			strftime(time_string, MAX_NUM_CHARS, "%H:%M:%S UTC", gmtime(&epoch));
 
 			//pass properties
-			mvprintw(MAXELE_INFORMATION_ROW, 1, "Max ele   %s (%0.f Az, %2.f El)", time_string, max_elevation.azimuth*RAD2DEG, max_elevation.elevation*RAD2DEG);
+			mvprintw(MAXELE_INFORMATION_ROW, 1, "Max ele   %s (%0.f Az, %2.f El)", time_string, current_pass.tca_azimuth*RAD2DEG, current_pass.max_elevation*RAD2DEG);
 		}
 
-		//predict and observe sun and moon
-		print_sun_box(SUN_MOON_ROW, SUN_COLUMN, qth, daynum);
-		print_moon_box(SUN_MOON_ROW, MOON_COLUMN, qth, daynum);
+		//display sun and moon, observed along with the satellite
+		print_sun_box(SUN_MOON_ROW, SUN_COLUMN, &context);
+		print_moon_box(SUN_MOON_ROW, MOON_COLUMN, &context);
 
 		//display downlink/uplink information
 		if (comsat) {
@@ -898,7 +903,7 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 
 		//move antenna towards AOS position
 		if ((input_key == 'A') && (obs.elevation*180.0/M_PI < rotctld->tracking_horizon) && rotctld->connected) {
-			rotctld_fail_on_errors(rotctld_track(rotctld, aos.azimuth*180.0/M_PI, 0));
+			rotctld_fail_on_errors(rotctld_track(rotctld, next_pass.aos_azimuth*180.0/M_PI, 0));
 		}
 
 		if (comsat && (input_key != ERR)) {
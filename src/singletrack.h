@@ -5,6 +5,7 @@
 #include <predict/predict.h>
 #include "tle_db.h"
 #include "transponder_db.h"
+#include "pass_cache.h"
 
 /* This function tracks a single satellite in real-time
  * until 'Q' or ESC is pressed.
@@ -13,10 +14,11 @@
  * \param qth Point of observation
  * \param transponder_db Transponder database
  * \param tle_db TLE database
+ * \param pass_cache Cache of upcoming passes, or NULL
  * \param rotctld rotctld connection instance
  * \param downlink_info rigctld connection instance for downlink
  * \param uplink_info rigctld connection instance for uplink
  **/
-void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *transponder_db, struct tle_db *tle_db, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
+void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *transponder_db, struct tle_db *tle_db, struct pass_cache *pass_cache, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
 
 #endif
@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * Argument to worker threads.
+ **/
+struct thread_pool_worker {
+	///Thread pool
+	struct thread_pool *pool;
+	///Slice index of this worker thread
+	int slice;
+};
+
+/**
+ * Worker thread. Waits for tasks, runs its slice of each task and signals when finished.
+ *
+ * \param data Worker argument, freed by the worker thread
+ * \return NULL
+ **/
+void *thread_pool_worker(void *data)
+{
+	struct thread_pool_worker *worker = (struct thread_pool_worker*)data;
+	struct thread_pool *pool = worker->pool;
+	int slice = worker->slice;
+	free(worker);
+
+	unsigned long previous_task_number = 0;
+	pthread_mutex_lock(&(pool->lock));
+	while (true) {
+		while (!pool->stop && (pool->task_number == previous_task_number)) {
+			pthread_cond_wait(&(pool->task_started), &(pool->lock));
+		}
+		if (pool->stop) {
+			break;
+		}
+		previous_task_number = pool->task_number;
+		thread_pool_task_t task = pool->task;
+		void *task_data = pool->task_data;
+		pthread_mutex_unlock(&(pool->lock));
+
+		task(task_data, slice, pool->num_threads);
+
+		pthread_mutex_lock(&(pool->lock));
+		pool->num_finished_slices++;
+		pthread_cond_signal(&(pool->slice_finished));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+	return NULL;
+}
+
+struct thread_pool *thread_pool_create(int num_threads)
+{
+	if (num_threads <= 0) {
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+
+	struct thread_pool *pool = (struct thread_pool*)calloc(1, sizeof(struct thread_pool));
+	pthread_mutex_init(&(pool->lock), NULL);
+	pthread_cond_init(&(pool->task_started), NULL);
+	pthread_cond_init(&(pool->slice_finished), NULL);
+	pool->threads = (pthread_t*)malloc(sizeof(pthread_t)*num_threads);
+
+	for (int i=0; i < num_threads; i++) {
+		struct thread_pool_worker *worker = (struct thread_pool_worker*)malloc(sizeof(struct thread_pool_worker));
+		worker->pool = pool;
+		worker->slice = i;
+		if (pthread_create(&(pool->threads[i]), NULL, thread_pool_worker, worker) != 0) {
+			free(worker);
+			thread_pool_destroy(&pool);
+			return NULL;
+		}
+		pool->num_threads++;
+	}
+	return pool;
+}
+
+void thread_pool_run(struct thread_pool *pool, thread_pool_task_t task, void *data)
+{
+	pthread_mutex_lock(&(pool->lock));
+	pool->task = task;
+	pool->task_data = data;
+	pool->num_finished_slices = 0;
+	pool->task_number++;
+	pthread_cond_broadcast(&(pool->task_started));
+
+	while (pool->num_finished_slices < pool->num_threads) {
+		pthread_cond_wait(&(pool->slice_finished), &(pool->lock));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+}
+
+void thread_pool_slice_range(int num_items, int slice, int num_slices, int *start, int *end)
+{
+	*start = (int)(((long)num_items*slice)/num_slices);
+	*end = (int)(((long)num_items*(slice+1))/num_slices);
+}
+
+void thread_pool_destroy(struct thread_pool **pool)
+{
+	if (*pool == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&((*pool)->lock));
+	(*pool)->stop = true;
+	pthread_cond_broadcast(&((*pool)->task_started));
+	pthread_mutex_unlock(&((*pool)->lock));
+
+	for (int i=0; i < (*pool)->num_threads; i++) {
+		pthread_join((*pool)->threads[i], NULL);
+	}
+
+	pthread_mutex_destroy(&((*pool)->lock));
+	pthread_cond_destroy(&((*pool)->task_started));
+	pthread_cond_destroy(&((*pool)->slice_finished));
+	free((*pool)->threads);
+	free(*pool);
+	*pool = NULL;
+}
@@ -0,0 +1,81 @@
+#ifndef THREAD_POOL_H_DEFINED
+#define THREAD_POOL_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Persistent pool of worker threads, used for splitting repeated work into slices that are processed in parallel.
+ **/
+
+/**
+ * Task run by the worker threads. Each worker thread is given one slice of the work.
+ *
+ * \param data Task data
+ * \param slice Slice index, from 0 to num_slices-1
+ * \param num_slices Number of slices, equal to the number of worker threads
+ **/
+typedef void (*thread_pool_task_t)(void *data, int slice, int num_slices);
+
+/**
+ * Thread pool.
+ **/
+struct thread_pool {
+	///Number of worker threads
+	int num_threads;
+	///Worker threads
+	pthread_t *threads;
+	///Lock protecting the fields below
+	pthread_mutex_t lock;
+	///Signalled when a new task is started, or when the pool is stopped
+	pthread_cond_t task_started;
+	///Signalled when a worker thread has finished its slice
+	pthread_cond_t slice_finished;
+	///Current task
+	thread_pool_task_t task;
+	///Data of current task
+	void *task_data;
+	///Incremented for each started task, used by the worker threads to detect new tasks
+	unsigned long task_number;
+	///Number of slices of the current task that are finished
+	int num_finished_slices;
+	///Whether the worker threads should exit
+	bool stop;
+};
+
+/**
+ * Create thread pool.
+ *
+ * \param num_threads Number of worker threads, 0 for the number of online CPUs
+ * \return Thread pool, or NULL if the worker threads could not be started
+ **/
+struct thread_pool *thread_pool_create(int num_threads);
+
+/**
+ * Run task on all worker threads and wait for it to finish.
+ *
+ * \param pool Thread pool
+ * \param task Task
+ * \param data Task data
+ **/
+void thread_pool_run(struct thread_pool *pool, thread_pool_task_t task, void *data);
+
+/**
+ * Get the range of items to process within a slice, when dividing a number of items evenly across the slices.
+ *
+ * \param num_items Number of items
+ * \param slice Slice index
+ * \param num_slices Number of slices
+ * \param start Returned start index
+ * \param end Returned end index (exclusive)
+ **/
+void thread_pool_slice_range(int num_items, int slice, int num_slices, int *start, int *end);
+
+/**
+ * Stop worker threads and free thread pool.
+ *
+ * \param pool Thread pool
+ **/
+void thread_pool_destroy(struct thread_pool **pool);
+
+#endif
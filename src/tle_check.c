@@ -0,0 +1,176 @@
+#include "tle_check.h"
+#include <ctype.h>
+#include <string.h>
+#include "tle_db.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//checksum value of each character: digits count as their value, '-' counts as 1, anything else as 0
+static const unsigned char tle_checksum_values[256] = {['0'] = 0, ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4,
+	['5'] = 5, ['6'] = 6, ['7'] = 7, ['8'] = 8, ['9'] = 9, ['-'] = 1};
+
+//fixed characters of the "torture test" in line 1 and line 2, 0 for columns that are not checked
+static const char tle_line1_template[TLE_LINE_LENGTH] = {[0] = '1', [1] = ' ', [7] = 'U', [8] = ' ', [17] = ' ',
+	[23] = '.', [32] = ' ', [34] = '.', [43] = ' ', [52] = ' ', [61] = ' ', [62] = '0', [63] = ' '};
+static const char tle_line2_template[TLE_LINE_LENGTH] = {[0] = '2', [1] = ' ', [7] = ' ', [11] = '.', [16] = ' ',
+	[20] = '.', [25] = ' ', [33] = ' ', [37] = '.', [42] = ' ', [46] = '.', [51] = ' ', [54] = '.'};
+
+//columns that are set in the templates above, for the scalar version
+#define TLE_NUM_TEMPLATE_COLUMNS 13
+static const unsigned char tle_line1_template_columns[TLE_NUM_TEMPLATE_COLUMNS] = {0, 1, 7, 8, 17, 23, 32, 34, 43, 52, 61, 62, 63};
+static const unsigned char tle_line2_template_columns[TLE_NUM_TEMPLATE_COLUMNS] = {0, 1, 7, 11, 16, 20, 25, 33, 37, 42, 46, 51, 54};
+
+//number of characters included in the checksum, the checksum digit follows in the last column
+#define TLE_CHECKSUM_LENGTH (TLE_LINE_LENGTH-1)
+
+/**
+ * Checks that are common to the scalar and the vectorized versions: checksum digits, digit columns and the
+ * satellite numbers of both lines.
+ *
+ * \param line1 Line 1 of TLE
+ * \param line2 Line 2 of TLE
+ * \param sum1 Checksum sum of line 1
+ * \param sum2 Checksum sum of line 2
+ * \return True if valid, false otherwise
+ **/
+static inline bool tle_check_remaining(const char *line1, const char *line2, unsigned sum1, unsigned sum2)
+{
+	return isdigit(line1[TLE_CHECKSUM_LENGTH]) && isdigit(line2[TLE_CHECKSUM_LENGTH]) &&
+		((unsigned)(line1[TLE_CHECKSUM_LENGTH] - '0') == sum1 % 10) &&
+		((unsigned)(line2[TLE_CHECKSUM_LENGTH] - '0') == sum2 % 10) &&
+		isdigit(line1[18]) && isdigit(line1[19]) && isdigit(line2[31]) && isdigit(line2[32]) &&
+		(memcmp(line1 + 2, line2 + 2, 5) == 0);
+}
+
+bool tle_check_scalar(const char *line1, const char *line2)
+{
+	unsigned sum1 = 0, sum2 = 0;
+	for (int i=0; i < TLE_CHECKSUM_LENGTH; i++) {
+		sum1 += tle_checksum_values[(unsigned char)line1[i]];
+		sum2 += tle_checksum_values[(unsigned char)line2[i]];
+	}
+
+	int mismatch = 0;
+	for (int i=0; i < TLE_NUM_TEMPLATE_COLUMNS; i++) {
+		int col1 = tle_line1_template_columns[i];
+		int col2 = tle_line2_template_columns[i];
+		mismatch |= (line1[col1] ^ tle_line1_template[col1]) | (line2[col2] ^ tle_line2_template[col2]);
+	}
+
+	return !mismatch && tle_check_remaining(line1, line2, sum1, sum2);
+}
+
+#ifdef __SSE2__
+//offsets of the 16 byte blocks covering a TLE line. The last block overlaps the previous one to avoid reading past the line
+static const int tle_block_offsets[] = {0, 16, 32, 48, TLE_LINE_LENGTH-16};
+#define TLE_NUM_BLOCKS (sizeof(tle_block_offsets)/sizeof(tle_block_offsets[0]))
+
+/**
+ * Convert 16 characters to their checksum values.
+ *
+ * \param chars Characters
+ * \return Checksum values
+ **/
+static inline __m128i tle_checksum_values_sse2(__m128i chars)
+{
+	__m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0'-1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9'+1)));
+	__m128i digit_values = _mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+	__m128i minus_values = _mm_and_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('-')), _mm_set1_epi8(1));
+	return _mm_or_si128(digit_values, minus_values);
+}
+
+/**
+ * Compare 16 characters against the torture test template.
+ *
+ * \param chars Characters
+ * \param template Template characters, 0 for characters that are not checked
+ * \return All bits set in the lanes that match
+ **/
+static inline __m128i tle_template_match_sse2(__m128i chars, __m128i template)
+{
+	return _mm_or_si128(_mm_cmpeq_epi8(chars, template), _mm_cmpeq_epi8(template, _mm_setzero_si128()));
+}
+
+bool tle_check(const char *line1, const char *line2)
+{
+	//lanes of the last block that are not already covered by the previous blocks, and are part of the checksum
+	const __m128i last_block_checksum_mask = _mm_set_epi8(0, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	__m128i sums = _mm_setzero_si128();
+	__m128i match = _mm_set1_epi8(-1);
+	for (int i=0; i < TLE_NUM_BLOCKS; i++) {
+		int offset = tle_block_offsets[i];
+		__m128i chars1 = _mm_loadu_si128((const __m128i*)(line1 + offset));
+		__m128i chars2 = _mm_loadu_si128((const __m128i*)(line2 + offset));
+
+		__m128i values1 = tle_checksum_values_sse2(chars1);
+		__m128i values2 = tle_checksum_values_sse2(chars2);
+		if (i == TLE_NUM_BLOCKS-1) {
+			values1 = _mm_and_si128(values1, last_block_checksum_mask);
+			values2 = _mm_and_si128(values2, last_block_checksum_mask);
+		}
+
+		//sum of line 1 values ends up in the lower 64 bits, sum of line 2 values in the upper 64 bits
+		__m128i line_sums = _mm_sad_epu8(_mm_unpacklo_epi64(values1, values2), _mm_setzero_si128());
+		line_sums = _mm_add_epi64(line_sums, _mm_sad_epu8(_mm_unpackhi_epi64(values1, values2), _mm_setzero_si128()));
+		sums = _mm_add_epi64(sums, line_sums);
+
+		match = _mm_and_si128(match, tle_template_match_sse2(chars1, _mm_loadu_si128((const __m128i*)(tle_line1_template + offset))));
+		match = _mm_and_si128(match, tle_template_match_sse2(chars2, _mm_loadu_si128((const __m128i*)(tle_line2_template + offset))));
+	}
+
+	if (_mm_movemask_epi8(match) != 0xFFFF) {
+		return false;
+	}
+
+	unsigned sum1 = _mm_cvtsi128_si32(sums);
+	unsigned sum2 = _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+	return tle_check_remaining(line1, line2, sum1, sum2);
+}
+#else
+bool tle_check(const char *line1, const char *line2)
+{
+	return tle_check_scalar(line1, line2);
+}
+#endif
+
+char KepCheck(const char *line1, const char *line2)
+{
+	int x;
+	unsigned sum1, sum2;
+
+	unsigned char val[256];
+
+	/* Set up translation table for computing TLE checksums */
+
+	for (x=0; x<=255; val[x]=0, x++);
+	for (x='0'; x<='9'; val[x]=x-'0', x++);
+
+	val['-']=1;
+
+	/* Compute checksum for each line */
+
+	for (x=0, sum1=0, sum2=0; x<=67; sum1+=val[(int)line1[x]], sum2+=val[(int)line2[x]], x++);
+
+	/* Perform a "torture test" on the data */
+
+	x=(val[(int)line1[68]]^(sum1%10)) | (val[(int)line2[68]]^(sum2%10)) |
+	  (line1[0]^'1')  | (line1[1]^' ')  | (line1[7]^'U')  |
+	  (line1[8]^' ')  | (line1[17]^' ') | (line1[23]^'.') |
+	  (line1[32]^' ') | (line1[34]^'.') | (line1[43]^' ') |
+	  (line1[52]^' ') | (line1[61]^' ') | (line1[62]^'0') |
+	  (line1[63]^' ') | (line2[0]^'2')  | (line2[1]^' ')  |
+	  (line2[7]^' ')  | (line2[11]^'.') | (line2[16]^' ') |
+	  (line2[20]^'.') | (line2[25]^' ') | (line2[33]^' ') |
+	  (line2[37]^'.') | (line2[42]^' ') | (line2[46]^'.') |
+	  (line2[51]^' ') | (line2[54]^'.') | (line1[2]^line2[2]) |
+	  (line1[3]^line2[3]) | (line1[4]^line2[4]) |
+	  (line1[5]^line2[5]) | (line1[6]^line2[6]) |
+	  (isdigit(line1[68]) ? 0 : 1) | (isdigit(line2[68]) ? 0 : 1) |
+	  (isdigit(line1[18]) ? 0 : 1) | (isdigit(line1[19]) ? 0 : 1) |
+	  (isdigit(line2[31]) ? 0 : 1) | (isdigit(line2[32]) ? 0 : 1);
+
+	return (x ? 0 : 1);
+}
@@ -0,0 +1,43 @@
+#ifndef TLE_CHECK_H_DEFINED
+#define TLE_CHECK_H_DEFINED
+
+#include <stdbool.h>
+
+/**
+ * Validation of NORAD TLE line pairs, used when TLE files are parsed.
+ **/
+
+/**
+ * Check the validity of a TLE line pair: checksums, fixed-column separators and matching satellite numbers. Gives the
+ * same result as KepCheck(). Uses SSE2 when available, and tle_check_scalar() otherwise.
+ *
+ * \param line1 Line 1 of TLE, at least 69 characters
+ * \param line2 Line 2 of TLE, at least 69 characters
+ * \return True if valid, false otherwise
+ **/
+bool tle_check(const char *line1, const char *line2);
+
+/**
+ * Scalar version of tle_check(), using precomputed checksum and column tables.
+ *
+ * \param line1 Line 1 of TLE, at least 69 characters
+ * \param line2 Line 2 of TLE, at least 69 characters
+ * \return True if valid, false otherwise
+ **/
+bool tle_check_scalar(const char *line1, const char *line2);
+
+/* This function scans line 1 and line 2 of a NASA 2-Line element
+ * set and returns a 1 if the element set appears to be valid or
+ * a 0 if it does not.  If the data survives this torture test,
+ * it's a pretty safe bet we're looking at a valid 2-line
+ * element set and not just some random text that might pass
+ * as orbital data based on a simple checksum calculation alone.
+ * Superseded by tle_check(), kept as reference.
+ *
+ * \param line1 Line 1 of TLE
+ * \param line2 Line 2 of TLE
+ * \return 1 if valid, 0 if not
+ **/
+char KepCheck(const char *line1, const char *line2);
+
+#endif
@@ -10,7 +10,11 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "string_array.h"
+#include "tle_check.h"
 #include <ctype.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 struct tle_db *tle_db_create()
 {
@@ -19,15 +23,129 @@ struct tle_db *tle_db_create()
 	return tle_db;
 }
 
-void tle_db_destroy(struct tle_db **tle_db)
+/**
+ * Free parsed orbital elements of TLE entry, if any.
+ *
+ * \param tle_db TLE database
+ * \param entry_index Index of entry in TLE database
+ **/
+void tle_db_cache_clear_entry(struct tle_db *tle_db, int entry_index)
 {
-	if ((*tle_db)->tles != NULL) {
-		free((*tle_db)->tles);
+	if (tle_db->cache[entry_index].orbital_elements != NULL) {
+		predict_destroy_orbital_elements(tle_db->cache[entry_index].orbital_elements);
+		tle_db->cache[entry_index].orbital_elements = NULL;
+	}
+}
+
+/**
+ * Free all memory owned by the TLE database, but not the struct itself.
+ *
+ * \param tle_db TLE database
+ **/
+void tle_db_free_contents(struct tle_db *tle_db)
+{
+	if (tle_db->cache != NULL) {
+		for (int i=0; i < tle_db->num_tles; i++) {
+			tle_db_cache_clear_entry(tle_db, i);
+		}
+		free(tle_db->cache);
+		tle_db->cache = NULL;
+	}
+	if (tle_db->tles != NULL) {
+		free(tle_db->tles);
+		tle_db->tles = NULL;
+	}
+	if (tle_db->index_table != NULL) {
+		free(tle_db->index_table);
+		tle_db->index_table = NULL;
 	}
+	tle_db->num_tles = 0;
+	tle_db->available_size = 0;
+	tle_db->index_table_size = 0;
+}
+
+void tle_db_destroy(struct tle_db **tle_db)
+{
+	tle_db_free_contents(*tle_db);
 	free(*tle_db);
 	*tle_db = NULL;
 }
 
+//minimum number of slots in the satellite number hash table
+#define TLE_DB_INDEX_MIN_SIZE 64
+
+/**
+ * Hash satellite number to a slot in the satellite number hash table (Knuth multiplicative hashing).
+ *
+ * \param satellite_number Satellite number
+ * \param table_size Size of hash table, power of two
+ * \return Start slot for probing
+ **/
+size_t tle_db_index_hash(long satellite_number, size_t table_size)
+{
+	return ((size_t)(satellite_number * 2654435761u)) & (table_size - 1);
+}
+
+/**
+ * Insert TLE entry into the satellite number hash table. Does nothing if the satellite number already is
+ * indexed, so that the first occurrence of a multiply defined satellite number is retained.
+ *
+ * \param tle_db TLE database
+ * \param entry_index Index of entry in TLE database
+ **/
+void tle_db_index_insert(struct tle_db *tle_db, int entry_index)
+{
+	long satellite_number = tle_db->tles[entry_index].satellite_number;
+	size_t slot = tle_db_index_hash(satellite_number, tle_db->index_table_size);
+	while (tle_db->index_table[slot] != 0) {
+		if (tle_db->tles[tle_db->index_table[slot]-1].satellite_number == satellite_number) {
+			return;
+		}
+		slot = (slot + 1) & (tle_db->index_table_size - 1);
+	}
+	tle_db->index_table[slot] = entry_index+1;
+}
+
+/**
+ * Rebuild satellite number hash table from scratch, sized for the current number of TLE entries.
+ *
+ * \param tle_db TLE database
+ **/
+void tle_db_index_rebuild(struct tle_db *tle_db)
+{
+	size_t new_size = TLE_DB_INDEX_MIN_SIZE;
+	while (new_size < tle_db->num_tles*2) {
+		new_size *= 2;
+	}
+
+	if (new_size != tle_db->index_table_size) {
+		free(tle_db->index_table);
+		tle_db->index_table = (int*)malloc(sizeof(int)*new_size);
+		tle_db->index_table_size = new_size;
+	}
+	memset(tle_db->index_table, 0, sizeof(int)*new_size);
+
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_index_insert(tle_db, i);
+	}
+}
+
+/**
+ * Remove all entries from TLE database, keeping allocated memory.
+ *
+ * \param tle_db TLE database
+ **/
+void tle_db_clear(struct tle_db *tle_db)
+{
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_cache_clear_entry(tle_db, i);
+	}
+	tle_db->num_tles = 0;
+	if (tle_db->index_table != NULL) {
+		memset(tle_db->index_table, 0, sizeof(int)*tle_db->index_table_size);
+	}
+}
+
 /**
  * Check if tle_1 is more recent than tle_2.
  *
@@ -38,7 +156,7 @@ void tle_db_destroy(struct tle_db **tle_db)
 bool tle_is_newer_than(char *tle_1[2], char *tle_2[2])
 {
 	predict_orbital_elements_t *orbele_1 = predict_parse_tle(tle_1[0], tle_1[1]);
-	predict_orbital_elements_t *orbele_2 = predict_parse_tle(tle_2[0], tle_1[1]);
+	predict_orbital_elements_t *orbele_2 = predict_parse_tle(tle_2[0], tle_2[1]);
 
 	double epoch_1 = orbele_1->epoch_year*1000.0 + orbele_1->epoch_day;
 	double epoch_2 = orbele_2->epoch_year*1000.0 + orbele_2->epoch_day;
@@ -56,22 +174,49 @@ bool tle_db_entry_is_newer_than(struct tle_db_entry tle_entry_1, struct tle_db_e
 	return tle_is_newer_than(tle_1, tle_2);
 }
 
+/**
+ * Copy TLE fields from one TLE entry to another. The enabled flag is left untouched.
+ *
+ * \param destination Destination entry
+ * \param source Source entry
+ **/
+void tle_db_entry_copy(struct tle_db_entry *destination, const struct tle_db_entry *source)
+{
+	bool enabled = destination->enabled;
+	*destination = *source;
+	destination->enabled = enabled;
+}
+
 void tle_db_overwrite_entry(int entry_index, struct tle_db *tle_db, const struct tle_db_entry *new_entry)
 {
 	if (entry_index < tle_db->num_tles) {
-		tle_db->tles[entry_index].satellite_number = new_entry->satellite_number;
-		strncpy(tle_db->tles[entry_index].name, new_entry->name, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].line1, new_entry->line1, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].line2, new_entry->line2, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].filename, new_entry->filename, MAX_NUM_CHARS);
+		struct tle_db_entry *entry = &(tle_db->tles[entry_index]);
+		bool satellite_number_changed = entry->satellite_number != new_entry->satellite_number;
+		if ((strcmp(entry->line1, new_entry->line1) != 0) || (strcmp(entry->line2, new_entry->line2) != 0)) {
+			tle_db_cache_clear_entry(tle_db, entry_index);
+		}
+		tle_db_entry_copy(entry, new_entry);
+
+		//the old satellite number might still be defined elsewhere in the database, simplest to reindex everything
+		if (satellite_number_changed) {
+			tle_db_index_rebuild(tle_db);
+		}
 	}
 }
 
-void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry)
+/**
+ * Make room for a new entry at the end of the TLE database. The entry is not counted
+ * before tle_db_commit_entry() is called.
+ *
+ * \param tle_db TLE database
+ * \return Pointer to uninitialized entry, or NULL if memory could not be allocated
+ **/
+struct tle_db_entry *tle_db_reserve_entry(struct tle_db *tle_db)
 {
 	//initialize
 	if (tle_db->available_size == 0) {
 		tle_db->tles = (struct tle_db_entry*)malloc(sizeof(struct tle_db_entry));
+		tle_db->cache = (struct tle_db_entry_cache*)malloc(sizeof(struct tle_db_entry_cache));
 		tle_db->available_size = 1;
 		tle_db->num_tles = 0;
 	}
@@ -81,48 +226,142 @@ void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry)
 		size_t new_size = tle_db->available_size*2;
 		struct tle_db_entry* temp = realloc(tle_db->tles, sizeof(struct tle_db_entry)*new_size);
 		if (temp == NULL) {
-			return;
+			return NULL;
 		}
-		tle_db->available_size = new_size;
 		tle_db->tles = temp;
+
+		struct tle_db_entry_cache *temp_cache = realloc(tle_db->cache, sizeof(struct tle_db_entry_cache)*new_size);
+		if (temp_cache == NULL) {
+			return NULL;
+		}
+		tle_db->cache = temp_cache;
+		tle_db->available_size = new_size;
 	}
 
+	return &(tle_db->tles[tle_db->num_tles]);
+}
+
+/**
+ * Add entry filled in after tle_db_reserve_entry() to the TLE database and the satellite number index.
+ *
+ * \param tle_db TLE database
+ **/
+void tle_db_commit_entry(struct tle_db *tle_db)
+{
+	tle_db->tles[tle_db->num_tles].enabled = false;
+	tle_db->cache[tle_db->num_tles].orbital_elements = NULL;
 	tle_db->num_tles++;
-	tle_db_overwrite_entry(tle_db->num_tles-1, tle_db, entry);
+
+	//keep hash table at most half full
+	if (tle_db->num_tles*2 > tle_db->index_table_size) {
+		tle_db_index_rebuild(tle_db);
+	} else {
+		tle_db_index_insert(tle_db, tle_db->num_tles-1);
+	}
+}
+
+void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry)
+{
+	struct tle_db_entry *new_entry = tle_db_reserve_entry(tle_db);
+	if (new_entry == NULL) {
+		return;
+	}
+	tle_db_entry_copy(new_entry, entry);
+	tle_db_commit_entry(tle_db);
 }
 
 void tle_db_merge(struct tle_db *new_db, struct tle_db *main_db, enum tle_merge_behavior merge_opt)
 {
 	for (int i=0; i < new_db->num_tles; i++) {
-		bool tle_exists = false;
-		for (int j=0; j < main_db->num_tles; j++) {
-			//check whether TLE already exists in the database
-			if (new_db->tles[i].satellite_number == main_db->tles[j].satellite_number) {
-				tle_exists = true;
-
-				if ((merge_opt == TLE_OVERWRITE_OLD) && tle_db_entry_is_newer_than(new_db->tles[i], main_db->tles[j])) {
-					tle_db_overwrite_entry(j, main_db, &(new_db->tles[i]));
-				}
-			}
-		}
+		//check whether TLE already exists in the database
+		int existing_index = tle_db_find_entry(main_db, new_db->tles[i].satellite_number);
 
-		//append TLE entry to main TLE database
-		if (!tle_exists) {
+		if (existing_index == -1) {
+			//append TLE entry to main TLE database
 			tle_db_add_entry(main_db, &(new_db->tles[i]));
+		} else if ((merge_opt == TLE_OVERWRITE_OLD) && (tle_db_entry_epoch(new_db, i) > tle_db_entry_epoch(main_db, existing_index))) {
+			tle_db_overwrite_entry(existing_index, main_db, &(new_db->tles[i]));
 		}
 	}
 }
 
 int tle_db_find_entry(const struct tle_db *tle_db, long satellite_number)
 {
-	for (int i=0; i < tle_db->num_tles; i++) {
-		if (tle_db->tles[i].satellite_number == satellite_number) {
-			return i;
+	if ((tle_db->num_tles == 0) || (tle_db->index_table_size == 0)) {
+		return -1;
+	}
+
+	size_t slot = tle_db_index_hash(satellite_number, tle_db->index_table_size);
+	while (tle_db->index_table[slot] != 0) {
+		int index = tle_db->index_table[slot]-1;
+		if (tle_db->tles[index].satellite_number == satellite_number) {
+			return index;
 		}
+		slot = (slot + 1) & (tle_db->index_table_size - 1);
 	}
 	return -1;
 }
 
+/**
+ * Shared state for the worker threads in tle_db_from_directory().
+ **/
+struct tle_db_loader {
+	///Paths to TLE files
+	string_array_t *filenames;
+	///Returned TLE databases, one for each file
+	struct tle_db *file_dbs;
+	///Index of the next file to be read by a worker thread
+	int next_file;
+	///Lock protecting next_file
+	pthread_mutex_t lock;
+};
+
+/**
+ * Worker thread for tle_db_from_directory(). Reads files from the file list until all files are taken.
+ *
+ * \param data Pointer to struct tle_db_loader
+ * \return NULL
+ **/
+void *tle_db_loader_worker(void *data)
+{
+	struct tle_db_loader *loader = (struct tle_db_loader*)data;
+	int num_files = string_array_size(loader->filenames);
+
+	while (true) {
+		pthread_mutex_lock(&(loader->lock));
+		int file_index = loader->next_file++;
+		pthread_mutex_unlock(&(loader->lock));
+
+		if (file_index >= num_files) {
+			break;
+		}
+		tle_db_from_file(string_array_get(loader->filenames, file_index), &(loader->file_dbs[file_index]));
+	}
+	return NULL;
+}
+
+/**
+ * Get number of worker threads to use for loading a given number of files.
+ *
+ * \param requested_threads Requested number of threads, 0 for number of online CPUs
+ * \param num_files Number of files to read
+ * \return Number of threads, at least 1 and at most the number of files
+ **/
+int tle_db_num_loader_threads(int requested_threads, int num_files)
+{
+	int num_threads = requested_threads;
+	if (num_threads <= 0) {
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (num_threads > num_files) {
+		num_threads = num_files;
+	}
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	return num_threads;
+}
+
 void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
 {
 	DIR *d;
@@ -138,6 +377,8 @@ void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
 		dirpath_ext = strdup(dirpath);
 	}
 
+	//collect regular files in directory
+	string_array_t filenames = {0};
 	d = opendir(dirpath_ext);
 	if (d) {
 		while ((file = readdir(d)) != NULL) {
@@ -145,156 +386,256 @@ void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
 				int pathsize = strlen(file->d_name) + strlen(dirpath_ext) + 1;
 				char *full_path = (char*)malloc(sizeof(char)*pathsize);
 				snprintf(full_path, pathsize, "%s%s", dirpath_ext, file->d_name);
-
-				//read into empty TLE db
-				struct tle_db temp_db = {0};
-				tle_db_from_file(full_path, &temp_db);
+				string_array_add(&filenames, full_path);
 				free(full_path);
-
-				//merge with existing TLE db
-				tle_db_merge(&temp_db, ret_tle_db, TLE_OVERWRITE_OLD); //overwrite only entries with older epochs
 			}
 		}
 		closedir(d);
 	}
 	free(dirpath_ext);
+
+	int num_files = string_array_size(&filenames);
+	if (num_files == 0) {
+		return;
+	}
+
+	//read each file into separate, empty TLE databases
+	struct tle_db_loader loader = {0};
+	loader.filenames = &filenames;
+	loader.file_dbs = (struct tle_db*)calloc(num_files, sizeof(struct tle_db));
+	pthread_mutex_init(&(loader.lock), NULL);
+
+	int num_threads = tle_db_num_loader_threads(ret_tle_db->num_loader_threads, num_files);
+	pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t)*num_threads);
+	int num_started_threads = 0;
+	for (int i=1; i < num_threads; i++) {
+		if (pthread_create(&(threads[num_started_threads]), NULL, tle_db_loader_worker, &loader) == 0) {
+			num_started_threads++;
+		}
+	}
+	tle_db_loader_worker(&loader); //the calling thread takes part in the loading, and takes over all files if no threads could be started
+	for (int i=0; i < num_started_threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+	pthread_mutex_destroy(&(loader.lock));
+
+	//merge with existing TLE db in directory listing order
+	for (int i=0; i < num_files; i++) {
+		tle_db_merge(&(loader.file_dbs[i]), ret_tle_db, TLE_OVERWRITE_OLD); //overwrite only entries with older epochs
+		tle_db_free_contents(&(loader.file_dbs[i]));
+	}
+	free(loader.file_dbs);
+	string_array_free(&filenames);
 }
 
-/* This function scans line 1 and line 2 of a NASA 2-Line element
- * set and returns a 1 if the element set appears to be valid or
- * a 0 if it does not.  If the data survives this torture test,
- * it's a pretty safe bet we're looking at a valid 2-line
- * element set and not just some random text that might pass
- * as orbital data based on a simple checksum calculation alone.
+/**
+ * Parse satellite number from columns 3-7 in line 1 of a NORAD TLE, in the same way as atol().
  *
  * \param line1 Line 1 of TLE
- * \param line2 Line 2 of TLE
- * \return 1 if valid, 0 if not
+ * \return Satellite number
  **/
-char KepCheck(const char *line1, const char *line2)
+long tle_parse_satellite_number(const char *line1)
 {
-	int x;
-	unsigned sum1, sum2;
-
-	unsigned char val[256];
-
-	/* Set up translation table for computing TLE checksums */
-
-	for (x=0; x<=255; val[x]=0, x++);
-	for (x='0'; x<='9'; val[x]=x-'0', x++);
+	const char *field = line1 + 2;
+	const char *field_end = line1 + 7;
 
-	val['-']=1;
-
-	/* Compute checksum for each line */
-
-	for (x=0, sum1=0, sum2=0; x<=67; sum1+=val[(int)line1[x]], sum2+=val[(int)line2[x]], x++);
-
-	/* Perform a "torture test" on the data */
-
-	x=(val[(int)line1[68]]^(sum1%10)) | (val[(int)line2[68]]^(sum2%10)) |
-	  (line1[0]^'1')  | (line1[1]^' ')  | (line1[7]^'U')  |
-	  (line1[8]^' ')  | (line1[17]^' ') | (line1[23]^'.') |
-	  (line1[32]^' ') | (line1[34]^'.') | (line1[43]^' ') |
-	  (line1[52]^' ') | (line1[61]^' ') | (line1[62]^'0') |
-	  (line1[63]^' ') | (line2[0]^'2')  | (line2[1]^' ')  |
-	  (line2[7]^' ')  | (line2[11]^'.') | (line2[16]^' ') |
-	  (line2[20]^'.') | (line2[25]^' ') | (line2[33]^' ') |
-	  (line2[37]^'.') | (line2[42]^' ') | (line2[46]^'.') |
-	  (line2[51]^' ') | (line2[54]^'.') | (line1[2]^line2[2]) |
-	  (line1[3]^line2[3]) | (line1[4]^line2[4]) |
-	  (line1[5]^line2[5]) | (line1[6]^line2[6]) |
-	  (isdigit(line1[68]) ? 0 : 1) | (isdigit(line2[68]) ? 0 : 1) |
-	  (isdigit(line1[18]) ? 0 : 1) | (isdigit(line1[19]) ? 0 : 1) |
-	  (isdigit(line2[31]) ? 0 : 1) | (isdigit(line2[32]) ? 0 : 1);
+	while ((field < field_end) && (*field == ' ')) {
+		field++;
+	}
 
-	return (x ? 0 : 1);
+	long satellite_number = 0;
+	while ((field < field_end) && isdigit(*field)) {
+		satellite_number = satellite_number*10 + (*field - '0');
+		field++;
+	}
+	return satellite_number;
 }
 
-#define NUM_CHARS_IN_TLE 80
-
-int tle_db_from_file(const char *tle_file, struct tle_db *ret_db)
+/**
+ * Find the next line in a memory buffer.
+ *
+ * \param data Pointer to current position in buffer, moved to the start of the following line on return
+ * \param data_end End of buffer
+ * \param line_length Returned length of line, excluding any line ending (LF or CRLF)
+ * \return Start of line, or NULL if there are no more lines
+ **/
+const char *tle_next_line(const char **data, const char *data_end, size_t *line_length)
 {
-	//copied from ReadDataFiles().
-
-	ret_db->num_tles = 0;
-	int y = 0;
-
-	FILE *fd=fopen(tle_file,"r");
-	if (fd!=NULL) {
-		while (feof(fd)==0) {
-			/* Initialize variables */
-			char name[NUM_CHARS_IN_TLE] = {0};
-			char line1[NUM_CHARS_IN_TLE] = {0};
-			char line2[NUM_CHARS_IN_TLE] = {0};
-
-			/* Read element set */
-
-			if (fgets(name, NUM_CHARS_IN_TLE, fd) == NULL) break;
-			if (fgets(line1, NUM_CHARS_IN_TLE, fd) == NULL) break;
-			if (fgets(line2, NUM_CHARS_IN_TLE, fd) == NULL) break;
+	const char *line = *data;
+	if (line >= data_end) {
+		return NULL;
+	}
 
-			if (KepCheck(line1,line2) && (feof(fd)==0)) {
-				/* We found a valid TLE! */
+	const char *newline = memchr(line, '\n', data_end - line);
+	const char *line_end = data_end;
+	*data = data_end;
+	if (newline != NULL) {
+		line_end = newline;
+		*data = newline + 1;
+	}
+	if ((line_end > line) && (*(line_end-1) == '\r')) {
+		line_end--;
+	}
+	*line_length = line_end - line;
+	return line;
+}
 
-				/* Some TLE sources left justify the sat
-				   name in a 24-byte field that is padded
-				   with blanks.  The following lines cut
-				   out the blanks as well as the line feed
-				   character read by the fgets() function. */
+/**
+ * Parse TLE entries in a memory buffer. The buffer is read as consecutive three-line blocks of
+ * name, line 1 and line 2. Blocks not passing tle_check() are skipped.
+ *
+ * \param data Start of buffer
+ * \param data_size Size of buffer
+ * \param tle_file Filename to set in the TLE entries
+ * \param ret_db Returned TLE database, parsed entries are appended
+ **/
+void tle_db_from_buffer(const char *data, size_t data_size, const char *tle_file, struct tle_db *ret_db)
+{
+	const char *data_end = data + data_size;
+	int filename_index = tle_db_intern_filename(tle_file);
 
-				y=strlen(name);
+	while (true) {
+		size_t name_length, line1_length, line2_length;
+		const char *name = tle_next_line(&data, data_end, &name_length);
+		if (name == NULL) break;
+		const char *line1 = tle_next_line(&data, data_end, &line1_length);
+		if (line1 == NULL) break;
+		const char *line2 = tle_next_line(&data, data_end, &line2_length);
+		if (line2 == NULL) break;
+
+		if ((line1_length < TLE_LINE_LENGTH) || (line2_length < TLE_LINE_LENGTH) || !tle_check(line1, line2)) {
+			continue;
+		}
 
-				while (name[y]==32 || name[y]==0 || name[y]==10 || name[y]==13 || y==0) {
-					name[y]=0;
-					y--;
-				}
+		//skip "0 " prefix of name lines in the 3LE format
+		if ((name_length >= 2) && (name[0] == '0') && (name[1] == ' ')) {
+			name += 2;
+			name_length -= 2;
+		}
 
-				/* Copy TLE data into the sat data structure */
+		//some TLE sources left justify the satellite name in a 24-byte field padded with blanks
+		while ((name_length > 0) && ((name[name_length-1] == ' ') || (name[name_length-1] == '\r') || (name[name_length-1] == '\0'))) {
+			name_length--;
+		}
+		if (name_length > TLE_NAME_LENGTH) {
+			name_length = TLE_NAME_LENGTH;
+		}
 
-				struct tle_db_entry entry = {0};
+		//copy TLE data directly into the new database entry
+		struct tle_db_entry *entry = tle_db_reserve_entry(ret_db);
+		if (entry == NULL) {
+			break;
+		}
 
-				strncpy(entry.name,name,24);
-				strncpy(entry.line1,line1,69);
-				strncpy(entry.line2,line2,69);
+		memcpy(entry->name, name, name_length);
+		entry->name[name_length] = '\0';
+		memcpy(entry->line1, line1, TLE_LINE_LENGTH);
+		entry->line1[TLE_LINE_LENGTH] = '\0';
+		memcpy(entry->line2, line2, TLE_LINE_LENGTH);
+		entry->line2[TLE_LINE_LENGTH] = '\0';
+		entry->filename_index = filename_index;
+		entry->satellite_number = tle_parse_satellite_number(entry->line1);
 
-				/* Get satellite number, so that the satellite database can be parsed. */
+		tle_db_commit_entry(ret_db);
+	}
+}
 
-				predict_orbital_elements_t *temp_elements = predict_parse_tle(entry.line1, entry.line2);
-				entry.satellite_number = temp_elements->satellite_number;
-				predict_destroy_orbital_elements(temp_elements);
+int tle_db_from_file(const char *tle_file, struct tle_db *ret_db)
+{
+	tle_db_clear(ret_db);
 
-				strncpy(entry.filename, tle_file, MAX_NUM_CHARS);
+	int fd = open(tle_file, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
 
-				tle_db_add_entry(ret_db, &entry);
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) == 0) && S_ISREG(file_stat.st_mode)) {
+		//map regular files directly into memory
+		if (file_stat.st_size > 0) {
+			void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				close(fd);
+				return -1;
 			}
+			madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+			tle_db_from_buffer((const char*)data, file_stat.st_size, tle_file, ret_db);
+			munmap(data, file_stat.st_size);
 		}
-
-		fclose(fd);
 	} else {
-		return -1;
+		//pipes and other special files have to be read into a buffer
+		size_t data_size = 0;
+		size_t available_size = MAX_NUM_CHARS;
+		char *data = (char*)malloc(available_size);
+		ssize_t read_size;
+		while ((read_size = read(fd, data + data_size, available_size - data_size)) > 0) {
+			data_size += read_size;
+			if (data_size == available_size) {
+				available_size *= 2;
+				char *temp = (char*)realloc(data, available_size);
+				if (temp == NULL) {
+					break;
+				}
+				data = temp;
+			}
+		}
+		tle_db_from_buffer(data, data_size, tle_file, ret_db);
+		free(data);
 	}
+
+	close(fd);
 	return 0;
 }
 
 int tle_db_to_file(const char *filename, struct tle_db *tle_db)
 {
-	int x;
-	FILE *fd;
-
-	/* Save orbital data to tlefile */
-	fd=fopen(filename,"w");
-	if (fd != NULL) {
-		for (x=0; x<tle_db->num_tles; x++) {
-			fprintf(fd,"%s\n", tle_db->tles[x].name);
-			fprintf(fd,"%s\n", tle_db->tles[x].line1);
-			fprintf(fd,"%s\n", tle_db->tles[x].line2);
-		}
+	//write to temporary file in the same directory, renamed on completion
+	int tmp_size = strlen(filename) + strlen(".XXXXXX") + 1;
+	char *tmp_filename = (char*)malloc(sizeof(char)*tmp_size);
+	snprintf(tmp_filename, tmp_size, "%s.XXXXXX", filename);
+	int fid = mkstemp(tmp_filename);
+	if (fid == -1) {
+		free(tmp_filename);
+		return -1;
+	}
 
-		fclose(fd);
-		return 0;
+	//keep permissions of the existing file, mkstemp() creates the file as user-readable only
+	struct stat file_stat;
+	mode_t mode;
+	if (stat(filename, &file_stat) == 0) {
+		mode = file_stat.st_mode & 07777;
 	} else {
+		mode_t mask = umask(0);
+		umask(mask);
+		mode = 0666 & ~mask;
+	}
+	fchmod(fid, mode);
+
+	/* Save orbital data to tlefile */
+	FILE *fd = fdopen(fid, "w");
+	if (fd == NULL) {
+		close(fid);
+		unlink(tmp_filename);
+		free(tmp_filename);
 		return -1;
 	}
+	for (int x=0; x<tle_db->num_tles; x++) {
+		fprintf(fd,"%s\n", tle_db->tles[x].name);
+		fprintf(fd,"%s\n", tle_db->tles[x].line1);
+		fprintf(fd,"%s\n", tle_db->tles[x].line2);
+	}
+
+	bool write_failed = ferror(fd) != 0;
+	write_failed = (fclose(fd) != 0) || write_failed;
+
+	int retval = 0;
+	if (write_failed || (rename(tmp_filename, filename) != 0)) {
+		unlink(tmp_filename);
+		retval = -1;
+	}
+	free(tmp_filename);
+	return retval;
 }
 
 /**
@@ -333,132 +674,159 @@ char *tle_db_updatefile_writepath()
  *
  * \param tle_filename Filename to which corresponding entries are found and written
  * \param tle_db TLE database
+ * \return 0 on success, -1 otherwise
  **/
-void tle_db_update_file(const char *tle_filename, struct tle_db *tle_db)
+int tle_db_update_file(const char *tle_filename, struct tle_db *tle_db)
 {
-	struct tle_db *subset_db = tle_db_create();
+	int filename_index = tle_db_intern_filename(tle_filename);
+	struct tle_db subset_db = {0};
 	for (int i=0; i < tle_db->num_tles; i++) {
-		if (strcmp(tle_db->tles[i].filename, tle_filename) == 0) {
-			tle_db_add_entry(subset_db, &(tle_db->tles[i]));
+		if (tle_db->tles[i].filename_index == filename_index) {
+			tle_db_add_entry(&subset_db, &(tle_db->tles[i]));
 		}
 	}
-	tle_db_to_file(tle_filename, subset_db);
-	tle_db_destroy(&subset_db);
+	int retval = tle_db_to_file(tle_filename, &subset_db);
+	tle_db_free_contents(&subset_db);
+	return retval;
 }
 
-void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status)
+int tle_db_update_set_from_files(string_array_t *filenames, struct tle_db *ret_db)
 {
-	struct tle_db *new_db = tle_db_create();
-	int retval = tle_db_from_file(filename, new_db);
-	if (retval != 0) {
-		tle_db_destroy(&new_db);
-		return;
+	int num_failed = 0;
+	for (int i=0; i < string_array_size(filenames); i++) {
+		const char *filename = string_array_get(filenames, i);
+		struct tle_db *file_db = tle_db_create();
+		file_db->num_loader_threads = ret_db->num_loader_threads;
+
+		int retval = 0;
+		struct stat file_stat;
+		if ((stat(filename, &file_stat) == 0) && S_ISDIR(file_stat.st_mode)) {
+			tle_db_from_directory(filename, file_db);
+		} else {
+			retval = tle_db_from_file(filename, file_db);
+		}
+
+		if (retval == 0) {
+			tle_db_merge(file_db, ret_db, TLE_OVERWRITE_OLD);
+		} else {
+			num_failed++;
+		}
+		tle_db_destroy(&file_db);
 	}
+	return num_failed;
+}
 
+void tle_db_update_from_db(struct tle_db *new_db, struct tle_db *tle_db, int *update_status)
+{
 	if (update_status != NULL) {
 		for (int i=0; i < tle_db->num_tles; i++) {
 			update_status[i] = 0;
 		}
 	}
 
-	int num_tles_to_update = 0;
-	int *newer_tle_indices = (int*)malloc(sizeof(int)*new_db->num_tles); //indices in new TLE db that should be used to update internal db
-	int *tle_indices_to_update = (int*)malloc(sizeof(int)*new_db->num_tles); //indices in internal db that should be updated
+	bool *updated = (bool*)calloc(tle_db->num_tles, sizeof(bool)); //whether entries in internal db were updated
+	int num_files = 0;
+	int *files = (int*)malloc(sizeof(int)*new_db->num_tles); //filename indices of files containing updated entries
+	bool *file_written = (bool*)calloc(new_db->num_tles, sizeof(bool)); //whether the corresponding file was written
 
-	//find more recent entries
+	//update internal db with more recent entries
 	for (int i=0; i < new_db->num_tles; i++) {
 		int index = tle_db_find_entry(tle_db, new_db->tles[i].satellite_number);
-		if (index != -1) {
-			if (tle_db_entry_is_newer_than(new_db->tles[i], tle_db->tles[index])) {
-				newer_tle_indices[num_tles_to_update] = i;
-				tle_indices_to_update[num_tles_to_update] = index;
-				num_tles_to_update++;
+		if ((index != -1) && (tle_db_entry_epoch(new_db, i) > tle_db_entry_epoch(tle_db, index))) {
+			struct tle_db_entry *tle_entry = &(tle_db->tles[index]);
+
+			//keep old filename and name
+			int filename_index = tle_entry->filename_index;
+			char keep_name[TLE_NAME_LENGTH+1];
+			strncpy(keep_name, tle_entry->name, TLE_NAME_LENGTH+1);
+
+			tle_db_overwrite_entry(index, tle_db, &(new_db->tles[i]));
+
+			tle_entry->filename_index = filename_index;
+			strncpy(tle_entry->name, keep_name, TLE_NAME_LENGTH+1);
+			updated[index] = true;
+
+			//collect files to rewrite
+			bool file_found = false;
+			for (int j=0; j < num_files; j++) {
+				if (files[j] == filename_index) {
+					file_found = true;
+					break;
+				}
+			}
+			if (!file_found) {
+				files[num_files] = filename_index;
+				num_files++;
 			}
 		}
 	}
 
-	if (num_tles_to_update <= 0) {
-		tle_db_destroy(&new_db);
-		return;
+	//rewrite each affected file once
+	for (int i=0; i < num_files; i++) {
+		const char *tle_filename = tle_db_interned_filename(files[i]);
+		if (access(tle_filename, W_OK) == 0) {
+			file_written[i] = (tle_db_update_file(tle_filename, tle_db) == 0);
+		}
 	}
 
-	int num_unwritable = 0;
-	int *unwritable_tles = (int*)malloc(sizeof(int)*num_tles_to_update); //indices in the internal db that were updated, but cannot be written to the current file.
-
-	//go over tles to update, collect tles belonging to one file in one update, update the file if possible, add to above array if not. Update internal db with new TLE information.
-	for (int i=0; i < num_tles_to_update; i++) {
-		if (newer_tle_indices[i] != -1) {
-			char *tle_filename = tle_db->tles[tle_indices_to_update[i]].filename; //filename to be updated
-			bool file_is_writable = access(tle_filename, W_OK) == 0;
-
-			//find entries in tle database with corresponding filenames
-			for (int j=i; j < num_tles_to_update; j++) {
-				if (newer_tle_indices[j] != -1) {
-					int tle_index = tle_indices_to_update[j];
-					struct tle_db_entry *tle_update_entry = &(new_db->tles[newer_tle_indices[j]]);
-					struct tle_db_entry *tle_entry = &(tle_db->tles[tle_index]);
-					if (strcmp(tle_filename, tle_entry->filename) == 0) {
-						//update tle db entry with new entry
-						char keep_filename[MAX_NUM_CHARS];
-						char keep_name[MAX_NUM_CHARS];
-						strncpy(keep_filename, tle_entry->filename, MAX_NUM_CHARS);
-						strncpy(keep_name, tle_entry->name, MAX_NUM_CHARS);
-
-						tle_db_overwrite_entry(tle_index, tle_db, tle_update_entry);
-
-						//keep old filename and name
-						strncpy(tle_entry->filename, keep_filename, MAX_NUM_CHARS);
-						strncpy(tle_entry->name, keep_name, MAX_NUM_CHARS);
-
-						//set db indices to update to -1 in order to ignore them on the next update
-						newer_tle_indices[j] = -1;
-
-						if (update_status != NULL) {
-							update_status[tle_index] |= TLE_DB_UPDATED;
-							if (file_is_writable) {
-								update_status[tle_index] |= TLE_FILE_UPDATED;
-							}
-						}
-
-						if (!file_is_writable) {
-							//add to list over unwritable TLE filenames
-							unwritable_tles[num_unwritable] = tle_index;
-							num_unwritable++;
-						}
-					}
+	//collect updated entries that could not be written to their original file
+	struct tle_db unwritable_db = {0};
+	int *unwritable_tles = (int*)malloc(sizeof(int)*tle_db->num_tles);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (updated[i]) {
+			bool written = false;
+			for (int j=0; j < num_files; j++) {
+				if (files[j] == tle_db->tles[i].filename_index) {
+					written = file_written[j];
+					break;
+				}
+			}
+
+			if (update_status != NULL) {
+				update_status[i] |= TLE_DB_UPDATED;
+				if (written) {
+					update_status[i] |= TLE_FILE_UPDATED;
 				}
 			}
 
-			//write updated TLE entries to file
-			if (file_is_writable) {
-				tle_db_update_file(tle_filename, tle_db);
+			if (!written) {
+				unwritable_tles[unwritable_db.num_tles] = i;
+				tle_db_add_entry(&unwritable_db, &(tle_db->tles[i]));
 			}
 		}
 	}
 
-	if ((num_unwritable > 0) && (tle_db->read_from_xdg)) {
+	if ((unwritable_db.num_tles > 0) && (tle_db->read_from_xdg)) {
 		//write unwritable TLEs to new file
 		char *new_tle_filename = tle_db_updatefile_writepath();
-
-		struct tle_db unwritable_db = {0};
-		for (int i=0; i < num_unwritable; i++) {
-			int tle_ind = unwritable_tles[i];
-			tle_db_add_entry(&unwritable_db, &(tle_db->tles[tle_ind]));
-			strncpy(tle_db->tles[tle_ind].filename, new_tle_filename, MAX_NUM_CHARS);
-		}
 		int retval = tle_db_to_file(new_tle_filename, &unwritable_db);
-		if ((update_status != NULL) && (retval != -1)) {
-			for (int i=0; i < num_unwritable; i++) {
+		if (retval != -1) {
+			int new_filename_index = tle_db_intern_filename(new_tle_filename);
+			for (int i=0; i < unwritable_db.num_tles; i++) {
 				int tle_ind = unwritable_tles[i];
-				update_status[tle_ind] |= TLE_IN_NEW_FILE;
+				tle_db->tles[tle_ind].filename_index = new_filename_index;
+				if (update_status != NULL) {
+					update_status[tle_ind] |= TLE_IN_NEW_FILE;
+				}
 			}
 		}
 		free(new_tle_filename);
 	}
 
-	free(newer_tle_indices);
-	free(tle_indices_to_update);
+	tle_db_free_contents(&unwritable_db);
 	free(unwritable_tles);
+	free(updated);
+	free(files);
+	free(file_written);
+}
+
+void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status)
+{
+	struct tle_db *new_db = tle_db_create();
+	int retval = tle_db_from_file(filename, new_db);
+	if (retval == 0) {
+		tle_db_update_from_db(new_db, tle_db, update_status);
+	}
 	tle_db_destroy(&new_db);
 }
 
@@ -481,6 +849,7 @@ void tle_db_from_search_paths(struct tle_db *ret_tle_db)
 		snprintf(dir, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), TLE_RELATIVE_DIR_PATH);
 
 		struct tle_db *temp_db = tle_db_create();
+		temp_db->num_loader_threads = ret_tle_db->num_loader_threads;
 		tle_db_from_directory(dir, temp_db);
 		tle_db_merge(temp_db, ret_tle_db, TLE_OVERWRITE_NONE); //multiply defined TLEs in directories of less precedence are ignored
 		tle_db_destroy(&temp_db);
@@ -506,16 +875,31 @@ bool tle_db_entry_enabled(const struct tle_db *db, int tle_index)
 	return false;
 }
 
-predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db *db, int tle_index)
+predict_orbital_elements_t *tle_db_entry_to_orbital_elements(struct tle_db *db, int tle_index)
 {
 	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
-		const struct tle_db_entry *entry = &(db->tles[tle_index]);
-		return predict_parse_tle(entry->line1, entry->line2);
+		struct tle_db_entry_cache *cache = &(db->cache[tle_index]);
+		if (cache->orbital_elements == NULL) {
+			const struct tle_db_entry *entry = &(db->tles[tle_index]);
+			cache->orbital_elements = predict_parse_tle(entry->line1, entry->line2);
+			if (cache->orbital_elements != NULL) {
+				cache->epoch = cache->orbital_elements->epoch_year*1000.0 + cache->orbital_elements->epoch_day;
+			}
+		}
+		return cache->orbital_elements;
 	} else {
 		return NULL;
 	}
 }
 
+double tle_db_entry_epoch(struct tle_db *db, int tle_index)
+{
+	if (tle_db_entry_to_orbital_elements(db, tle_index) == NULL) {
+		return 0;
+	}
+	return db->cache[tle_index].epoch;
+}
+
 const char *tle_db_entry_name(const struct tle_db *db, int tle_index)
 {
 	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
@@ -524,6 +908,82 @@ const char *tle_db_entry_name(const struct tle_db *db, int tle_index)
 	return NULL;
 }
 
+/**
+ * Interned filenames, shared by all TLE databases.
+ **/
+struct tle_filename_table {
+	///Filenames. Never freed, so that returned pointers stay valid
+	char **filenames;
+	///Number of filenames
+	int num_filenames;
+	///Allocated size of the filenames array
+	int available_size;
+	///Lock protecting the table
+	pthread_mutex_t lock;
+};
+
+static struct tle_filename_table tle_filenames = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+int tle_db_intern_filename(const char *filename)
+{
+	pthread_mutex_lock(&(tle_filenames.lock));
+
+	//index 0 is reserved for the empty filename of zero-initialized entries
+	if (tle_filenames.num_filenames == 0) {
+		tle_filenames.available_size = 16;
+		tle_filenames.filenames = (char**)malloc(sizeof(char*)*tle_filenames.available_size);
+		tle_filenames.filenames[0] = strdup("");
+		tle_filenames.num_filenames = 1;
+	}
+
+	int filename_index = -1;
+	for (int i=0; i < tle_filenames.num_filenames; i++) {
+		if (strcmp(tle_filenames.filenames[i], filename) == 0) {
+			filename_index = i;
+			break;
+		}
+	}
+
+	if (filename_index == -1) {
+		if (tle_filenames.num_filenames == tle_filenames.available_size) {
+			tle_filenames.available_size *= 2;
+			tle_filenames.filenames = (char**)realloc(tle_filenames.filenames, sizeof(char*)*tle_filenames.available_size);
+		}
+		filename_index = tle_filenames.num_filenames;
+		tle_filenames.filenames[filename_index] = strdup(filename);
+		tle_filenames.num_filenames++;
+	}
+
+	pthread_mutex_unlock(&(tle_filenames.lock));
+	return filename_index;
+}
+
+const char *tle_db_interned_filename(int filename_index)
+{
+	const char *filename = "";
+	pthread_mutex_lock(&(tle_filenames.lock));
+	if ((filename_index > 0) && (filename_index < tle_filenames.num_filenames)) {
+		filename = tle_filenames.filenames[filename_index];
+	}
+	pthread_mutex_unlock(&(tle_filenames.lock));
+	return filename;
+}
+
+const char *tle_db_entry_filename(const struct tle_db *db, int tle_index)
+{
+	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
+		return tle_db_interned_filename(db->tles[tle_index].filename_index);
+	}
+	return NULL;
+}
+
+void tle_db_entry_set_filename(struct tle_db *db, int tle_index, const char *filename)
+{
+	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
+		db->tles[tle_index].filename_index = tle_db_intern_filename(filename);
+	}
+}
+
 void whitelist_from_file(const char *file, struct tle_db *db)
 {
 	for (int i=0; i < db->num_tles; i++) {
@@ -545,9 +1005,17 @@ void whitelist_from_file(const char *file, struct tle_db *db)
 string_array_t tle_db_filenames(const struct tle_db *db)
 {
 	string_array_t returned_list = {0};
+	int previous_filename_index = -1;
 	for (int i=0; i < db->num_tles; i++) {
-		if (string_array_find(&returned_list, db->tles[i].filename) == -1) {
-			string_array_add(&returned_list, db->tles[i].filename);
+		//entries from the same file are usually consecutive
+		if (db->tles[i].filename_index == previous_filename_index) {
+			continue;
+		}
+		previous_filename_index = db->tles[i].filename_index;
+
+		const char *filename = tle_db_interned_filename(previous_filename_index);
+		if (string_array_find(&returned_list, filename) == -1) {
+			string_array_add(&returned_list, filename);
 		}
 	}
 	return returned_list;
@@ -6,22 +6,38 @@
 #include "defines.h"
 #include <predict/predict.h>
 
+//Number of characters in a line of a NORAD TLE
+#define TLE_LINE_LENGTH 69
+
+//Maximum number of characters in satellite names read from TLE files
+#define TLE_NAME_LENGTH 24
+
 /**
  * Entry in TLE database.
  **/
 struct tle_db_entry {
 	///satellite number, parsed from TLE line 1
 	long satellite_number;
+	///Filename from which the TLE has been read, as index in the interned filename table (see tle_db_intern_filename()). 0 means no filename
+	int filename_index;
+	///Whether TLE entry is enabled for display
+	bool enabled;
 	///satellite name, defined in TLE file
-	char name[MAX_NUM_CHARS];
+	char name[TLE_NAME_LENGTH+1];
 	///line 1 in NORAD TLE
-	char line1[MAX_NUM_CHARS];
+	char line1[TLE_LINE_LENGTH+1];
 	///line 2 in NORAD TLE
-	char line2[MAX_NUM_CHARS];
-	///Filename from which the TLE has been read
-	char filename[MAX_NUM_CHARS];
-	///Whether TLE entry is enabled for display
-	bool enabled;
+	char line2[TLE_LINE_LENGTH+1];
+};
+
+/**
+ * Values derived from a TLE entry, parsed on first use.
+ **/
+struct tle_db_entry_cache {
+	///Parsed orbital elements, NULL if not parsed yet
+	predict_orbital_elements_t *orbital_elements;
+	///Epoch of the TLE as epoch year*1000 + epoch day, valid when `orbital_elements` is set
+	double epoch;
 };
 
 /**
@@ -36,6 +52,14 @@ struct tle_db {
 	size_t available_size;
 	///Whether TLE database was read from XDG standard paths or supplied on command line
 	bool read_from_xdg;
+	///Number of worker threads used for reading TLE files in tle_db_from_directory(). 0 uses the number of online CPUs
+	int num_loader_threads;
+	///Open-addressing hash table over satellite numbers. Contains (index in `tles`) + 1, 0 marks an empty slot
+	int *index_table;
+	///Number of slots in the hash table, always zero or a power of two
+	size_t index_table_size;
+	///Parsed orbital elements and epochs, one for each entry in `tles`. Cleared when the TLE lines of an entry change
+	struct tle_db_entry_cache *cache;
 };
 
 /**
@@ -79,8 +103,8 @@ enum tle_db_update_status {
  * Update internal TLE database with newer TLE entries located within supplied file, and update the corresponding file databases.
  * Following rules are used:
  *
- * - If the original TLE file is at a writable location: Update that file. Each file will be updated once.
- * - If the original TLE file is at a non-writable location, and the TLE database was read from XDG dirs: Create a new file in XDG_DATA_HOME/flyby/tle/, according to the filename defined in get_update_filename(). All TLEs will be written to the same file.
+ * - If the original TLE file is at a writable location: Update that file. Each file will be updated once, and replaced atomically.
+ * - If the original TLE file is at a non-writable location or could not be written, and the TLE database was read from XDG dirs: Create a new file in XDG_DATA_HOME/flyby/tle/, according to the filename defined in get_update_filename(). All TLEs will be written to the same file.
  *
  *  Update file will not be created if TLE database was not read from XDG, as it will be assumed that TLE files have been specified using the command line options, and it will be meaningless to create new files in any location.
  *
@@ -90,10 +114,34 @@ enum tle_db_update_status {
  **/
 void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status);
 
+/**
+ * Read TLE update files into one combined update set. Directories are read using tle_db_from_directory().
+ * When a satellite is defined in more than one file, the TLE with the most recent epoch is kept.
+ *
+ * \param filenames Paths to TLE files or directories containing TLE files
+ * \param ret_db Returned update set, merged into any existing entries
+ * \return Number of files that could not be read
+ **/
+int tle_db_update_set_from_files(string_array_t *filenames, struct tle_db *ret_db);
+
+/**
+ * Update internal TLE database with newer TLE entries from an update set, following the same rules as tle_db_update().
+ * All entries are applied in one pass, and each affected TLE file is rewritten at most once using tle_db_to_file().
+ *
+ * \param new_db Update set, e.g. read using tle_db_update_set_from_files()
+ * \param tle_db TLE database
+ * \param update_status Update status. Combines members in tle_db_update_status according to how each entry is treated
+ **/
+void tle_db_update_from_db(struct tle_db *new_db, struct tle_db *tle_db, int *update_status);
+
 /**
  * Read TLEs from files in specified directory. When TLE entries are multiply defined
  * across TLE files, the TLE entry with the most recent epoch is chosen.
  *
+ * Files are parsed in parallel by `ret_tle_db->num_loader_threads` worker threads, each file into
+ * its own temporary database. The temporary databases are merged in directory listing order
+ * afterwards, so the result does not depend on thread scheduling.
+ *
  * \param dirpath Directory from which files are to be read
  * \param ret_tle_db Returned TLE database
  **/
@@ -108,7 +156,9 @@ void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db);
 string_array_t tle_db_filenames(const struct tle_db *db);
 
 /**
- * Read TLE database from file.
+ * Read TLE database from file. The file is memory-mapped and parsed in place. Both LF and CRLF line endings
+ * are accepted, the last line does not need to be terminated, and the "0 " prefix of name lines in
+ * three-line element sets (3LE) is removed.
  *
  * \param tle_file TLE database file
  * \param ret_db Returned TLE database
@@ -117,7 +167,8 @@ string_array_t tle_db_filenames(const struct tle_db *db);
 int tle_db_from_file(const char *tle_file, struct tle_db *ret_db);
 
 /**
- * Write contents of TLE database to file.
+ * Write contents of TLE database to file. The database is written to a temporary file in the same directory
+ * and renamed over the target file, so that the file never is left partially written.
  *
  * \param filename Filename
  * \param tle_db TLE database to write
@@ -136,7 +187,9 @@ enum tle_merge_behavior {
 };
 
 /**
- * Merge two TLE databases.
+ * Merge two TLE databases. Entries in the new database are matched against the existing database
+ * using its satellite number index, so the merge runs in time linear in the size of the new database.
+ * New entries are appended in the order they appear in the new database.
  *
  * \param new_db New TLE database to merge into an existing one
  * \param main_db Existing TLE database into which new TLE database is to be merged
@@ -171,7 +224,9 @@ void tle_db_overwrite_entry(int entry_index, struct tle_db *tle_db, const struct
 void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry);
 
 /**
- * Find TLE entry within TLE database. Searches with respect to the satellite number.
+ * Find TLE entry within TLE database. Searches with respect to the satellite number
+ * using the hash index kept up to date by tle_db_add_entry() and tle_db_overwrite_entry().
+ * When the satellite number is multiply defined, the lowest index is returned.
  *
  * \param tle_db TLE database
  * \param satellite_number Lookup satellite number
@@ -198,13 +253,24 @@ void tle_db_entry_set_enabled(struct tle_db *db, int tle_index, bool enabled);
 bool tle_db_entry_enabled(const struct tle_db *db, int tle_index);
 
 /**
- * Parse TLE database entry as an orbital elements struct.
+ * Get orbital elements of TLE database entry. The TLE is parsed on the first call and cached within the TLE
+ * database, and the same struct is returned until the entry is overwritten with different TLE lines or the
+ * database is cleared or destroyed. Not thread-safe.
  *
  * \param db TLE database
  * \param tle_index Index in TLE database
- * \return Orbital elements of TLE database entry
+ * \return Orbital elements of TLE database entry, owned by the TLE database. NULL if the index is out of range
  **/
-predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db *db, int tle_index);
+predict_orbital_elements_t *tle_db_entry_to_orbital_elements(struct tle_db *db, int tle_index);
+
+/**
+ * Get epoch of TLE database entry, from the cached orbital elements (see tle_db_entry_to_orbital_elements()).
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \return Epoch as epoch year*1000 + epoch day, comparable between entries. 0 if the index is out of range
+ **/
+double tle_db_entry_epoch(struct tle_db *db, int tle_index);
 
 /**
  * Get name of satellite corresponding to defined TLE entry.
@@ -215,6 +281,41 @@ predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db
  **/
 const char *tle_db_entry_name(const struct tle_db *db, int tle_index);
 
+/**
+ * Get filename from which the defined TLE entry has been read.
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \return Filename, empty string if not set
+ **/
+const char *tle_db_entry_filename(const struct tle_db *db, int tle_index);
+
+/**
+ * Set filename of defined TLE entry.
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \param filename Filename
+ **/
+void tle_db_entry_set_filename(struct tle_db *db, int tle_index, const char *filename);
+
+/**
+ * Get index of filename in the interned filename table, adding it if not already present. The table is shared
+ * by all TLE databases, so that entries can be copied between databases without remapping. Thread-safe.
+ *
+ * \param filename Filename
+ * \return Index in filename table
+ **/
+int tle_db_intern_filename(const char *filename);
+
+/**
+ * Get filename from the interned filename table. Thread-safe.
+ *
+ * \param filename_index Index in filename table
+ * \return Filename, empty string if index is out of range. The string is valid for the lifetime of the program
+ **/
+const char *tle_db_interned_filename(int filename_index);
+
 /**
  * Set TLE database entries to enabled according to whitelist file in search paths. Default is to let
  * TLE entry be disabled.
@@ -0,0 +1,295 @@
+#include "tle_db_watcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "xdg_basedirs.h"
+
+//inotify events signifying that a file has been completely written
+#define TLE_DB_WATCHER_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+/**
+ * Get precedence of directory a TLE file is located in.
+ *
+ * \param watcher Watcher
+ * \param filename TLE filename
+ * \return Index of directory in watched TLE directories, or number of watched directories if not located in any of them
+ **/
+int tle_db_watcher_precedence(struct tle_db_watcher *watcher, const char *filename)
+{
+	int num_dirs = string_array_size(&(watcher->tle_dirs));
+	for (int i=0; i < num_dirs; i++) {
+		const char *dir = string_array_get(&(watcher->tle_dirs), i);
+		int dir_length = strlen(dir);
+		if ((strncmp(filename, dir, dir_length) == 0) && (strchr(filename + dir_length, '/') == NULL)) {
+			return i;
+		}
+	}
+	return num_dirs;
+}
+
+/**
+ * Read changed TLE files and queue them for merging into the live TLE database. Files that no longer exist
+ * (e.g. temporary files that have been renamed) are skipped.
+ *
+ * \param watcher Watcher
+ * \param changed_files Changed TLE files
+ * \param transponder_db_changed Whether any transponder database has changed
+ **/
+void tle_db_watcher_read_changes(struct tle_db_watcher *watcher, string_array_t *changed_files, bool transponder_db_changed)
+{
+	int num_files = string_array_size(changed_files);
+	struct tle_db_watcher_update *updates = (struct tle_db_watcher_update*)malloc(sizeof(struct tle_db_watcher_update)*(num_files+1));
+	int num_updates = 0;
+	for (int i=0; i < num_files; i++) {
+		const char *filename = string_array_get(changed_files, i);
+		struct stat file_stat;
+		if ((stat(filename, &file_stat) != 0) || !S_ISREG(file_stat.st_mode)) {
+			continue;
+		}
+
+		struct tle_db *tle_db = tle_db_create();
+		if ((tle_db_from_file(filename, tle_db) == 0) && (tle_db->num_tles > 0)) {
+			updates[num_updates].tle_db = tle_db;
+			updates[num_updates].precedence = tle_db_watcher_precedence(watcher, filename);
+			num_updates++;
+		} else {
+			tle_db_destroy(&tle_db);
+		}
+	}
+
+	pthread_mutex_lock(&(watcher->lock));
+	watcher->updates = (struct tle_db_watcher_update*)realloc(watcher->updates, sizeof(struct tle_db_watcher_update)*(watcher->num_updates + num_updates));
+	memcpy(watcher->updates + watcher->num_updates, updates, sizeof(struct tle_db_watcher_update)*num_updates);
+	watcher->num_updates += num_updates;
+	watcher->transponder_db_changed = watcher->transponder_db_changed || transponder_db_changed;
+	pthread_mutex_unlock(&(watcher->lock));
+	free(updates);
+}
+
+/**
+ * Background thread. Collects file events until no further events have arrived within TLE_DB_WATCHER_SETTLE_TIME,
+ * and reads the changed files.
+ *
+ * \param data Watcher
+ * \return NULL
+ **/
+void *tle_db_watcher_thread(void *data)
+{
+	struct tle_db_watcher *watcher = (struct tle_db_watcher*)data;
+	string_array_t changed_files = {0};
+	bool transponder_db_changed = false;
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	while (true) {
+		struct pollfd fds[2] = {{.fd = watcher->inotify_fd, .events = POLLIN}, {.fd = watcher->stop_pipe[0], .events = POLLIN}};
+		bool has_changes = (string_array_size(&changed_files) > 0) || transponder_db_changed;
+		int retval = poll(fds, 2, has_changes ? TLE_DB_WATCHER_SETTLE_TIME : -1);
+
+		if ((retval < 0) && (errno == EINTR)) {
+			continue;
+		} else if ((retval < 0) || (fds[1].revents != 0)) {
+			break;
+		}
+
+		if (retval == 0) {
+			//no events within the settle time
+			tle_db_watcher_read_changes(watcher, &changed_files, transponder_db_changed);
+			string_array_free(&changed_files);
+			transponder_db_changed = false;
+			continue;
+		}
+
+		ssize_t length = read(watcher->inotify_fd, buffer, sizeof(buffer));
+		for (char *ptr = buffer; ptr < buffer + length; ) {
+			struct inotify_event *event = (struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+			if ((event->len == 0) || !(event->mask & TLE_DB_WATCHER_EVENTS)) {
+				continue;
+			}
+
+			//changed TLE file
+			for (int i=0; i < string_array_size(&(watcher->tle_dirs)); i++) {
+				if (watcher->tle_dir_watches[i] == event->wd) {
+					char filename[MAX_NUM_CHARS];
+					snprintf(filename, MAX_NUM_CHARS, "%s%s", string_array_get(&(watcher->tle_dirs), i), event->name);
+					if (string_array_find(&changed_files, filename) == -1) {
+						string_array_add(&changed_files, filename);
+					}
+				}
+			}
+
+			//changed transponder database
+			for (int i=0; i < watcher->num_transponder_dirs; i++) {
+				if ((watcher->transponder_dir_watches[i] == event->wd) && (strcmp(event->name, "flyby.db") == 0)) {
+					transponder_db_changed = true;
+				}
+			}
+		}
+	}
+
+	string_array_free(&changed_files);
+	return NULL;
+}
+
+struct tle_db_watcher *tle_db_watcher_create(bool watch_tle_dirs)
+{
+	int inotify_fd = inotify_init1(IN_CLOEXEC);
+	if (inotify_fd == -1) {
+		return NULL;
+	}
+
+	struct tle_db_watcher *watcher = (struct tle_db_watcher*)calloc(1, sizeof(struct tle_db_watcher));
+	watcher->inotify_fd = inotify_fd;
+	pthread_mutex_init(&(watcher->lock), NULL);
+
+	//data directories in order of precedence
+	string_array_t data_dirs = {0};
+	char *data_home = xdg_data_home();
+	string_array_add(&data_dirs, data_home);
+	free(data_home);
+	char *data_dirs_str = xdg_data_dirs();
+	stringsplit(data_dirs_str, &data_dirs);
+	free(data_dirs_str);
+
+	int num_dirs = string_array_size(&data_dirs);
+	watcher->tle_dir_watches = (int*)malloc(sizeof(int)*num_dirs);
+	watcher->transponder_dir_watches = (int*)malloc(sizeof(int)*num_dirs);
+	watcher->num_transponder_dirs = num_dirs;
+	for (int i=0; i < num_dirs; i++) {
+		char path[MAX_NUM_CHARS];
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), TLE_RELATIVE_DIR_PATH);
+		string_array_add(&(watcher->tle_dirs), path);
+		watcher->tle_dir_watches[i] = -1;
+		if (watch_tle_dirs) {
+			watcher->tle_dir_watches[i] = inotify_add_watch(inotify_fd, path, TLE_DB_WATCHER_EVENTS);
+		}
+
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), FLYBY_RELATIVE_ROOT_PATH);
+		watcher->transponder_dir_watches[i] = inotify_add_watch(inotify_fd, path, TLE_DB_WATCHER_EVENTS);
+	}
+	string_array_free(&data_dirs);
+
+	bool pipe_created = (pipe(watcher->stop_pipe) == 0);
+	if (!pipe_created || (pthread_create(&(watcher->thread), NULL, tle_db_watcher_thread, watcher) != 0)) {
+		if (pipe_created) {
+			close(watcher->stop_pipe[0]);
+			close(watcher->stop_pipe[1]);
+		}
+		close(inotify_fd);
+		string_array_free(&(watcher->tle_dirs));
+		free(watcher->tle_dir_watches);
+		free(watcher->transponder_dir_watches);
+		pthread_mutex_destroy(&(watcher->lock));
+		free(watcher);
+		return NULL;
+	}
+	return watcher;
+}
+
+/**
+ * Merge parsed TLE file into the TLE database, according to the rules in tle_db_watcher_apply().
+ *
+ * \param watcher Watcher
+ * \param update Parsed TLE file
+ * \param tle_db TLE database
+ * \param updated_tles Array over updated entries, set to true for entries that are updated
+ * \return Number of updated entries
+ **/
+int tle_db_watcher_merge(struct tle_db_watcher *watcher, struct tle_db_watcher_update *update, struct tle_db *tle_db, bool *updated_tles)
+{
+	int num_updated = 0;
+	for (int i=0; i < update->tle_db->num_tles; i++) {
+		struct tle_db_entry *new_entry = &(update->tle_db->tles[i]);
+		int index = tle_db_find_entry(tle_db, new_entry->satellite_number);
+		if (index == -1) {
+			continue;
+		}
+
+		struct tle_db_entry *entry = &(tle_db->tles[index]);
+		if ((strcmp(entry->line1, new_entry->line1) == 0) && (strcmp(entry->line2, new_entry->line2) == 0)) {
+			continue;
+		}
+
+		bool should_update = (entry->filename_index == new_entry->filename_index);
+		if (!should_update) {
+			int precedence = tle_db_watcher_precedence(watcher, tle_db_entry_filename(tle_db, index));
+			should_update = (update->precedence < precedence) ||
+				((update->precedence == precedence) && (tle_db_entry_epoch(update->tle_db, i) > tle_db_entry_epoch(tle_db, index)));
+		}
+
+		if (should_update) {
+			tle_db_overwrite_entry(index, tle_db, new_entry);
+			if (!updated_tles[index]) {
+				updated_tles[index] = true;
+				num_updated++;
+			}
+		}
+	}
+	return num_updated;
+}
+
+int tle_db_watcher_apply(struct tle_db_watcher *watcher, struct tle_db *tle_db, struct transponder_db *transponder_db, bool *updated_tles)
+{
+	pthread_mutex_lock(&(watcher->lock));
+	struct tle_db_watcher_update *updates = watcher->updates;
+	int num_updates = watcher->num_updates;
+	bool transponder_db_changed = watcher->transponder_db_changed;
+	watcher->updates = NULL;
+	watcher->num_updates = 0;
+	watcher->transponder_db_changed = false;
+	pthread_mutex_unlock(&(watcher->lock));
+
+	for (int i=0; i < tle_db->num_tles; i++) {
+		updated_tles[i] = false;
+	}
+
+	int num_updated = 0;
+	for (int i=0; i < num_updates; i++) {
+		num_updated += tle_db_watcher_merge(watcher, &(updates[i]), tle_db, updated_tles);
+		tle_db_destroy(&(updates[i].tle_db));
+	}
+	free(updates);
+
+	if (transponder_db_changed && (transponder_db != NULL)) {
+		//load into an empty database and swap it in, so that entries removed from the files are not kept
+		struct transponder_db *new_transponder_db = transponder_db_create(tle_db);
+		transponder_db_from_search_paths(tle_db, new_transponder_db);
+		struct transponder_db old_transponder_db = *transponder_db;
+		*transponder_db = *new_transponder_db;
+		*new_transponder_db = old_transponder_db;
+		transponder_db_destroy(&new_transponder_db);
+	}
+	return num_updated;
+}
+
+void tle_db_watcher_destroy(struct tle_db_watcher **watcher)
+{
+	if (*watcher == NULL) {
+		return;
+	}
+
+	//stop background thread
+	char stop = 1;
+	if (write((*watcher)->stop_pipe[1], &stop, 1) == 1) {
+		pthread_join((*watcher)->thread, NULL);
+	}
+	close((*watcher)->stop_pipe[0]);
+	close((*watcher)->stop_pipe[1]);
+	close((*watcher)->inotify_fd);
+
+	for (int i=0; i < (*watcher)->num_updates; i++) {
+		tle_db_destroy(&((*watcher)->updates[i].tle_db));
+	}
+	free((*watcher)->updates);
+	string_array_free(&((*watcher)->tle_dirs));
+	free((*watcher)->tle_dir_watches);
+	free((*watcher)->transponder_dir_watches);
+	pthread_mutex_destroy(&((*watcher)->lock));
+	free(*watcher);
+	*watcher = NULL;
+}
@@ -0,0 +1,91 @@
+#ifndef TLE_DB_WATCHER_H_DEFINED
+#define TLE_DB_WATCHER_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "string_array.h"
+#include "tle_db.h"
+#include "transponder_db.h"
+
+/**
+ * Hot reload of TLE files and transponder databases. The TLE directories and the transponder database
+ * directories in the XDG data directories are watched using inotify. Changed TLE files are parsed in a
+ * background thread, and merged into the live TLE database from the UI thread using tle_db_watcher_apply().
+ **/
+
+//Time without further file events before changed files are read, in milliseconds
+#define TLE_DB_WATCHER_SETTLE_TIME 500
+
+/**
+ * TLE file that has been parsed in the background, waiting to be merged into the live TLE database.
+ **/
+struct tle_db_watcher_update {
+	///Parsed TLE entries
+	struct tle_db *tle_db;
+	///Precedence of the directory the file is located in, 0 is highest
+	int precedence;
+};
+
+/**
+ * Watcher for TLE files and transponder databases.
+ **/
+struct tle_db_watcher {
+	///inotify file descriptor
+	int inotify_fd;
+	///Pipe used for stopping the background thread
+	int stop_pipe[2];
+	///Background thread
+	pthread_t thread;
+	///Watched TLE directories in order of precedence (XDG_DATA_HOME first, then XDG_DATA_DIRS), with trailing '/'
+	string_array_t tle_dirs;
+	///inotify watch descriptors of the TLE directories, -1 if not watched
+	int *tle_dir_watches;
+	///inotify watch descriptors of the directories containing flyby.db, -1 if not watched
+	int *transponder_dir_watches;
+	///Number of transponder database directories
+	int num_transponder_dirs;
+	///Lock protecting the fields below
+	pthread_mutex_t lock;
+	///Parsed TLE files waiting to be merged
+	struct tle_db_watcher_update *updates;
+	///Number of parsed TLE files waiting to be merged
+	int num_updates;
+	///Whether any transponder database file has changed
+	bool transponder_db_changed;
+};
+
+/**
+ * Start watching the XDG data directories for changed TLE files and transponder databases.
+ *
+ * \param watch_tle_dirs Whether to watch the TLE directories. Should be false when TLEs are read from files specified on the command line
+ * \return Watcher, or NULL if inotify is not available
+ **/
+struct tle_db_watcher *tle_db_watcher_create(bool watch_tle_dirs);
+
+/**
+ * Merge TLE files that have changed since the last call into the TLE database, and reload the transponder
+ * database if it has changed. Entries are only updated, never added or removed, so that indices into the
+ * TLE database and the transponder database stay valid. Each entry is updated from a changed file when:
+ *
+ * - The entry originally was read from the same file
+ * - The file is located in a directory of higher precedence than the file the entry was read from
+ * - The file is located in the same directory, and the TLE is more recent
+ *
+ * Has to be called from the same thread as the one using the databases.
+ *
+ * \param watcher Watcher
+ * \param tle_db TLE database
+ * \param transponder_db Transponder database
+ * \param updated_tles Returned array of at least tle_db->num_tles length, set to true for updated entries
+ * \return Number of updated entries
+ **/
+int tle_db_watcher_apply(struct tle_db_watcher *watcher, struct tle_db *tle_db, struct transponder_db *transponder_db, bool *updated_tles);
+
+/**
+ * Stop watching and free watcher.
+ *
+ * \param watcher Watcher
+ **/
+void tle_db_watcher_destroy(struct tle_db_watcher **watcher);
+
+#endif
@@ -521,7 +521,7 @@ void transponder_form_sysdefault(struct transponder_form *transponder_form, stru
 {
 	//create dummy TLE database with a single entry corresponding to the satellite number
 	struct tle_db *dummy_tle_db = tle_db_create();
-	struct tle_db_entry dummy_entry;
+	struct tle_db_entry dummy_entry = {0};
 	dummy_entry.satellite_number = transponder_form->satellite_number;
 	tle_db_add_entry(dummy_tle_db, &dummy_entry);
 	struct transponder_db *dummy_transponder_db = transponder_db_create(dummy_tle_db);
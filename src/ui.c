@@ -8,11 +8,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include "filtered_menu.h"
 #include "ui.h"
 #include "qth_config.h"
 #include "transponder_editor.h"
 #include "multitrack.h"
+#include "tle_db_watcher.h"
+#include "pass_cache.h"
 #include "locator.h"
 #include "hamlib_status.h"
 
@@ -60,6 +63,108 @@ void any_key()
 	getch();
 }
 
+/**
+ * Print text to the standard screen in interactive mode, and to stdout otherwise.
+ *
+ * \param interactive_mode Whether curses is running
+ * \param format Format string
+ **/
+void update_tle_print(bool interactive_mode, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	if (interactive_mode) {
+		vw_printw(stdscr, format, args);
+	} else {
+		vprintf(format, args);
+	}
+	va_end(args);
+}
+
+/**
+ * Print updated entries after a TLE database update, followed by a summary for each TLE file the updated entries
+ * belong to.
+ *
+ * \param tle_db TLE database
+ * \param update_status Update status as returned by tle_db_update_from_db()
+ * \param interactive_mode Whether curses is running
+ **/
+void update_tle_database_report(struct tle_db *tle_db, const int *update_status, bool interactive_mode)
+{
+	int num_updated = 0;
+	bool in_new_file = false;
+	bool not_written = false;
+	char new_file[MAX_NUM_CHARS] = {0};
+
+	//filename indices of the files containing updated entries, with number of updated entries and update status
+	int num_files = 0;
+	int *files = (int*)malloc(sizeof(int)*tle_db->num_tles);
+	int *file_num_updated = (int*)calloc(tle_db->num_tles, sizeof(int));
+	int *file_status = (int*)calloc(tle_db->num_tles, sizeof(int));
+
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (update_status[i] & TLE_DB_UPDATED) {
+			//print updated entries
+			update_tle_print(interactive_mode, "Updated %s (%ld)", tle_db->tles[i].name, tle_db->tles[i].satellite_number);
+			if (update_status[i] & TLE_IN_NEW_FILE) {
+				if (!in_new_file) {
+					strncpy(new_file, tle_db_entry_filename(tle_db, i), MAX_NUM_CHARS);
+				}
+
+				in_new_file = true;
+				update_tle_print(interactive_mode, " (*)");
+			}
+			if (!(update_status[i] & TLE_IN_NEW_FILE) && !(update_status[i] & TLE_FILE_UPDATED)) {
+				not_written = true;
+				update_tle_print(interactive_mode, " (X)");
+			}
+			update_tle_print(interactive_mode, "\n");
+			num_updated++;
+
+			//count updated entries per file
+			int file = 0;
+			while ((file < num_files) && (files[file] != tle_db->tles[i].filename_index)) {
+				file++;
+			}
+			if (file == num_files) {
+				files[file] = tle_db->tles[i].filename_index;
+				num_files++;
+			}
+			file_num_updated[file]++;
+			file_status[file] |= update_status[i];
+		}
+	}
+
+	//print file information
+	if (in_new_file) {
+		update_tle_print(interactive_mode, "\nSatellites marked with (*) were put in a new file (%s).\n", new_file);
+	}
+	if (not_written) {
+		update_tle_print(interactive_mode, "\nSatellites marked with (X) were not written to file.");
+	}
+
+	if (num_files > 0) {
+		update_tle_print(interactive_mode, "\nSummary:\n");
+		for (int i=0; i < num_files; i++) {
+			const char *written = "not written";
+			if (file_status[i] & TLE_IN_NEW_FILE) {
+				written = "new file";
+			} else if (file_status[i] & TLE_FILE_UPDATED) {
+				written = "written";
+			}
+			update_tle_print(interactive_mode, "%s: %d updated, %s\n", tle_db_interned_filename(files[i]), file_num_updated[i], written);
+		}
+	}
+
+	if (num_updated == 0) {
+		update_tle_print(interactive_mode, "No TLE updates/file not found.\n");
+	}
+
+	free(files);
+	free(file_num_updated);
+	free(file_status);
+}
+
 void update_tle_database(const char *string, struct tle_db *tle_db)
 {
 	bool interactive_mode = (string[0] == '\0');
@@ -98,77 +203,35 @@ void update_tle_database(const char *string, struct tle_db *tle_db)
 		move(12, 0);
 	}
 
-	int num_updated = 0;
-	bool in_new_file = false;
-	bool not_written = false;
-	char new_file[MAX_NUM_CHARS] = {0};
-	for (int i=0; i < tle_db->num_tles; i++) {
-		if (update_status[i] & TLE_DB_UPDATED) {
-			//print updated entries
-			if (interactive_mode) {
-				printw("Updated %s (%ld)", tle_db->tles[i].name, tle_db->tles[i].satellite_number);
-			} else {
-				printf("Updated %s (%ld)", tle_db->tles[i].name, tle_db->tles[i].satellite_number);
-			}
-			if (update_status[i] & TLE_IN_NEW_FILE) {
-				if (!in_new_file) {
-					strncpy(new_file, tle_db->tles[i].filename, MAX_NUM_CHARS);
-				}
-
-				in_new_file = true;
-				if (interactive_mode) {
-					printw(" (*)");
-				} else {
-					printf(" (*)");
-				}
-			}
-			if (!(update_status[i] & TLE_IN_NEW_FILE) && !(update_status[i] & TLE_FILE_UPDATED)) {
-				not_written = true;
-				if (interactive_mode) {
-					printw(" (X)");
-				} else {
-					printf(" (X)");
-				}
-			}
-			if (interactive_mode) {
-				printw("\n");
-			} else {
-				printf("\n");
-			}
-			num_updated++;
-		}
-	}
+	update_tle_database_report(tle_db, update_status, interactive_mode);
 	free(update_status);
 
-	//print file information
 	if (interactive_mode) {
-		if (in_new_file) {
-			printw("\nSatellites marked with (*) were put in a new file (%s).\n", new_file);
-		}
-		if (not_written) {
-			printw("\nSatellites marked with (X) were not written to file.");
-		}
-	} else {
-		if (in_new_file) {
-			printf("\nSatellites marked with (*) were put in a new file (%s).\n", new_file);
-		}
-		if (not_written) {
-			printf("\nSatellites marked with (X) were not written to file.");
-		}
+		refresh();
+		any_key();
 	}
+}
 
-	if (num_updated == 0) {
-		if (interactive_mode) {
-			printw("No TLE updates/file not found.\n");
-		} else {
-			printf("No TLE updates/file not found.\n");
-		}
+void update_tle_database_from_files(string_array_t *filenames, struct tle_db *tle_db)
+{
+	//combine all update files into one update set
+	struct tle_db *update_db = tle_db_create();
+	update_db->num_loader_threads = tle_db->num_loader_threads;
+	for (int i=0; i < string_array_size(filenames); i++) {
+		printf("Reading TLE updates from %s\n", string_array_get(filenames, i));
 	}
-
-	if (interactive_mode) {
-		refresh();
-		any_key();
+	int num_failed = tle_db_update_set_from_files(filenames, update_db);
+	if (num_failed > 0) {
+		fprintf(stderr, "%d update file(s) could not be read.\n", num_failed);
 	}
+	printf("\n");
+
+	//update TLE database and files in one pass
+	int *update_status = (int*)calloc(tle_db->num_tles, sizeof(int));
+	tle_db_update_from_db(update_db, tle_db, update_status);
+	update_tle_database_report(tle_db, update_status, false);
+	free(update_status);
+	tle_db_destroy(&update_db);
 }
 
 long date_to_daynumber(int m, int d, int y);
@@ -814,7 +877,7 @@ void print_rigctld_info(const char *name, rigctld_info_t *rigctld)
 /**
  * Display program information.
  **/
-void general_program_info(const char *qthfile, struct tle_db *tle_db, struct transponder_db *transponder_db, rotctld_info_t *rotctld, rigctld_info_t* downlink, rigctld_info_t *uplink)
+void general_program_info(const char *qthfile, struct tle_db *tle_db, struct transponder_db *transponder_db, multitrack_listing_t *listing, rotctld_info_t *rotctld, rigctld_info_t* downlink, rigctld_info_t *uplink)
 {
 	flyby_banner();
 	attrset(COLOR_PAIR(3)|A_BOLD);
@@ -835,6 +898,12 @@ void general_program_info(const char *qthfile, struct tle_db *tle_db, struct tra
 	} else {
 		printw("Not loaded\n");
 	}
+	printw("\t\tListing updates : ");
+	if (listing->num_updates > 0) {
+		printw("%d of %d satellites propagated in last update, %.1f propagations saved per update\n", listing->num_due_entries, listing->num_entries, listing->num_saved_propagations/(1.0*listing->num_updates));
+	} else {
+		printw("None\n");
+	}
 
 	if (rotctld->connected) {
 		printw("\n");
@@ -856,35 +925,33 @@ void general_program_info(const char *qthfile, struct tle_db *tle_db, struct tra
 	any_key();
 }
 
-void print_sun_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum)
+void print_sun_box(int row, int col, const struct ephemeris_context *context)
 {
-	struct predict_observation sun;
-	predict_observe_sun(qth, daynum, &sun);
+	const struct predict_observation *sun = &(context->sun);
 
 	attrset(COLOR_PAIR(4)|A_REVERSE|A_BOLD);
 	mvprintw(row++,col,"   Sun   ");
-	if (sun.elevation > 0.0)
+	if (sun->elevation > 0.0)
 		attrset(COLOR_PAIR(3)|A_BOLD);
 	else
 		attrset(COLOR_PAIR(2));
-	mvprintw(row++,col,"%-7.2fAz",sun.azimuth*180.0/M_PI);
-	mvprintw(row++,col,"%+-6.2f El",sun.elevation*180.0/M_PI);
+	mvprintw(row++,col,"%-7.2fAz",sun->azimuth*180.0/M_PI);
+	mvprintw(row++,col,"%+-6.2f El",sun->elevation*180.0/M_PI);
 }
 
-void print_moon_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum)
+void print_moon_box(int row, int col, const struct ephemeris_context *context)
 {
-	struct predict_observation moon;
-	predict_observe_moon(qth, daynum, &moon);
+	const struct predict_observation *moon = &(context->moon);
 
 	attrset(COLOR_PAIR(4)|A_REVERSE|A_BOLD);
 	mvprintw(row++,col,"   Moon  ");
 	attrset(COLOR_PAIR(3)|A_BOLD);
-	if (moon.elevation > 0.0)
+	if (moon->elevation > 0.0)
 		attrset(COLOR_PAIR(1)|A_BOLD);
 	else
 		attrset(COLOR_PAIR(1));
-	mvprintw(row++,col,"%-7.2fAz",moon.azimuth*180.0/M_PI);
-	mvprintw(row++,col,"%+-6.2f El",moon.elevation*180.0/M_PI);
+	mvprintw(row++,col,"%-7.2fAz",moon->azimuth*180.0/M_PI);
+	mvprintw(row++,col,"%+-6.2f El",moon->elevation*180.0/M_PI);
 }
 
 void print_qth_box(int row, int col, predict_observer_t *qth)
@@ -898,7 +965,7 @@ void print_qth_box(int row, int col, predict_observer_t *qth)
 	mvprintw(row++,col,"%9s",maidenstr);
 }
 
-void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t *observer, struct tle_db *tle_db, struct transponder_db *sat_db, rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink)
+void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t *observer, struct tle_db *tle_db, struct transponder_db *sat_db, rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink, int num_threads, const struct pass_sampler_resolution *pass_resolution, double sun_elevation_limit)
 {
 	/* Start ncurses */
 	initscr();
@@ -928,8 +995,15 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 
 	predict_julian_date_t curr_time = predict_to_julian(time(NULL));
 
+	//predict upcoming passes in the background
+	struct pass_cache *pass_cache = pass_cache_create(observer, tle_db);
+
 	//prepare multitrack window
-	multitrack_listing_t *listing = multitrack_create_listing(observer, tle_db);
+	multitrack_listing_t *listing = multitrack_create_listing(observer, tle_db, pass_cache, num_threads);
+
+	//watch TLE files and transponder database for changes, TLE files only when read from the XDG directories
+	struct tle_db_watcher *watcher = tle_db_watcher_create(tle_db->read_from_xdg);
+	bool *updated_tles = (bool*)calloc(tle_db->num_tles, sizeof(bool));
 
 	//window for printing main menu options
 	WINDOW *main_menu_win = newwin(MAIN_MENU_OPTS_WIN_HEIGHT, COLS, LINES-MAIN_MENU_OPTS_WIN_HEIGHT, 0);
@@ -957,15 +1031,24 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 
 		curr_time = predict_to_julian(time(NULL));
 
-		//refresh satellite list
-		multitrack_update_listing_data(listing, curr_time);
+		//merge TLE files that have changed on disk
+		if ((watcher != NULL) && (tle_db_watcher_apply(watcher, tle_db, sat_db, updated_tles) > 0)) {
+			pass_cache_update_satellites(pass_cache, tle_db);
+			multitrack_refresh_updated_tles(listing, tle_db, updated_tles);
+		}
+
+		//refresh satellite list, using the same time and observer dependent quantities for all satellites
+		struct ephemeris_context context;
+		ephemeris_context_update(&context, observer, curr_time);
+		ephemeris_context_update_moon(&context);
+		multitrack_update_listing_data(listing, &context);
 		multitrack_display_listing(listing);
 
 		if (!multitrack_search_field_visible(listing->search_field)) {
 			print_main_menu(main_menu_win);
 		}
-		print_sun_box(listing->window_height + listing->window_row - 7, listing->window_width+1, observer, curr_time);
-		print_moon_box(listing->window_height + listing->window_row - 7 + 4, listing->window_width+1, observer, curr_time);
+		print_sun_box(listing->window_height + listing->window_row - 7, listing->window_width+1, &context);
+		print_moon_box(listing->window_height + listing->window_row - 7 + 4, listing->window_width+1, &context);
 		print_qth_box(listing->window_row, listing->window_width+1, observer);
 
 		//get input character
@@ -987,13 +1070,13 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 				const char *sat_name = tle_db->tles[satellite_index].name;
 				switch (option) {
 					case OPTION_SINGLETRACK:
-						singletrack(satellite_index, observer, sat_db, tle_db, rotctld, downlink, uplink);
+						singletrack(satellite_index, observer, sat_db, tle_db, pass_cache, rotctld, downlink, uplink);
 						break;
 					case OPTION_PREDICT_VISIBLE:
-						satellite_pass_display_schedule(sat_name, orbital_elements, observer, 'v');
+						satellite_pass_display_schedule(sat_name, orbital_elements, observer, pass_cache, satellite_index, pass_resolution, sun_elevation_limit, 'v');
 						break;
 					case OPTION_PREDICT:
-						satellite_pass_display_schedule(sat_name, orbital_elements, observer, 'p');
+						satellite_pass_display_schedule(sat_name, orbital_elements, observer, pass_cache, satellite_index, pass_resolution, sun_elevation_limit, 'p');
 						break;
 					case OPTION_DISPLAY_ORBITAL_DATA:
 						orbital_elements_display(sat_name, orbital_elements);
@@ -1002,10 +1085,9 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						transponder_database_editor(satellite_index, tle_db, sat_db);
 						break;
 					case OPTION_SOLAR_ILLUMINATION:
-						solar_illumination_display_predictions(sat_name, orbital_elements);
+						solar_illumination_display_predictions(sat_name, orbital_elements, num_threads);
 						break;
 				}
-				predict_destroy_orbital_elements(orbital_elements);
 				clear();
 				refresh();
 			}
@@ -1027,6 +1109,8 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						case 'U':
 						case 'u':
 							update_tle_database("", tle_db);
+							pass_cache_update_satellites(pass_cache, tle_db);
+							multitrack_refresh_tles(listing, tle_db);
 							break;
 
 						case 'M':
@@ -1047,17 +1131,19 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						case 'G':
 						case 'g':
 							qth_editor(qthfile, observer);
-							multitrack_refresh_tles(listing, tle_db);
+							pass_cache_set_observer(pass_cache, observer);
+							multitrack_refresh_passes(listing);
 							break;
 
 						case 'I':
 						case 'i':
-							general_program_info(qthfile, tle_db, sat_db, rotctld, downlink, uplink);
+							general_program_info(qthfile, tle_db, sat_db, listing, rotctld, downlink, uplink);
 							break;
 
 						case 'w':
 						case 'W':
 							whitelist_editor(tle_db, sat_db);
+							pass_cache_update_satellites(pass_cache, tle_db);
 							multitrack_refresh_tles(listing, tle_db);
 							break;
 						case 'E':
@@ -1084,4 +1170,7 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 
 	delwin(main_menu_win);
 	multitrack_destroy_listing(&listing);
+	pass_cache_destroy(&pass_cache);
+	tle_db_watcher_destroy(&watcher);
+	free(updated_tles);
 }
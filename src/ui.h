@@ -5,6 +5,8 @@
 #include <predict/predict.h>
 #include "tle_db.h"
 #include "transponder_db.h"
+#include "ephemeris_context.h"
+#include "pass_sampler.h"
 #include <curses.h>
 
 void any_key();
@@ -14,20 +16,18 @@ void any_key();
  *
  * \param row Start row for printing
  * \param col Start column for printing
- * \param qth QTH coordinates
- * \param daynum Time for calculation
+ * \param context Ephemeris context for the QTH at the time of calculation
  **/
-void print_sun_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum);
+void print_sun_box(int row, int col, const struct ephemeris_context *context);
 
 /**
  * Print moon azimuth/elevation to infobox on the standard screen.
  *
  * \param row Start row for printing
  * \param col Start column for printing
- * \param qth QTH coordinates
- * \param daynum Time for calculation
+ * \param context Ephemeris context for the QTH at the time of calculation
  **/
-void print_moon_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum);
+void print_moon_box(int row, int col, const struct ephemeris_context *context);
 
 /**
  * Print QTH coordinates in infobox on standard screen. Uses 9 columns and 3 rows.
@@ -66,6 +66,16 @@ void bailout(const char *string);
  **/
 void update_tle_database(const char *string, struct tle_db *tle_db);
 
+/**
+ * Update TLE database using several TLE files or directories at once. The files are combined into one update set
+ * where the most recent TLE of each satellite is used, so that each TLE database file is rewritten at most
+ * once. Prints updated entries and a summary for each TLE database file to stdout.
+ *
+ * \param filenames TLE files or directories to use for updating the TLE database
+ * \param tle_db Pre-loaded TLE database
+ **/
+void update_tle_database_from_files(string_array_t *filenames, struct tle_db *tle_db);
+
 /**
  * Run flyby UI.
  *
@@ -77,8 +87,11 @@ void update_tle_database(const char *string, struct tle_db *tle_db);
  * \param rotctld Rotctld info
  * \param downlink Downlink info
  * \param uplink Uplink info
+ * \param num_threads Number of worker threads used for updating the satellite listing and for the solar illumination predictions, 0 for the number of online CPUs
+ * \param pass_resolution Resolution of the rows in the pass schedules
+ * \param sun_elevation_limit Sun elevation below which satellites in sunlight are visible in the pass schedules, in degrees
  **/
-void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t *observer, struct tle_db *tle_db, struct transponder_db *sat_db, rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink);
+void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t *observer, struct tle_db *tle_db, struct transponder_db *sat_db, rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink, int num_threads, const struct pass_sampler_resolution *pass_resolution, double sun_elevation_limit);
 
 /**
  * Print a main menu option, htop style.
@@ -0,0 +1,144 @@
+#include "update_schedule.h"
+#include <stdlib.h>
+#include <math.h>
+#include <stdbool.h>
+
+/**
+ * Swap two heap positions, keeping the item positions up to date.
+ *
+ * \param schedule Update schedule
+ * \param position_1 First heap position
+ * \param position_2 Second heap position
+ **/
+void update_schedule_swap(struct update_schedule *schedule, int position_1, int position_2)
+{
+	int item_1 = schedule->heap[position_1];
+	int item_2 = schedule->heap[position_2];
+	schedule->heap[position_1] = item_2;
+	schedule->heap[position_2] = item_1;
+	schedule->heap_positions[item_1] = position_2;
+	schedule->heap_positions[item_2] = position_1;
+}
+
+/**
+ * Get update time of the item at a heap position.
+ *
+ * \param schedule Update schedule
+ * \param position Heap position
+ * \return Update time
+ **/
+static inline double update_schedule_time_at(const struct update_schedule *schedule, int position)
+{
+	return schedule->update_times[schedule->heap[position]];
+}
+
+/**
+ * Move item up or down in the heap until the heap property is restored.
+ *
+ * \param schedule Update schedule
+ * \param position Heap position of the item
+ **/
+void update_schedule_sift(struct update_schedule *schedule, int position)
+{
+	//move up while earlier than parent
+	while ((position > 0) && (update_schedule_time_at(schedule, position) < update_schedule_time_at(schedule, (position - 1)/2))) {
+		update_schedule_swap(schedule, position, (position - 1)/2);
+		position = (position - 1)/2;
+	}
+
+	//move down while later than any of the children
+	while (true) {
+		int earliest = position;
+		int children[2] = {2*position + 1, 2*position + 2};
+		for (int i=0; i < 2; i++) {
+			if ((children[i] < schedule->num_items) && (update_schedule_time_at(schedule, children[i]) < update_schedule_time_at(schedule, earliest))) {
+				earliest = children[i];
+			}
+		}
+		if (earliest == position) {
+			break;
+		}
+		update_schedule_swap(schedule, position, earliest);
+		position = earliest;
+	}
+}
+
+struct update_schedule *update_schedule_create(int num_items)
+{
+	struct update_schedule *schedule = (struct update_schedule*)malloc(sizeof(struct update_schedule));
+	schedule->num_items = num_items;
+	schedule->heap = (int*)malloc(sizeof(int)*(num_items + 1));
+	schedule->heap_positions = (int*)malloc(sizeof(int)*(num_items + 1));
+	schedule->update_times = (double*)malloc(sizeof(double)*(num_items + 1));
+	update_schedule_reset(schedule);
+	return schedule;
+}
+
+void update_schedule_set(struct update_schedule *schedule, int item, double time)
+{
+	schedule->update_times[item] = time;
+	update_schedule_sift(schedule, schedule->heap_positions[item]);
+}
+
+void update_schedule_reset(struct update_schedule *schedule)
+{
+	//all times equal, so any order is a valid heap
+	for (int i=0; i < schedule->num_items; i++) {
+		schedule->heap[i] = i;
+		schedule->heap_positions[i] = i;
+		schedule->update_times[i] = -INFINITY;
+	}
+}
+
+/**
+ * Compare two item indices, used for sorting the due items using qsort.
+ **/
+int update_schedule_compare_items(const void *a, const void *b)
+{
+	return *((const int*)a) - *((const int*)b);
+}
+
+int update_schedule_due_items(const struct update_schedule *schedule, double time, int *items)
+{
+	//breadth-first search through the heap, skipping subtrees with a root that is not due.
+	//The heap positions of the due items are collected in `items` and used as the search queue.
+	int num_due = 0;
+	if ((schedule->num_items > 0) && (update_schedule_time_at(schedule, 0) <= time)) {
+		items[num_due++] = 0;
+	}
+	for (int i=0; i < num_due; i++) {
+		int children[2] = {2*items[i] + 1, 2*items[i] + 2};
+		for (int j=0; j < 2; j++) {
+			if ((children[j] < schedule->num_items) && (update_schedule_time_at(schedule, children[j]) <= time)) {
+				items[num_due++] = children[j];
+			}
+		}
+	}
+
+	//convert heap positions to item indices
+	for (int i=0; i < num_due; i++) {
+		items[i] = schedule->heap[items[i]];
+	}
+	qsort(items, num_due, sizeof(int), update_schedule_compare_items);
+	return num_due;
+}
+
+double update_schedule_next_time(const struct update_schedule *schedule)
+{
+	if (schedule->num_items == 0) {
+		return INFINITY;
+	}
+	return update_schedule_time_at(schedule, 0);
+}
+
+void update_schedule_destroy(struct update_schedule **schedule)
+{
+	if (*schedule == NULL) {
+		return;
+	}
+	free((*schedule)->heap);
+	free((*schedule)->heap_positions);
+	free((*schedule)->update_times);
+	free(*schedule);
+	*schedule = NULL;
+}
@@ -0,0 +1,75 @@
+#ifndef UPDATE_SCHEDULE_H_DEFINED
+#define UPDATE_SCHEDULE_H_DEFINED
+
+/**
+ * Priority queue of items keyed by the time at which each item next has to be updated, used for updating only the
+ * items that are due instead of all items on every tick. Implemented as a binary min-heap with the heap position
+ * of each item tracked, so that update times can be changed in O(log n).
+ **/
+
+/**
+ * Update schedule.
+ **/
+struct update_schedule {
+	///Number of items
+	int num_items;
+	///Item indices, ordered as a min-heap on the update times
+	int *heap;
+	///Position of each item in `heap`
+	int *heap_positions;
+	///Next update time of each item
+	double *update_times;
+};
+
+/**
+ * Create update schedule. All items are initially due for update.
+ *
+ * \param num_items Number of items, indexed from 0 to num_items-1
+ * \return Update schedule
+ **/
+struct update_schedule *update_schedule_create(int num_items);
+
+/**
+ * Set the next update time of an item.
+ *
+ * \param schedule Update schedule
+ * \param item Item index
+ * \param time Next update time, INFINITY for never updating the item again
+ **/
+void update_schedule_set(struct update_schedule *schedule, int item, double time);
+
+/**
+ * Make all items due for update.
+ *
+ * \param schedule Update schedule
+ **/
+void update_schedule_reset(struct update_schedule *schedule);
+
+/**
+ * Get the items that are due for update at the given time, i.e. items with an update time earlier than or equal to
+ * the given time. The items stay in the schedule, and should be rescheduled using update_schedule_set() after they
+ * have been updated.
+ *
+ * \param schedule Update schedule
+ * \param time Time
+ * \param items Returned item indices, in increasing order. Has to have space for all items in the schedule
+ * \return Number of due items
+ **/
+int update_schedule_due_items(const struct update_schedule *schedule, double time, int *items);
+
+/**
+ * Get the earliest update time of any item.
+ *
+ * \param schedule Update schedule
+ * \return Earliest update time, INFINITY if there are no items
+ **/
+double update_schedule_next_time(const struct update_schedule *schedule);
+
+/**
+ * Free update schedule.
+ *
+ * \param schedule Update schedule
+ **/
+void update_schedule_destroy(struct update_schedule **schedule);
+
+#endif
@@ -19,6 +19,9 @@
 //default relative multitrack settings filename
 #define MULTITRACK_SETTINGS_FILE FLYBY_RELATIVE_ROOT_PATH "multitrack_settings.conf"
 
+//default relative filename of TLE and transponder database snapshot, relative to XDG_CACHE_HOME
+#define CATALOG_SNAPSHOT_RELATIVE_FILE_PATH FLYBY_RELATIVE_ROOT_PATH "catalog.snapshot"
+
 //default relative astronomical body tracking settings filename
 #define TRACK_ASTRONOMICAL_BODY_SETTINGS_FILE FLYBY_RELATIVE_ROOT_PATH "astronomical_body_tracking_settings.conf"
 
@@ -42,6 +45,21 @@ char *xdg_config_dirs();
  **/
 char *xdg_config_home();
 
+/**
+ * \return XDG_CACHE_HOME variable, or the xdg basedir specification default if XDG_CACHE_HOME is empty
+ **/
+char *xdg_cache_home();
+
+/**
+ * Creates all missing directories that are a part of the input path.  Exits
+ * the application ungracefully if it is not possible to create the given
+ * directories or if the full deconstructed path back to the root directory
+ * somehow should not exist.
+ *
+ * \param full_path Input path to decompose and create
+ **/
+void create_path_if_missing(const char *full_path);
+
 /**
  * Create XDG_CONFIG_HOME/flyby (normally .config/flyby) and XDG_DATA_HOME/flyby/tles/ (normally .local/share/flyby/tles) if these do not exist.
  **/
@@ -0,0 +1,222 @@
+#include "catalog_snapshot.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_DATA_DIR "test_data/"
+#define TEST_TLE_DIR TEST_DATA_DIR "mixture/flyby/tles/"
+#define TEST_TRANSPONDER_DB TEST_DATA_DIR "flyby/flyby.db"
+
+/**
+ * Read test TLE and transponder databases, and collect corresponding list over source files.
+ **/
+void read_test_databases(struct tle_db *tle_db, struct transponder_db **transponder_db, struct catalog_sources *sources)
+{
+	catalog_sources_add_directory(sources, TEST_TLE_DIR);
+	catalog_sources_add_file(sources, TEST_TRANSPONDER_DB);
+
+	tle_db_from_directory(TEST_TLE_DIR, tle_db);
+	assert_true(tle_db->num_tles > 0);
+	*transponder_db = transponder_db_create(tle_db);
+	assert_int_equal(transponder_db_from_file(TEST_TRANSPONDER_DB, tle_db, *transponder_db, LOCATION_DATA_HOME), TRANSPONDER_SUCCESS);
+	assert_true((*transponder_db)->loaded);
+}
+
+void test_catalog_snapshot_to_file(void **param)
+{
+	char filename[L_tmpnam] = "/tmp/XXXXXX";
+	int fid = mkstemp(filename);
+	assert_true(fid != -1);
+	close(fid);
+
+	struct tle_db *tle_db = tle_db_create();
+	struct transponder_db *transponder_db = NULL;
+	struct catalog_sources sources = {0};
+	read_test_databases(tle_db, &transponder_db, &sources);
+	assert_int_equal(catalog_snapshot_to_file(filename, &sources, tle_db, transponder_db), 0);
+
+	//read back snapshot, should be equal to the original databases
+	struct tle_db *snapshot_tle_db = tle_db_create();
+	struct transponder_db *snapshot_transponder_db = NULL;
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_SUCCESS);
+
+	assert_int_equal(snapshot_tle_db->num_tles, tle_db->num_tles);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		assert_int_equal(snapshot_tle_db->tles[i].satellite_number, tle_db->tles[i].satellite_number);
+		assert_string_equal(snapshot_tle_db->tles[i].name, tle_db->tles[i].name);
+		assert_string_equal(snapshot_tle_db->tles[i].line1, tle_db->tles[i].line1);
+		assert_string_equal(snapshot_tle_db->tles[i].line2, tle_db->tles[i].line2);
+		assert_string_equal(tle_db_entry_filename(snapshot_tle_db, i), tle_db_entry_filename(tle_db, i));
+		assert_false(tle_db_entry_enabled(snapshot_tle_db, i));
+		assert_int_equal(tle_db_find_entry(snapshot_tle_db, tle_db->tles[i].satellite_number), tle_db_find_entry(tle_db, tle_db->tles[i].satellite_number));
+	}
+
+	assert_int_equal(snapshot_transponder_db->num_sats, transponder_db->num_sats);
+	assert_int_equal(snapshot_transponder_db->loaded, transponder_db->loaded);
+	for (int i=0; i < transponder_db->num_sats; i++) {
+		assert_true(transponder_db_entry_equal(&(snapshot_transponder_db->sats[i]), &(transponder_db->sats[i])));
+		assert_int_equal(snapshot_transponder_db->sats[i].location, transponder_db->sats[i].location);
+	}
+
+	tle_db_destroy(&snapshot_tle_db);
+	transponder_db_destroy(&snapshot_transponder_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+	catalog_sources_free(&sources);
+	unlink(filename);
+}
+
+void test_catalog_snapshot_outdated(void **param)
+{
+	char filename[L_tmpnam] = "/tmp/XXXXXX";
+	int fid = mkstemp(filename);
+	assert_true(fid != -1);
+	close(fid);
+
+	struct tle_db *tle_db = tle_db_create();
+	struct transponder_db *transponder_db = NULL;
+	struct catalog_sources sources = {0};
+	read_test_databases(tle_db, &transponder_db, &sources);
+	assert_int_equal(catalog_snapshot_to_file(filename, &sources, tle_db, transponder_db), 0);
+
+	struct tle_db *snapshot_tle_db = tle_db_create();
+	struct transponder_db *snapshot_transponder_db = NULL;
+
+	//changed file size
+	sources.status[1].size++;
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_OUTDATED);
+	sources.status[1].size--;
+
+	//changed modification time
+	sources.status[1].mtime_nsec++;
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_OUTDATED);
+	sources.status[1].mtime_nsec--;
+
+	//additional source file
+	catalog_sources_add_file(&sources, "/dev/NULL");
+	assert_int_equal(sources.status[string_array_size(&(sources.paths))-1].size, -1);
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_OUTDATED);
+
+	assert_int_equal(snapshot_tle_db->num_tles, 0);
+	assert_null(snapshot_transponder_db);
+
+	tle_db_destroy(&snapshot_tle_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+	catalog_sources_free(&sources);
+	unlink(filename);
+}
+
+void test_catalog_snapshot_invalid(void **param)
+{
+	char filename[L_tmpnam] = "/tmp/XXXXXX";
+	int fid = mkstemp(filename);
+	assert_true(fid != -1);
+	close(fid);
+
+	struct tle_db *tle_db = tle_db_create();
+	struct transponder_db *transponder_db = NULL;
+	struct catalog_sources sources = {0};
+	read_test_databases(tle_db, &transponder_db, &sources);
+
+	struct tle_db *snapshot_tle_db = tle_db_create();
+	struct transponder_db *snapshot_transponder_db = NULL;
+
+	//non-existing and empty files
+	assert_int_equal(catalog_snapshot_from_file("/dev/NULL", &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_FILE_READING_ERROR);
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_FILE_READING_ERROR);
+
+	//non-snapshot file
+	assert_int_equal(catalog_snapshot_from_file(TEST_TRANSPONDER_DB, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_INVALID);
+
+	//truncated snapshot
+	assert_int_equal(catalog_snapshot_to_file(filename, &sources, tle_db, transponder_db), 0);
+	FILE *fd = fopen(filename, "r+");
+	fseek(fd, 0, SEEK_END);
+	assert_int_equal(ftruncate(fileno(fd), ftell(fd) - 1), 0);
+	fclose(fd);
+	assert_int_equal(catalog_snapshot_from_file(filename, &sources, snapshot_tle_db, &snapshot_transponder_db), CATALOG_SNAPSHOT_INVALID);
+
+	assert_int_equal(snapshot_tle_db->num_tles, 0);
+	assert_null(snapshot_transponder_db);
+
+	tle_db_destroy(&snapshot_tle_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+	catalog_sources_free(&sources);
+	unlink(filename);
+}
+
+void test_catalog_sources_from_search_paths(void **param)
+{
+	struct catalog_sources sources = {0};
+	will_return(xdg_data_home, TEST_DATA_DIR "mixture/");
+	will_return(xdg_data_dirs, TEST_DATA_DIR);
+	catalog_sources_from_search_paths(&sources);
+
+	//TLE directory in XDG_DATA_HOME and its three TLE files
+	int num_sources = string_array_size(&(sources.paths));
+	assert_int_equal(num_sources, 7);
+	assert_string_equal(string_array_get(&(sources.paths), 0), TEST_DATA_DIR "mixture/flyby/tles/");
+	for (int i=0; i < 4; i++) {
+		assert_true(sources.status[i].size >= 0);
+	}
+
+	//non-existing TLE directory in XDG_DATA_DIRS
+	assert_string_equal(string_array_get(&(sources.paths), 4), TEST_DATA_DIR "flyby/tles/");
+	assert_int_equal(sources.status[4].size, -1);
+
+	//transponder database in XDG_DATA_DIRS and non-existing transponder database in XDG_DATA_HOME
+	assert_string_equal(string_array_get(&(sources.paths), 5), TEST_TRANSPONDER_DB);
+	assert_true(sources.status[5].size > 0);
+	assert_string_equal(string_array_get(&(sources.paths), 6), TEST_DATA_DIR "mixture/flyby/flyby.db");
+	assert_int_equal(sources.status[6].size, -1);
+
+	catalog_sources_free(&sources);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_cache_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_path_if_missing(const char *full_path)
+{
+}
+
+void create_xdg_dirs()
+{
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_catalog_snapshot_to_file),
+	cmocka_unit_test(test_catalog_snapshot_outdated),
+	cmocka_unit_test(test_catalog_snapshot_invalid),
+	cmocka_unit_test(test_catalog_sources_from_search_paths)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
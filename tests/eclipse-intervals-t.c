@@ -0,0 +1,177 @@
+#include "eclipse_intervals.h"
+#include "test_tles.h"
+#include "defines.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//number of days checked for each satellite
+#define NUM_TEST_DAYS 3
+
+//one second, in days
+#define ONE_SECOND (1.0/86400.0)
+
+//satellite in the test file that decays within a day of its epoch
+#define DECAYING_SATELLITE_NUMBER 40948
+
+/**
+ * Get the start of the day of the TLE epoch.
+ **/
+predict_julian_date_t epoch_day_start(const predict_orbital_elements_t *elements)
+{
+	return floor(test_tles_epoch(elements));
+}
+
+/**
+ * Count the sunlit minutes of a day by propagating the orbit at each minute.
+ **/
+int sampled_sunlit_minutes(const predict_orbital_elements_t *elements, predict_julian_date_t day_start)
+{
+	int sunlit_minutes = 0;
+	for (int i=0; i < ECLIPSE_MINUTES_PER_DAY; i++) {
+		struct predict_position orbit;
+		predict_orbit(elements, &orbit, day_start + i/((double)ECLIPSE_MINUTES_PER_DAY));
+		if (!orbit.eclipsed) {
+			sunlit_minutes++;
+		}
+	}
+	return sunlit_minutes;
+}
+
+void test_eclipse_intervals_find(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+	assert_true(num_elements > 0);
+
+	struct eclipse_intervals intervals = {0};
+	for (int i=0; i < num_elements; i++) {
+		predict_julian_date_t start_day = epoch_day_start(elements[i]);
+		for (int day=0; day < NUM_TEST_DAYS; day++) {
+			predict_julian_date_t day_start = start_day + day;
+			eclipse_intervals_find(elements[i], day_start, day_start + 1.0, &intervals);
+			if (intervals.decayed) {
+				continue;
+			}
+
+			//the satellite should be eclipsed within the intervals, and sunlit just outside them
+			for (int j=0; j < intervals.num_intervals; j++) {
+				const struct eclipse_interval *interval = &(intervals.intervals[j]);
+				assert_true(interval->entry_time < interval->exit_time);
+				assert_true((interval->entry_time >= day_start) && (interval->exit_time <= day_start + 1.0));
+				if (j > 0) {
+					assert_true(intervals.intervals[j-1].exit_time < interval->entry_time);
+				}
+
+				struct predict_position orbit;
+				predict_orbit(elements[i], &orbit, (interval->entry_time + interval->exit_time)/2.0);
+				assert_true(orbit.eclipsed);
+				if (interval->entry_time > day_start) {
+					predict_orbit(elements[i], &orbit, interval->entry_time - ONE_SECOND);
+					assert_false(orbit.eclipsed);
+				}
+				if (interval->exit_time < day_start + 1.0) {
+					predict_orbit(elements[i], &orbit, interval->exit_time + ONE_SECOND);
+					assert_false(orbit.eclipsed);
+				}
+			}
+
+			//minute count should match sampling at each minute, up to a minute starting within the tolerance of an umbra entry or exit
+			int sunlit_minutes = eclipse_intervals_sunlit_minutes(&intervals, day_start);
+			int expected_sunlit_minutes = sampled_sunlit_minutes(elements[i], day_start);
+			assert_true(abs(sunlit_minutes - expected_sunlit_minutes) <= 1);
+		}
+	}
+	eclipse_intervals_free(&intervals);
+
+	test_tles_free(num_elements, elements);
+}
+
+void test_eclipse_sunlit_minutes(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+	assert_true(num_elements > 0);
+
+	//days calculated in parallel should be equal to days calculated one at a time
+	const int num_days = 11;
+	predict_julian_date_t start_day = epoch_day_start(elements[0]);
+	int sunlit_minutes[num_days], serial_sunlit_minutes[num_days];
+	bool decayed[num_days], serial_decayed[num_days];
+	struct thread_pool *pool = thread_pool_create(4);
+	assert_non_null(pool);
+	eclipse_sunlit_minutes(pool, elements[0], start_day, num_days, sunlit_minutes, decayed);
+	eclipse_sunlit_minutes(NULL, elements[0], start_day, num_days, serial_sunlit_minutes, serial_decayed);
+	for (int i=0; i < num_days; i++) {
+		assert_int_equal(sunlit_minutes[i], serial_sunlit_minutes[i]);
+		assert_true(decayed[i] == serial_decayed[i]);
+		assert_true((sunlit_minutes[i] >= 0) && (sunlit_minutes[i] <= ECLIPSE_MINUTES_PER_DAY));
+	}
+	thread_pool_destroy(&pool);
+
+	test_tles_free(num_elements, elements);
+}
+
+void test_eclipse_sunlit_minutes_decayed(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+	const predict_orbital_elements_t *decaying_elements = NULL;
+	for (int i=0; i < num_elements; i++) {
+		if (elements[i]->satellite_number == DECAYING_SATELLITE_NUMBER) {
+			decaying_elements = elements[i];
+		}
+	}
+	assert_non_null(decaying_elements);
+
+	//the day before the epoch is not decayed, and the orbit decays within the next two days
+	const int num_days = 4;
+	predict_julian_date_t start_day = epoch_day_start(decaying_elements) - 1.0;
+	int sunlit_minutes[num_days];
+	bool decayed[num_days];
+	eclipse_sunlit_minutes(NULL, decaying_elements, start_day, num_days, sunlit_minutes, decayed);
+	assert_false(decayed[0]);
+	assert_true(decayed[2]);
+	assert_true(decayed[3]);
+	assert_int_equal(sunlit_minutes[0], sampled_sunlit_minutes(decaying_elements, start_day));
+
+	//only the minutes before the decay should be counted as sunlit
+	for (int i=1; i < num_days; i++) {
+		assert_true(!decayed[i-1] || decayed[i]);
+		if (!decayed[i]) {
+			continue;
+		}
+		predict_julian_date_t day_start = start_day + i;
+		int minutes_before_decay = 0;
+		for (int minute=0; minute < ECLIPSE_MINUTES_PER_DAY; minute++) {
+			struct predict_position orbit;
+			predict_orbit(decaying_elements, &orbit, day_start + minute/((double)ECLIPSE_MINUTES_PER_DAY));
+			if (orbit.decayed) {
+				break;
+			}
+			minutes_before_decay++;
+		}
+		assert_true(sunlit_minutes[i] <= minutes_before_decay);
+		if (minutes_before_decay == 0) {
+			assert_int_equal(sunlit_minutes[i], 0);
+		}
+	}
+
+	test_tles_free(num_elements, elements);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_eclipse_intervals_find),
+	cmocka_unit_test(test_eclipse_sunlit_minutes),
+	cmocka_unit_test(test_eclipse_sunlit_minutes_decayed)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,108 @@
+#include "ephemeris_context.h"
+#include "test_tles.h"
+#include "defines.h"
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//test times in day numbers, around the epochs of the TLEs in newer_tles/amateur.txt (March 2016)
+#define NUM_TEST_TIMES 6
+const predict_julian_date_t test_times[NUM_TEST_TIMES] = {13229.9, 13232.65, 13232.9, 13233.31, 13234.9, 13240.4};
+
+/**
+ * Check that two observations are equal to within floating point differences.
+ **/
+void assert_observation_equal(const struct predict_observation *obs, const struct predict_observation *expected_obs)
+{
+	assert_true(obs->time == expected_obs->time);
+	assert_float_equal(obs->azimuth, expected_obs->azimuth, 1.0E-9);
+	assert_float_equal(obs->elevation, expected_obs->elevation, 1.0E-9);
+	assert_float_equal(obs->azimuth_rate, expected_obs->azimuth_rate, 1.0E-9);
+	assert_float_equal(obs->elevation_rate, expected_obs->elevation_rate, 1.0E-9);
+	assert_float_equal(obs->range, expected_obs->range, 1.0E-6);
+	assert_float_equal(obs->range_rate, expected_obs->range_rate, 1.0E-6);
+	assert_float_equal(obs->range_x, expected_obs->range_x, 1.0E-6);
+	assert_float_equal(obs->range_y, expected_obs->range_y, 1.0E-6);
+	assert_float_equal(obs->range_z, expected_obs->range_z, 1.0E-6);
+	assert_true(obs->visible == expected_obs->visible);
+}
+
+void test_ephemeris_context_sun_moon(void **param)
+{
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 50);
+
+	for (int i=0; i < NUM_TEST_TIMES; i++) {
+		predict_julian_date_t time = test_times[i];
+		struct ephemeris_context context;
+		ephemeris_context_update(&context, observer, time);
+		ephemeris_context_update_moon(&context);
+		assert_true(context.time == time);
+		assert_true(context.observer == observer);
+
+		struct predict_observation expected_sun, expected_moon;
+		predict_observe_sun(observer, time, &expected_sun);
+		predict_observe_moon(observer, time, &expected_moon);
+		assert_observation_equal(&(context.sun), &expected_sun);
+		assert_observation_equal(&(context.moon), &expected_moon);
+	}
+
+	predict_destroy_observer(observer);
+}
+
+void test_ephemeris_context_observe_orbits(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+
+	//observers on both hemispheres, to get both visible and invisible satellites
+	predict_observer_t *observers[] = {predict_create_observer("north", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 50),
+		predict_create_observer("south", -33.87*M_PI/180.0, 151.21*M_PI/180.0, 0)};
+	int num_observers = sizeof(observers)/sizeof(observers[0]);
+
+	for (int i=0; i < num_observers; i++) {
+		for (int j=0; j < NUM_TEST_TIMES; j++) {
+			predict_julian_date_t time = test_times[j];
+			struct ephemeris_context context;
+			ephemeris_context_update(&context, observers[i], time);
+
+			struct predict_position orbits[MAX_NUM_TEST_TLES];
+			for (int k=0; k < num_elements; k++) {
+				predict_orbit(elements[k], &orbits[k], time);
+			}
+			struct predict_observation observations[MAX_NUM_TEST_TLES];
+			ephemeris_context_observe_orbits(&context, num_elements, orbits, observations);
+
+			for (int k=0; k < num_elements; k++) {
+				struct predict_observation expected_obs;
+				predict_observe_orbit(observers[i], &orbits[k], &expected_obs);
+				assert_observation_equal(&observations[k], &expected_obs);
+
+				//eclipse check should agree with predict_orbit()
+				double eclipse_depth;
+				bool eclipsed = ephemeris_context_eclipsed(&context, orbits[k].position, &eclipse_depth);
+				assert_true(eclipsed == orbits[k].eclipsed);
+				assert_float_equal(eclipse_depth, orbits[k].eclipse_depth, 1.0E-9);
+			}
+		}
+	}
+
+	for (int i=0; i < num_observers; i++) {
+		predict_destroy_observer(observers[i]);
+	}
+	test_tles_free(num_elements, elements);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_ephemeris_context_sun_moon),
+	cmocka_unit_test(test_ephemeris_context_observe_orbits)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
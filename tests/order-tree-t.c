@@ -0,0 +1,126 @@
+#include "order_tree.h"
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define NUM_ITEMS 613
+
+/**
+ * Reference group and key of the items, used for sorting the expected order using qsort.
+ **/
+int reference_groups[NUM_ITEMS];
+double reference_keys[NUM_ITEMS];
+
+int compare_reference(const void *a, const void *b)
+{
+	int item_1 = *((const int*)a);
+	int item_2 = *((const int*)b);
+	if (reference_groups[item_1] != reference_groups[item_2]) {
+		return (reference_groups[item_1] < reference_groups[item_2]) ? -1 : 1;
+	}
+	if (reference_keys[item_1] != reference_keys[item_2]) {
+		return (reference_keys[item_1] < reference_keys[item_2]) ? -1 : 1;
+	}
+	return item_1 - item_2;
+}
+
+/**
+ * Check that the tree contains the given items in the order given by the reference groups and keys.
+ **/
+void assert_order(const struct order_tree *tree, const bool *in_tree)
+{
+	int expected_order[NUM_ITEMS];
+	int num_expected = 0;
+	for (int i=0; i < NUM_ITEMS; i++) {
+		if (in_tree[i]) {
+			expected_order[num_expected++] = i;
+		}
+	}
+	qsort(expected_order, num_expected, sizeof(int), compare_reference);
+
+	assert_int_equal(order_tree_size(tree), num_expected);
+	for (int i=0; i < num_expected; i++) {
+		assert_int_equal(order_tree_item_at(tree, i), expected_order[i]);
+		assert_int_equal(order_tree_position(tree, expected_order[i]), i);
+	}
+	assert_int_equal(order_tree_item_at(tree, num_expected), -1);
+	for (int i=0; i < NUM_ITEMS; i++) {
+		if (!in_tree[i]) {
+			assert_int_equal(order_tree_position(tree, i), -1);
+		}
+	}
+}
+
+void test_order_tree_set(void **param)
+{
+	struct order_tree *tree = order_tree_create(NUM_ITEMS);
+	bool in_tree[NUM_ITEMS] = {0};
+	assert_int_equal(order_tree_size(tree), 0);
+	assert_int_equal(order_tree_item_at(tree, 0), -1);
+
+	//insert all items, with duplicate keys
+	srand(1);
+	for (int i=0; i < NUM_ITEMS; i++) {
+		reference_groups[i] = rand() % 5;
+		reference_keys[i] = rand() % 50;
+		assert_true(order_tree_set(tree, i, reference_groups[i], reference_keys[i]));
+		in_tree[i] = true;
+	}
+	assert_order(tree, in_tree);
+
+	//setting the same key should not move the item
+	assert_false(order_tree_set(tree, 0, reference_groups[0], reference_keys[0]));
+
+	//move a few items at a time
+	for (int round=0; round < 20; round++) {
+		for (int i=0; i < 10; i++) {
+			int item = rand() % NUM_ITEMS;
+			reference_groups[item] = rand() % 5;
+			reference_keys[item] = (rand() % 5000)/100.0;
+			order_tree_set(tree, item, reference_groups[item], reference_keys[item]);
+		}
+		assert_order(tree, in_tree);
+	}
+
+	//remove and reinsert items
+	for (int i=0; i < NUM_ITEMS; i += 3) {
+		order_tree_remove(tree, i);
+		in_tree[i] = false;
+	}
+	order_tree_remove(tree, 0);
+	assert_order(tree, in_tree);
+	for (int i=0; i < NUM_ITEMS; i += 6) {
+		order_tree_set(tree, i, reference_groups[i], reference_keys[i]);
+		in_tree[i] = true;
+	}
+	assert_order(tree, in_tree);
+
+	order_tree_destroy(&tree);
+	assert_null(tree);
+}
+
+void test_order_tree_precision(void **param)
+{
+	//keys closer than one should not be treated as equal
+	struct order_tree *tree = order_tree_create(3);
+	order_tree_set(tree, 0, 0, 13232.9001);
+	order_tree_set(tree, 1, 0, 13232.9);
+	order_tree_set(tree, 2, 0, 13232.90005);
+	assert_int_equal(order_tree_item_at(tree, 0), 1);
+	assert_int_equal(order_tree_item_at(tree, 1), 2);
+	assert_int_equal(order_tree_item_at(tree, 2), 0);
+	order_tree_destroy(&tree);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_order_tree_set),
+	cmocka_unit_test(test_order_tree_precision)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,198 @@
+#include "pass_cache.h"
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_TLE_FILE "test_data/newer_tles/amateur.txt"
+
+//number of satellites enabled in the tests
+#define NUM_TEST_SATELLITES 4
+
+//test QTH, in radians and meters
+#define TEST_QTH_LATITUDE (63.42*M_PI/180.0)
+#define TEST_QTH_LONGITUDE (10.39*M_PI/180.0)
+#define TEST_QTH_ALTITUDE 50
+
+//maximum time to wait for the background thread to fill the cache, in seconds
+#define MAX_FILL_TIME 120
+
+//tolerance for pass times predicted from different start times, in days
+#define PASS_TIME_TOLERANCE (1.0/86400.0)
+
+/**
+ * Create TLE database with only the first NUM_TEST_SATELLITES satellites enabled.
+ **/
+struct tle_db *create_test_tle_db()
+{
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(TEST_TLE_FILE, tle_db);
+	assert_true(tle_db->num_tles > NUM_TEST_SATELLITES);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_entry_set_enabled(tle_db, i, i < NUM_TEST_SATELLITES);
+	}
+	return tle_db;
+}
+
+/**
+ * Check whether passes can be predicted for the given satellite at the given time.
+ **/
+bool has_passes(struct tle_db *tle_db, int tle_index, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, tle_index);
+	struct predict_position orbit;
+	predict_orbit(orbital_elements, &orbit, time);
+	return !orbit.decayed && predict_aos_happens(orbital_elements, observer->latitude) && !predict_is_geosynchronous(orbital_elements);
+}
+
+/**
+ * Wait until all enabled satellites with passes have a full cache.
+ **/
+void wait_for_full_cache(struct pass_cache *cache, struct tle_db *tle_db, const predict_observer_t *observer)
+{
+	predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+	time_t start = time(NULL);
+	for (int i=0; i < NUM_TEST_SATELLITES; i++) {
+		if (!has_passes(tle_db, i, observer, curr_time)) {
+			continue;
+		}
+		while (pass_cache_num_passes(cache, i) < PASS_CACHE_NUM_PASSES) {
+			assert_true(time(NULL) - start < MAX_FILL_TIME);
+			usleep(10000);
+		}
+	}
+}
+
+/**
+ * Check that two passes are equal within the tolerance.
+ **/
+void assert_pass_equal(const struct pass_cache_pass *pass, const struct pass_cache_pass *expected_pass)
+{
+	assert_float_equal(pass->aos_time, expected_pass->aos_time, PASS_TIME_TOLERANCE);
+	assert_float_equal(pass->los_time, expected_pass->los_time, PASS_TIME_TOLERANCE);
+	assert_float_equal(pass->tca_time, expected_pass->tca_time, 10*PASS_TIME_TOLERANCE);
+	assert_float_equal(pass->max_elevation, expected_pass->max_elevation, 1.0E-2);
+}
+
+void test_pass_cache_passes(void **param)
+{
+	struct tle_db *tle_db = create_test_tle_db();
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct pass_cache *cache = pass_cache_create(observer, tle_db);
+	wait_for_full_cache(cache, tle_db, observer);
+
+	predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+	for (int i=0; i < NUM_TEST_SATELLITES; i++) {
+		if (!has_passes(tle_db, i, observer, curr_time)) {
+			continue;
+		}
+		predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, i);
+
+		//cached passes should be equal to the passes predicted without cache
+		predict_julian_date_t time = curr_time;
+		for (int j=0; j < PASS_CACHE_NUM_PASSES; j++) {
+			struct pass_cache_pass pass, expected_pass;
+			pass_cache_current_pass(cache, i, observer, orbital_elements, time, &pass);
+			pass_cache_current_pass(NULL, -1, observer, orbital_elements, time, &expected_pass);
+			assert_pass_equal(&pass, &expected_pass);
+			assert_true(pass.los_time > time);
+			assert_true(pass_cache_try_current_pass(cache, i, observer, orbital_elements, time, &pass));
+			assert_pass_equal(&pass, &expected_pass);
+
+			//next pass should start after the given time, also within a pass
+			predict_julian_date_t within_pass = (pass.aos_time + pass.los_time)/2.0;
+			struct pass_cache_pass next_pass;
+			pass_cache_next_pass(cache, i, observer, orbital_elements, within_pass, &next_pass);
+			pass_cache_next_pass(NULL, -1, observer, orbital_elements, within_pass, &expected_pass);
+			assert_pass_equal(&next_pass, &expected_pass);
+			assert_true(next_pass.aos_time > pass.los_time);
+
+			time = pass.los_time + 1.0/1440.0;
+		}
+	}
+
+	pass_cache_destroy(&cache);
+	assert_null(cache);
+	predict_destroy_observer(observer);
+	tle_db_destroy(&tle_db);
+}
+
+void test_pass_cache_invalidation(void **param)
+{
+	struct tle_db *tle_db = create_test_tle_db();
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct pass_cache *cache = pass_cache_create(observer, tle_db);
+	wait_for_full_cache(cache, tle_db, observer);
+
+	//passes should be predicted for the new QTH after it has been changed
+	predict_observer_t *new_observer = predict_create_observer("test", -TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE + 1.0, 0);
+	pass_cache_set_observer(cache, new_observer);
+	wait_for_full_cache(cache, tle_db, new_observer);
+	predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+	for (int i=0; i < NUM_TEST_SATELLITES; i++) {
+		if (!has_passes(tle_db, i, new_observer, curr_time)) {
+			continue;
+		}
+		predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, i);
+		struct pass_cache_pass pass, expected_pass;
+		pass_cache_current_pass(cache, i, new_observer, orbital_elements, curr_time, &pass);
+		pass_cache_current_pass(NULL, -1, new_observer, orbital_elements, curr_time, &expected_pass);
+		assert_pass_equal(&pass, &expected_pass);
+	}
+
+	//disabled satellites should be removed from the cache, and enabled satellites added
+	tle_db_entry_set_enabled(tle_db, 0, false);
+	tle_db_entry_set_enabled(tle_db, NUM_TEST_SATELLITES, true);
+	pass_cache_update_satellites(cache, tle_db);
+	assert_int_equal(pass_cache_num_passes(cache, 0), 0);
+
+	//passes of satellites that are not cached should be predicted inline instead of being pending
+	if (has_passes(tle_db, 0, new_observer, curr_time)) {
+		predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, 0);
+		struct pass_cache_pass pass, expected_pass;
+		assert_true(pass_cache_try_current_pass(cache, 0, new_observer, orbital_elements, curr_time, &pass));
+		pass_cache_current_pass(NULL, -1, new_observer, orbital_elements, curr_time, &expected_pass);
+		assert_pass_equal(&pass, &expected_pass);
+	}
+	assert_non_null(cache->entries[NUM_TEST_SATELLITES]);
+	assert_null(cache->entries[NUM_TEST_SATELLITES+1]);
+
+	pass_cache_destroy(&cache);
+	predict_destroy_observer(observer);
+	predict_destroy_observer(new_observer);
+	tle_db_destroy(&tle_db);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_xdg_dirs()
+{
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_pass_cache_passes),
+	cmocka_unit_test(test_pass_cache_invalidation)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,171 @@
+#include "pass_sampler.h"
+#include "test_tles.h"
+#include "ephemeris_context.h"
+#include "defines.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//number of TLEs read from the test file
+#define NUM_TEST_TLES 20
+
+//number of passes checked for each satellite
+#define NUM_TEST_PASSES 3
+
+//one second, in days
+#define ONE_SECOND (1.0/86400.0)
+
+//tolerance for the sampled elevation and azimuth compared to the full model, in radians
+#define ANGLE_TOLERANCE (0.05*M_PI/180.0)
+
+/**
+ * Predict the next pass, as done in the pass cache.
+ **/
+void next_pass(const predict_observer_t *observer, const predict_orbital_elements_t *elements, predict_julian_date_t start_time, struct pass_cache_pass *pass)
+{
+	struct predict_observation aos = predict_next_aos(observer, elements, start_time);
+	struct predict_observation los = predict_next_los(observer, elements, aos.time);
+	struct predict_observation tca = predict_at_max_elevation(observer, elements, aos.time);
+	pass->aos_time = aos.time;
+	pass->aos_azimuth = aos.azimuth;
+	pass->tca_time = tca.time;
+	pass->tca_azimuth = tca.azimuth;
+	pass->max_elevation = tca.elevation;
+	pass->los_time = los.time;
+	pass->los_azimuth = los.azimuth;
+}
+
+/**
+ * Check the samples against the full model, and that they cover the pass from AOS to LOS.
+ **/
+void assert_samples_match_model(const predict_orbital_elements_t *elements, const predict_observer_t *observer, const struct pass_cache_pass *pass, const struct pass_samples *samples)
+{
+	assert_true(samples->num_samples >= 2);
+	assert_true(samples->samples[0].orbit.time == pass->aos_time);
+	assert_true(samples->samples[samples->num_samples-1].orbit.time == pass->los_time);
+
+	for (int i=0; i < samples->num_samples; i++) {
+		const struct pass_sample *sample = &(samples->samples[i]);
+		if (i > 0) {
+			assert_true(sample->orbit.time > samples->samples[i-1].orbit.time);
+		}
+
+		struct predict_position orbit;
+		struct predict_observation obs;
+		predict_orbit(elements, &orbit, sample->orbit.time);
+		predict_observe_orbit(observer, &orbit, &obs);
+
+		double position_error = 0;
+		for (int j=0; j < 3; j++) {
+			position_error += pow(sample->orbit.position[j] - orbit.position[j], 2);
+		}
+		assert_true(sqrt(position_error) < 2*PASS_SAMPLER_POSITION_TOLERANCE);
+		assert_float_equal(sample->obs.elevation, obs.elevation, ANGLE_TOLERANCE);
+		assert_float_equal(sample->obs.range, obs.range, 2*PASS_SAMPLER_POSITION_TOLERANCE);
+		assert_float_equal(sample->orbit.latitude, orbit.latitude, 1.0E-4);
+		if (obs.elevation < 80*M_PI/180.0) {
+			assert_float_equal(cos(sample->obs.azimuth - obs.azimuth), 1.0, ANGLE_TOLERANCE);
+		}
+
+		//revolution number is taken from the closest anchor when changing between anchors less than PASS_SAMPLER_MIN_INTERVAL apart
+		if (sample->orbit.revolutions != orbit.revolutions) {
+			struct predict_position before, after;
+			predict_orbit(elements, &before, sample->orbit.time - PASS_SAMPLER_MIN_INTERVAL*ONE_SECOND);
+			predict_orbit(elements, &after, sample->orbit.time + PASS_SAMPLER_MIN_INTERVAL*ONE_SECOND);
+			assert_true(before.revolutions != after.revolutions);
+		}
+		assert_true(sample->orbit.eclipsed == orbit.eclipsed);
+		assert_true(sample->obs.visible == obs.visible);
+	}
+}
+
+void test_pass_sampler_sample(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, NUM_TEST_TLES, elements);
+	assert_true(num_elements > 0);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+
+	struct pass_sampler_resolution time_resolution = {PASS_SAMPLER_TIME_RESOLUTION, 10.0};
+	struct pass_sampler_resolution angular_resolution = {PASS_SAMPLER_ANGULAR_RESOLUTION, 5.0};
+	struct pass_samples samples = {0};
+	int num_passes = 0;
+	for (int i=0; i < num_elements; i++) {
+		predict_julian_date_t start_time = test_tles_epoch(elements[i]);
+		struct predict_position orbit;
+		predict_orbit(elements[i], &orbit, start_time);
+		if (!predict_aos_happens(elements[i], observer->latitude) || predict_is_geosynchronous(elements[i]) || orbit.decayed) {
+			continue;
+		}
+
+		for (int j=0; j < NUM_TEST_PASSES; j++) {
+			struct pass_cache_pass pass;
+			next_pass(observer, elements[i], start_time, &pass);
+			start_time = pass.los_time + ONE_SECOND;
+			num_passes++;
+
+			//samples at time resolution should be evenly spaced, and use fewer propagations than samples
+			pass_sampler_sample(elements[i], observer, &pass, &time_resolution, NAUTICAL_TWILIGHT_SUN_ELEVATION, &samples);
+			assert_samples_match_model(elements[i], observer, &pass, &samples);
+			for (int k=1; k < samples.num_samples - 1; k++) {
+				assert_float_equal(samples.samples[k].orbit.time - samples.samples[k-1].orbit.time, time_resolution.step*ONE_SECOND, 1.0E-3*ONE_SECOND);
+			}
+			assert_true(samples.num_propagations < samples.num_samples);
+
+			//samples at angular resolution should be at most a bit more than the step apart on the sky
+			pass_sampler_sample(elements[i], observer, &pass, &angular_resolution, NAUTICAL_TWILIGHT_SUN_ELEVATION, &samples);
+			assert_samples_match_model(elements[i], observer, &pass, &samples);
+			for (int k=1; k < samples.num_samples; k++) {
+				const struct predict_observation *prev_obs = &(samples.samples[k-1].obs);
+				const struct predict_observation *obs = &(samples.samples[k].obs);
+				double distance = acos(fmin(sin(prev_obs->elevation)*sin(obs->elevation) + cos(prev_obs->elevation)*cos(obs->elevation)*cos(prev_obs->azimuth - obs->azimuth), 1.0));
+				assert_true(distance*180.0/M_PI < 1.5*angular_resolution.step);
+			}
+
+			//samples in sunlight above the horizon should be visible when the sun is always below the limit
+			pass_sampler_sample(elements[i], observer, &pass, &angular_resolution, 90.0, &samples);
+			for (int k=1; k < samples.num_samples - 1; k++) {
+				assert_true(samples.samples[k].obs.visible == !(samples.samples[k].orbit.eclipsed));
+			}
+		}
+	}
+	assert_true(num_passes > 0);
+	pass_samples_free(&samples);
+	assert_null(samples.samples);
+
+	predict_destroy_observer(observer);
+	test_tles_free(num_elements, elements);
+}
+
+void test_pass_sampler_parse_resolution(void **param)
+{
+	struct pass_sampler_resolution resolution;
+	assert_true(pass_sampler_parse_resolution("30s", &resolution));
+	assert_int_equal(resolution.type, PASS_SAMPLER_TIME_RESOLUTION);
+	assert_float_equal(resolution.step, 30.0, 1.0E-9);
+
+	assert_true(pass_sampler_parse_resolution("2.5deg", &resolution));
+	assert_int_equal(resolution.type, PASS_SAMPLER_ANGULAR_RESOLUTION);
+	assert_float_equal(resolution.step, 2.5, 1.0E-9);
+
+	assert_false(pass_sampler_parse_resolution("30", &resolution));
+	assert_false(pass_sampler_parse_resolution("-5deg", &resolution));
+	assert_false(pass_sampler_parse_resolution("0s", &resolution));
+	assert_false(pass_sampler_parse_resolution("deg", &resolution));
+	assert_false(pass_sampler_parse_resolution("5 minutes", &resolution));
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_pass_sampler_sample),
+	cmocka_unit_test(test_pass_sampler_parse_resolution)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,235 @@
+#include "pass_visibility.h"
+#include "test_tles.h"
+#include "ephemeris_context.h"
+#include "defines.h"
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//number of TLEs read from the test file
+#define NUM_TEST_TLES 20
+
+//number of passes checked for each satellite
+#define NUM_TEST_PASSES 20
+
+//one second, in days
+#define ONE_SECOND (1.0/86400.0)
+
+/**
+ * Get the sun elevation, in degrees.
+ **/
+double sun_elevation(const predict_observer_t *observer, predict_julian_date_t time)
+{
+	struct predict_observation sun;
+	predict_observe_sun(observer, time, &sun);
+	return sun.elevation*180.0/M_PI;
+}
+
+/**
+ * Check the darkness windows found from the given time against the sun elevation sampled at each minute.
+ **/
+void assert_darkness_windows(const predict_observer_t *observer, predict_julian_date_t start_time, predict_julian_date_t end_time)
+{
+	predict_julian_date_t time = start_time;
+	while (time < end_time) {
+		predict_julian_date_t darkness_start = pass_visibility_next_darkness(observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, time, end_time);
+		for (predict_julian_date_t t = time; t < darkness_start - ONE_SECOND; t += 60*ONE_SECOND) {
+			assert_true(sun_elevation(observer, t) >= NAUTICAL_TWILIGHT_SUN_ELEVATION);
+		}
+		if (darkness_start >= end_time) {
+			break;
+		}
+		assert_true(sun_elevation(observer, darkness_start) < NAUTICAL_TWILIGHT_SUN_ELEVATION);
+		if (darkness_start > time) {
+			assert_true(sun_elevation(observer, darkness_start - 2*ONE_SECOND) >= NAUTICAL_TWILIGHT_SUN_ELEVATION);
+		}
+
+		predict_julian_date_t darkness_end = pass_visibility_darkness_end(observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, darkness_start, end_time);
+		assert_true(darkness_end > darkness_start);
+		for (predict_julian_date_t t = darkness_start; t < darkness_end - ONE_SECOND; t += 60*ONE_SECOND) {
+			assert_true(sun_elevation(observer, t) < NAUTICAL_TWILIGHT_SUN_ELEVATION);
+		}
+		if (darkness_end < end_time) {
+			assert_true(sun_elevation(observer, darkness_end) >= NAUTICAL_TWILIGHT_SUN_ELEVATION);
+		}
+		time = darkness_end;
+	}
+}
+
+void test_pass_visibility_darkness(void **param)
+{
+	//nights in spring at the test QTH
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct tm start_tm = {.tm_year = 116, .tm_mon = 2, .tm_mday = 15};
+	predict_julian_date_t start_time = predict_to_julian(timegm(&start_tm));
+	assert_darkness_windows(observer, start_time, start_time + 5);
+	predict_destroy_observer(observer);
+
+	//no darkness in the arctic summer, until the middle of August
+	observer = predict_create_observer("arctic", 78.22*M_PI/180.0, 15.65*M_PI/180.0, 0);
+	start_tm.tm_mon = 5;
+	start_tm.tm_mday = 1;
+	start_time = predict_to_julian(timegm(&start_tm));
+	predict_julian_date_t darkness_start = pass_visibility_next_darkness(observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, start_time, start_time + PASS_VISIBILITY_MAX_DARKNESS_SEARCH);
+	assert_true(darkness_start > start_time + 60);
+	assert_true(darkness_start < start_time + 120);
+	assert_darkness_windows(observer, darkness_start - 1, darkness_start + 3);
+	predict_destroy_observer(observer);
+}
+
+void test_pass_visibility_visible_time(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, NUM_TEST_TLES, elements);
+	assert_true(num_elements > 0);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+
+	struct eclipse_intervals intervals = {0};
+	int num_passes = 0;
+	int num_visible_passes = 0;
+	for (int i=0; i < num_elements; i++) {
+		predict_julian_date_t start_time = test_tles_epoch(elements[i]);
+		struct predict_position orbit;
+		predict_orbit(elements[i], &orbit, start_time);
+		if (!predict_aos_happens(elements[i], observer->latitude) || predict_is_geosynchronous(elements[i]) || orbit.decayed) {
+			continue;
+		}
+
+		for (int j=0; j < NUM_TEST_PASSES; j++) {
+			struct predict_observation aos = predict_next_aos(observer, elements[i], start_time);
+			struct predict_observation los = predict_next_los(observer, elements[i], aos.time);
+			struct pass_cache_pass pass = {.aos_time = aos.time, .tca_time = aos.time, .los_time = los.time};
+			start_time = los.time + ONE_SECOND;
+			bool decayed;
+			double visible_time = pass_visibility_visible_time(elements[i], observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, &pass, &intervals, &decayed);
+			assert_false(decayed);
+			num_passes++;
+
+			//compare against the visibility sampled at each second
+			int num_visible_seconds = 0;
+			int num_seconds = 0;
+			for (predict_julian_date_t t = pass.aos_time + ONE_SECOND/2; t < pass.los_time; t += ONE_SECOND) {
+				predict_orbit(elements[i], &orbit, t);
+				struct predict_observation obs;
+				predict_observe_orbit(observer, &orbit, &obs);
+				if (obs.visible) {
+					num_visible_seconds++;
+				}
+				num_seconds++;
+			}
+			assert_true(visible_time >= 0);
+			assert_true(visible_time <= num_seconds + 1);
+			assert_true(fabs(visible_time - num_visible_seconds) < 5);
+			if (visible_time > 0) {
+				num_visible_passes++;
+			}
+		}
+	}
+	//some passes should be visible, and some should not
+	assert_true(num_visible_passes > 0);
+	assert_true(num_visible_passes < num_passes);
+
+	eclipse_intervals_free(&intervals);
+	predict_destroy_observer(observer);
+	test_tles_free(num_elements, elements);
+}
+
+/**
+ * Check whether a pass would have been shown as visible by PREDICT, with rows at its time increment.
+ **/
+bool predict_visible_pass(const predict_orbital_elements_t *elements, const predict_observer_t *observer, const struct pass_cache_pass *pass)
+{
+	int plus = 0;
+	int asterisk = 0;
+	predict_julian_date_t time = pass->aos_time;
+	struct predict_position orbit;
+	struct predict_observation obs;
+	predict_orbit(elements, &orbit, time);
+	predict_observe_orbit(observer, &orbit, &obs);
+	bool has_last_row = false;
+	int last_elevation = 1;
+	do {
+		if (obs.visible) {
+			plus++;
+		} else if (!orbit.eclipsed) {
+			asterisk++;
+		}
+		last_elevation = obs.elevation*180.0/M_PI;
+		time += cos((obs.elevation*180/M_PI-1.0)*M_PI/180.0)*sqrt(orbit.altitude)/25000.0;
+		predict_orbit(elements, &orbit, time);
+		predict_observe_orbit(observer, &orbit, &obs);
+		if ((last_elevation != 0) && (obs.elevation < 0) && !has_last_row) {
+			has_last_row = true;
+			time = pass->los_time;
+			predict_orbit(elements, &orbit, time);
+			predict_observe_orbit(observer, &orbit, &obs);
+		}
+	} while ((obs.elevation >= 0) || (time <= pass->los_time));
+	return (plus>3) || (plus>2 && asterisk>2);
+}
+
+void test_pass_visibility_shown(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, NUM_TEST_TLES, elements);
+	assert_true(num_elements > 0);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+
+	struct eclipse_intervals intervals = {0};
+	int num_shown_passes = 0;
+	int num_short_passes = 0;
+	for (int i=0; i < num_elements; i++) {
+		predict_julian_date_t start_time = test_tles_epoch(elements[i]);
+		struct predict_position orbit;
+		predict_orbit(elements[i], &orbit, start_time);
+		if (!predict_aos_happens(elements[i], observer->latitude) || predict_is_geosynchronous(elements[i]) || orbit.decayed) {
+			continue;
+		}
+
+		for (int j=0; j < NUM_TEST_PASSES; j++) {
+			struct predict_observation aos = predict_next_aos(observer, elements[i], start_time);
+			struct predict_observation los = predict_next_los(observer, elements[i], aos.time);
+			struct pass_cache_pass pass = {.aos_time = aos.time, .tca_time = aos.time, .los_time = los.time};
+			start_time = los.time + ONE_SECOND;
+			bool shown = pass_visibility_shown(elements[i], observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, &pass, &intervals);
+			bool decayed;
+			double visible_time = pass_visibility_visible_time(elements[i], observer, NAUTICAL_TWILIGHT_SUN_ELEVATION, &pass, &intervals, &decayed);
+			assert_true(shown == (visible_time >= PASS_VISIBILITY_MIN_VISIBLE_TIME));
+
+			//all passes shown by PREDICT should still be shown
+			if (predict_visible_pass(elements[i], observer, &pass)) {
+				assert_true(shown);
+			}
+			if (shown) {
+				num_shown_passes++;
+			} else if (visible_time > 0) {
+				num_short_passes++;
+			}
+		}
+	}
+
+	//the threshold should matter for the test passes
+	assert_true(num_shown_passes > 0);
+	assert_true(num_short_passes > 0);
+
+	eclipse_intervals_free(&intervals);
+	predict_destroy_observer(observer);
+	test_tles_free(num_elements, elements);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_pass_visibility_darkness),
+	cmocka_unit_test(test_pass_visibility_visible_time),
+	cmocka_unit_test(test_pass_visibility_shown)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,161 @@
+#include "schedule_worker.h"
+#include "defines.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//number of rows pushed by the finite test task
+#define NUM_ROWS 1000
+
+//size of the queue in the tests
+#define QUEUE_SIZE 50
+
+//set to make the creation of the worker thread fail
+bool fail_thread_creation = false;
+
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void*), void *arg);
+
+/**
+ * Wrapper around pthread_create(), linked using --wrap=pthread_create.
+ **/
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void*), void *arg)
+{
+	if (fail_thread_creation) {
+		return EAGAIN;
+	}
+	return __real_pthread_create(thread, attr, start_routine, arg);
+}
+
+/**
+ * Test task data.
+ **/
+struct test_task {
+	///Number of rows to push, -1 for pushing until cancelled
+	int num_rows;
+	///Number of rows pushed
+	int num_pushed_rows;
+};
+
+/**
+ * Test task, pushing numbered rows.
+ **/
+void test_task_run(struct schedule_worker *worker, void *data)
+{
+	struct test_task *task = (struct test_task*)data;
+	char row[MAX_NUM_CHARS];
+	for (int i=0; (task->num_rows < 0) || (i < task->num_rows); i++) {
+		snprintf(row, MAX_NUM_CHARS, "row %d\n", i);
+		if (!schedule_worker_push(worker, row)) {
+			break;
+		}
+		task->num_pushed_rows++;
+	}
+}
+
+/**
+ * Wait until the worker has a row or has finished.
+ **/
+enum schedule_worker_status wait_for_row(struct schedule_worker *worker, char *row)
+{
+	enum schedule_worker_status status;
+	while ((status = schedule_worker_pop(worker, row)) == SCHEDULE_WORKER_EMPTY) {
+		usleep(100);
+	}
+	return status;
+}
+
+void test_schedule_worker_rows(void **param)
+{
+	//all rows should be popped in the order they were pushed, followed by the finished status
+	struct test_task task = {.num_rows = NUM_ROWS};
+	struct schedule_worker *worker = schedule_worker_start(test_task_run, &task, QUEUE_SIZE);
+	char row[MAX_NUM_CHARS], expected_row[MAX_NUM_CHARS];
+	for (int i=0; i < NUM_ROWS; i++) {
+		assert_int_equal(wait_for_row(worker, row), SCHEDULE_WORKER_ROW);
+		snprintf(expected_row, MAX_NUM_CHARS, "row %d\n", i);
+		assert_string_equal(row, expected_row);
+	}
+	assert_int_equal(wait_for_row(worker, row), SCHEDULE_WORKER_FINISHED);
+	assert_int_equal(task.num_pushed_rows, NUM_ROWS);
+	schedule_worker_destroy(&worker);
+	assert_null(worker);
+}
+
+void test_schedule_worker_cancel(void **param)
+{
+	//the worker should wait when the queue is full
+	struct test_task task = {.num_rows = -1};
+	struct schedule_worker *worker = schedule_worker_start(test_task_run, &task, QUEUE_SIZE);
+	usleep(100000);
+	pthread_mutex_lock(&(worker->lock));
+	assert_int_equal(worker->num_rows, QUEUE_SIZE);
+	pthread_mutex_unlock(&(worker->lock));
+
+	//popping rows should let the worker continue
+	char row[MAX_NUM_CHARS];
+	for (int i=0; i < 10; i++) {
+		assert_int_equal(wait_for_row(worker, row), SCHEDULE_WORKER_ROW);
+	}
+	usleep(100000);
+	pthread_mutex_lock(&(worker->lock));
+	assert_int_equal(worker->num_rows, QUEUE_SIZE);
+	pthread_mutex_unlock(&(worker->lock));
+
+	//cancelling should stop the task, and the remaining rows can still be popped
+	schedule_worker_cancel(worker);
+	int num_popped_rows = 10;
+	while (wait_for_row(worker, row) == SCHEDULE_WORKER_ROW) {
+		num_popped_rows++;
+	}
+	assert_int_equal(num_popped_rows, task.num_pushed_rows);
+	schedule_worker_destroy(&worker);
+
+	//destroying a worker that is waiting on a full queue should not hang
+	task.num_rows = -1;
+	task.num_pushed_rows = 0;
+	worker = schedule_worker_start(test_task_run, &task, QUEUE_SIZE);
+	usleep(10000);
+	schedule_worker_destroy(&worker);
+	assert_null(worker);
+}
+
+void test_schedule_worker_thread_failure(void **param)
+{
+	//no rows should be calculated and silently dropped when the worker thread cannot be created
+	struct test_task task = {.num_rows = NUM_ROWS};
+	fail_thread_creation = true;
+	struct schedule_worker *worker = schedule_worker_start(test_task_run, &task, QUEUE_SIZE);
+	fail_thread_creation = false;
+	assert_null(worker);
+	assert_int_equal(task.num_pushed_rows, 0);
+
+	//all rows should be delivered once the thread can be created
+	worker = schedule_worker_start(test_task_run, &task, QUEUE_SIZE);
+	assert_non_null(worker);
+	char row[MAX_NUM_CHARS];
+	int num_popped_rows = 0;
+	while (wait_for_row(worker, row) == SCHEDULE_WORKER_ROW) {
+		num_popped_rows++;
+	}
+	assert_int_equal(num_popped_rows, NUM_ROWS);
+	assert_int_equal(task.num_pushed_rows, NUM_ROWS);
+	schedule_worker_destroy(&worker);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_schedule_worker_rows),
+	cmocka_unit_test(test_schedule_worker_cancel),
+	cmocka_unit_test(test_schedule_worker_thread_failure)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
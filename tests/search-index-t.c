@@ -0,0 +1,116 @@
+#include "search_index.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define NUM_ITEMS 1000
+
+/**
+ * Reference fields of the items, used for finding the expected matches by brute force.
+ **/
+char reference_names[NUM_ITEMS][32];
+long reference_numbers[NUM_ITEMS];
+char reference_designators[NUM_ITEMS][16];
+
+/**
+ * Case-insensitive substring check.
+ **/
+bool contains(const char *string, const char *query)
+{
+	int length = strlen(query);
+	for (int i=0; string[i] != '\0'; i++) {
+		if (strncasecmp(string + i, query, length) == 0) {
+			return true;
+		}
+	}
+	return length == 0;
+}
+
+/**
+ * Check that the search returns the items containing the query in any field, in ascending order.
+ **/
+void assert_search(struct search_index *index, const char *query)
+{
+	int num_matches = 0;
+	const int *matches = search_index_search(index, query, &num_matches);
+	int num_expected = 0;
+	for (int i=0; i < NUM_ITEMS; i++) {
+		char number[32];
+		snprintf(number, sizeof(number), "%ld", reference_numbers[i]);
+		if (contains(reference_names[i], query) || contains(number, query) || contains(reference_designators[i], query)) {
+			assert_true(num_expected < num_matches);
+			assert_int_equal(matches[num_expected], i);
+			num_expected++;
+		}
+	}
+	assert_int_equal(num_matches, num_expected);
+}
+
+/**
+ * Set random name, satellite number and designator of an item.
+ **/
+void set_random_item(struct search_index *index, int item)
+{
+	const char *prefixes[] = {"ISS", "NOAA", "Cosmos", "starlink", "OSCAR", "Fox"};
+	snprintf(reference_names[item], sizeof(reference_names[item]), "%s %c%d", prefixes[rand() % 6], 'A' + rand() % 26, rand() % 1000);
+	reference_numbers[item] = rand() % 60000;
+	snprintf(reference_designators[item], sizeof(reference_designators[item]), "%02d%03d%c", rand() % 100, rand() % 400, 'A' + rand() % 26);
+	search_index_set_item(index, item, reference_names[item], reference_numbers[item], reference_designators[item]);
+}
+
+void test_search_index_search(void **param)
+{
+	srand(1);
+	struct search_index *index = search_index_create(NUM_ITEMS);
+	for (int i=0; i < NUM_ITEMS; i++) {
+		set_random_item(index, i);
+	}
+
+	//matching should be case-insensitive, and include satellite numbers and designators
+	assert_search(index, "iss");
+	assert_search(index, "NOAA");
+	assert_search(index, "StarLink");
+	assert_search(index, "cosmos b");
+	assert_search(index, reference_designators[17]);
+	assert_search(index, "nothing");
+	char number[32];
+	snprintf(number, sizeof(number), "%ld", reference_numbers[42]);
+	assert_search(index, number);
+
+	//queries extended and shortened one character at a time, as typed in the search field
+	const char *query = "Starlink Q12";
+	char partial_query[32] = {0};
+	for (int i=0; i < strlen(query); i++) {
+		partial_query[i] = query[i];
+		assert_search(index, partial_query);
+	}
+	for (int i=strlen(query) - 1; i >= 0; i--) {
+		partial_query[i] = '\0';
+		assert_search(index, partial_query);
+	}
+
+	//changed items should be found after a search that could otherwise have been narrowed
+	assert_search(index, "fox");
+	for (int i=0; i < NUM_ITEMS; i += 7) {
+		set_random_item(index, i);
+	}
+	assert_search(index, "fox ");
+
+	search_index_destroy(&index);
+	assert_null(index);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_search_index_search)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,203 @@
+#include "sgp4_batch.h"
+#include "test_tles.h"
+#include "defines.h"
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+/**
+ * Set the time the batch is propagated to, using an ephemeris context for the given observer.
+ *
+ * \param batch Batch
+ * \param observer Observer
+ * \param time Time
+ **/
+void set_batch_time(struct sgp4_batch *batch, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	struct ephemeris_context context;
+	ephemeris_context_update(&context, observer, time);
+	sgp4_batch_set_context(batch, &context);
+}
+
+/**
+ * Check that the difference between two angles is within the tolerance.
+ **/
+void assert_angle_equal(double angle_1, double angle_2, double tolerance)
+{
+	assert_true(fabs(remainder(angle_1 - angle_2, 2*M_PI)) < tolerance);
+}
+
+void test_sgp4_batch_spacetrack_report(void **param)
+{
+	//SGP4 test case from Spacetrack Report #3, positions in km and velocities in km/s
+	const char *line1 = "1 88888U          80275.98708465  .00073094  13844-3  66816-4 0    87";
+	const char *line2 = "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518  1058";
+	double tsince[] = {0, 360, 720, 1080, 1440};
+	double expected[][6] = {{2328.97048951, -5995.22076416, 1719.97067261, 2.91207230, -0.98341546, -7.09081703},
+		{2456.10705566, -6071.93853760, 1222.89727783, 2.67938992, -0.44829041, -7.22879231},
+		{2567.56195068, -6112.50384522, 713.96397400, 2.44024599, 0.09810869, -7.31995916},
+		{2663.09078980, -6115.48229980, 196.39640427, 2.19611958, 0.65241995, -7.36282432},
+		{2742.55133057, -6079.67144775, -326.38095856, 1.94850229, 1.21106251, -7.35619372}};
+
+	predict_orbital_elements_t *elements = predict_parse_tle(line1, line2);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct sgp4_batch *batch = sgp4_batch_create(1, &elements);
+	assert_int_equal(batch->num_slots, 1);
+
+	//day numbers count from 31Dec79 00:00:00 UTC, i.e. day 0 of 1980
+	for (int i=0; i < sizeof(tsince)/sizeof(tsince[0]); i++) {
+		set_batch_time(batch, observer, 275.98708465 + tsince[i]/1440.0);
+		sgp4_batch_propagate(batch, 0, 1);
+		struct predict_position orbit;
+		assert_true(sgp4_batch_orbit(batch, 0, &orbit));
+
+		//the reference values were calculated in single precision, using a slightly different earth radius
+		for (int j=0; j < 3; j++) {
+			assert_float_equal(orbit.position[j], expected[i][j], 2.0E-2);
+			assert_float_equal(orbit.velocity[j], expected[i][j+3], 2.0E-5);
+		}
+	}
+	sgp4_batch_destroy(&batch);
+	assert_null(batch);
+	predict_destroy_orbital_elements(elements);
+	predict_destroy_observer(observer);
+}
+
+void test_sgp4_batch_orbit(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+	assert_true(num_elements > SGP4_BATCH_WIDTH*2);
+
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct sgp4_batch *batch = sgp4_batch_create(num_elements, elements);
+	int num_sgp4 = 0;
+	for (int i=0; i < num_elements; i++) {
+		if (elements[i]->ephemeris == EPHEMERIS_SGP4) {
+			num_sgp4++;
+		}
+	}
+	assert_int_equal(batch->num_slots, num_sgp4);
+	assert_true(num_sgp4 > 0);
+
+	double times[] = {-2.0, 0.0, 0.37, 3.0, 10.0};
+	for (int i=0; i < sizeof(times)/sizeof(times[0]); i++) {
+		predict_julian_date_t time = batch->model.epoch[0] + times[i];
+		set_batch_time(batch, observer, time);
+
+		//propagate in uneven ranges, so that both the vectorized kernel and the remainder loop are used
+		sgp4_batch_propagate(batch, 0, 7);
+		sgp4_batch_propagate(batch, 7, num_elements);
+
+		for (int j=0; j < num_elements; j++) {
+			struct predict_position orbit;
+			bool in_batch = sgp4_batch_orbit(batch, j, &orbit);
+			assert_true(in_batch == (elements[j]->ephemeris == EPHEMERIS_SGP4));
+			if (!in_batch) {
+				continue;
+			}
+
+			struct predict_position expected_orbit;
+			predict_orbit(elements[j], &expected_orbit, time);
+			for (int k=0; k < 3; k++) {
+				assert_float_equal(orbit.position[k], expected_orbit.position[k], SGP4_BATCH_POSITION_TOLERANCE);
+				assert_float_equal(orbit.velocity[k], expected_orbit.velocity[k], SGP4_BATCH_VELOCITY_TOLERANCE);
+			}
+			assert_angle_equal(orbit.latitude, expected_orbit.latitude, 1.0E-6);
+			assert_angle_equal(orbit.longitude, expected_orbit.longitude, 1.0E-6);
+			assert_float_equal(orbit.altitude, expected_orbit.altitude, SGP4_BATCH_POSITION_TOLERANCE);
+			assert_float_equal(orbit.footprint, expected_orbit.footprint, 1.0E-2);
+			assert_true(orbit.time == expected_orbit.time);
+			assert_true(orbit.eclipsed == expected_orbit.eclipsed);
+			assert_true(orbit.decayed == expected_orbit.decayed);
+			assert_int_equal(orbit.revolutions, expected_orbit.revolutions);
+		}
+	}
+
+	sgp4_batch_destroy(&batch);
+	predict_destroy_observer(observer);
+	test_tles_free(num_elements, elements);
+}
+
+void test_sgp4_batch_near_circular(void **param)
+{
+	//eccentricity below the limit of the terms that divide by the eccentricity in SGP4
+	const char *line1 = "1 25544U 98067A   20045.18587073  .00000950  00000-0  25302-4 0  9990";
+	const char *line2 = "2 25544  51.6443 242.0161 0000500 206.0170 316.3694 15.49165514212796";
+	predict_orbital_elements_t *elements = predict_parse_tle(line1, line2);
+	assert_true(elements->eccentricity < 1.0E-4);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct sgp4_batch *batch = sgp4_batch_create(1, &elements);
+	assert_int_equal(batch->num_slots, 1);
+
+	double times[] = {-2.0, 0.0, 0.37, 3.0, 10.0};
+	for (int i=0; i < sizeof(times)/sizeof(times[0]); i++) {
+		predict_julian_date_t time = batch->model.epoch[0] + times[i];
+		set_batch_time(batch, observer, time);
+		sgp4_batch_propagate(batch, 0, 1);
+		struct predict_position orbit, expected_orbit;
+		assert_true(sgp4_batch_orbit(batch, 0, &orbit));
+		predict_orbit(elements, &expected_orbit, time);
+		for (int k=0; k < 3; k++) {
+			assert_float_equal(orbit.position[k], expected_orbit.position[k], SGP4_BATCH_POSITION_TOLERANCE);
+			assert_float_equal(orbit.velocity[k], expected_orbit.velocity[k], SGP4_BATCH_VELOCITY_TOLERANCE);
+		}
+	}
+
+	sgp4_batch_destroy(&batch);
+	predict_destroy_orbital_elements(elements);
+	predict_destroy_observer(observer);
+}
+
+void test_sgp4_batch_kernels(void **param)
+{
+	predict_orbital_elements_t *elements[MAX_NUM_TEST_TLES];
+	int num_elements = test_tles_read(TEST_TLE_FILE, MAX_NUM_TEST_TLES, elements);
+	predict_observer_t *observer = predict_create_observer("test", TEST_QTH_LATITUDE, TEST_QTH_LONGITUDE, TEST_QTH_ALTITUDE);
+	struct sgp4_batch *batch = sgp4_batch_create(num_elements, elements);
+
+	//vectorized and scalar kernels should give the same results, if the vectorized kernel is supported
+	bool use_avx2 = batch->use_avx2;
+	for (int days=-30; days <= 30; days += 5) {
+		set_batch_time(batch, observer, batch->model.epoch[0] + days);
+		struct predict_position scalar_orbits[MAX_NUM_TEST_TLES];
+		batch->use_avx2 = false;
+		sgp4_batch_propagate(batch, 0, num_elements);
+		for (int i=0; i < num_elements; i++) {
+			sgp4_batch_orbit(batch, i, &scalar_orbits[i]);
+		}
+
+		batch->use_avx2 = use_avx2;
+		sgp4_batch_propagate(batch, 0, num_elements);
+		for (int i=0; i < num_elements; i++) {
+			struct predict_position orbit;
+			if (sgp4_batch_orbit(batch, i, &orbit)) {
+				for (int k=0; k < 3; k++) {
+					assert_float_equal(orbit.position[k], scalar_orbits[i].position[k], 1.0E-6);
+					assert_float_equal(orbit.velocity[k], scalar_orbits[i].velocity[k], 1.0E-9);
+				}
+			}
+		}
+	}
+
+	sgp4_batch_destroy(&batch);
+	predict_destroy_observer(observer);
+	test_tles_free(num_elements, elements);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_sgp4_batch_spacetrack_report),
+	cmocka_unit_test(test_sgp4_batch_orbit),
+	cmocka_unit_test(test_sgp4_batch_near_circular),
+	cmocka_unit_test(test_sgp4_batch_kernels)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
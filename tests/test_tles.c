@@ -0,0 +1,40 @@
+#include "test_tles.h"
+#include "defines.h"
+#include <time.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+int test_tles_read(const char *filename, int max_num_tles, predict_orbital_elements_t **elements)
+{
+	FILE *fd = fopen(filename, "r");
+	assert_non_null(fd);
+	char name[MAX_NUM_CHARS], line1[MAX_NUM_CHARS], line2[MAX_NUM_CHARS];
+	int num_tles = 0;
+	while ((num_tles < max_num_tles) && fgets(name, MAX_NUM_CHARS, fd) && fgets(line1, MAX_NUM_CHARS, fd) && fgets(line2, MAX_NUM_CHARS, fd)) {
+		elements[num_tles] = predict_parse_tle(line1, line2);
+		assert_non_null(elements[num_tles]);
+		num_tles++;
+	}
+	fclose(fd);
+	return num_tles;
+}
+
+void test_tles_free(int num_tles, predict_orbital_elements_t **elements)
+{
+	for (int i=0; i < num_tles; i++) {
+		predict_destroy_orbital_elements(elements[i]);
+	}
+}
+
+predict_julian_date_t test_tles_epoch(const predict_orbital_elements_t *elements)
+{
+	struct tm epoch_tm = {0};
+	epoch_tm.tm_year = (elements->epoch_year < 57) ? elements->epoch_year + 100 : elements->epoch_year;
+	epoch_tm.tm_mday = 1;
+	time_t epoch = timegm(&epoch_tm) + (time_t)((elements->epoch_day - 1)*86400);
+	return predict_to_julian(epoch);
+}
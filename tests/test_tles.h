@@ -0,0 +1,48 @@
+#ifndef TEST_TLES_H_DEFINED
+#define TEST_TLES_H_DEFINED
+
+#include <predict/predict.h>
+#include <math.h>
+
+/**
+ * TLE fixtures shared between the tests propagating orbits.
+ **/
+
+//TLE file with the test satellites
+#define TEST_TLE_FILE "test_data/newer_tles/amateur.txt"
+
+//maximum number of TLEs read from a test file
+#define MAX_NUM_TEST_TLES 100
+
+//test QTH, in radians and meters
+#define TEST_QTH_LATITUDE (63.42*M_PI/180.0)
+#define TEST_QTH_LONGITUDE (10.39*M_PI/180.0)
+#define TEST_QTH_ALTITUDE 50
+
+/**
+ * Read and parse TLEs from file. Fails the test if the file cannot be read or a TLE cannot be parsed.
+ *
+ * \param filename TLE file
+ * \param max_num_tles Maximum number of TLEs to read, at most MAX_NUM_TEST_TLES
+ * \param elements Returned orbital elements
+ * \return Number of TLEs
+ **/
+int test_tles_read(const char *filename, int max_num_tles, predict_orbital_elements_t **elements);
+
+/**
+ * Free orbital elements read using test_tles_read().
+ *
+ * \param num_tles Number of TLEs
+ * \param elements Orbital elements
+ **/
+void test_tles_free(int num_tles, predict_orbital_elements_t **elements);
+
+/**
+ * Get the epoch of the orbital elements.
+ *
+ * \param elements Orbital elements
+ * \return Epoch
+ **/
+predict_julian_date_t test_tles_epoch(const predict_orbital_elements_t *elements);
+
+#endif
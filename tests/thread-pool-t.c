@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define NUM_ITEMS 1001
+
+/**
+ * Test task data.
+ **/
+struct test_task {
+	///Number of times each item has been processed
+	int counts[NUM_ITEMS];
+	///Number of items to process
+	int num_items;
+};
+
+/**
+ * Test task, counting the items in the slice.
+ **/
+void test_task_run(void *data, int slice, int num_slices)
+{
+	struct test_task *task = (struct test_task*)data;
+	int start, end;
+	thread_pool_slice_range(task->num_items, slice, num_slices, &start, &end);
+	for (int i=start; i < end; i++) {
+		task->counts[i]++;
+	}
+}
+
+void test_thread_pool_slice_range(void **param)
+{
+	//slices should cover all items exactly once, also when there are fewer items than slices
+	int num_items[] = {0, 1, 3, 100, NUM_ITEMS};
+	for (int i=0; i < sizeof(num_items)/sizeof(num_items[0]); i++) {
+		for (int num_slices=1; num_slices < 10; num_slices++) {
+			int previous_end = 0;
+			for (int slice=0; slice < num_slices; slice++) {
+				int start, end;
+				thread_pool_slice_range(num_items[i], slice, num_slices, &start, &end);
+				assert_int_equal(start, previous_end);
+				assert_true(end >= start);
+				previous_end = end;
+			}
+			assert_int_equal(previous_end, num_items[i]);
+		}
+	}
+}
+
+void test_thread_pool_run(void **param)
+{
+	for (int num_threads=0; num_threads < 5; num_threads++) {
+		struct thread_pool *pool = thread_pool_create(num_threads);
+		assert_non_null(pool);
+		assert_true(pool->num_threads >= 1);
+
+		//each item should be processed once per run, over repeated runs
+		struct test_task task = {.num_items = NUM_ITEMS};
+		int num_runs = 20;
+		for (int i=0; i < num_runs; i++) {
+			thread_pool_run(pool, test_task_run, &task);
+		}
+		for (int i=0; i < NUM_ITEMS; i++) {
+			assert_int_equal(task.counts[i], num_runs);
+		}
+
+		thread_pool_destroy(&pool);
+		assert_null(pool);
+	}
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_thread_pool_slice_range),
+	cmocka_unit_test(test_thread_pool_run)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,92 @@
+#include "tle_check.h"
+#include "tle_db.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//Microbenchmark comparing tle_check(), tle_check_scalar() and KepCheck().
+//Usage: tle-check-benchmark [TLE file] [number of passes]
+
+/**
+ * Current time in seconds.
+ **/
+double benchmark_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1.0e-09;
+}
+
+/**
+ * Run check function over all TLEs the given number of times, and print the time spent per TLE.
+ *
+ * \param name Name of check function
+ * \param check Check function
+ * \param lines Line 1 and line 2 of each TLE, consecutively
+ * \param num_tles Number of TLEs
+ * \param num_passes Number of passes over all TLEs
+ **/
+void benchmark_check(const char *name, bool (*check)(const char*, const char*), char (*lines)[MAX_NUM_CHARS], int num_tles, int num_passes)
+{
+	int num_valid = 0;
+	double start = benchmark_time();
+	for (int pass=0; pass < num_passes; pass++) {
+		for (int i=0; i < num_tles; i++) {
+			num_valid += check(lines[2*i], lines[2*i+1]);
+		}
+	}
+	double elapsed = benchmark_time() - start;
+	printf("%-18s %8.2f ns/TLE (%d valid)\n", name, elapsed*1.0e09/(num_tles*(double)num_passes), num_valid/num_passes);
+}
+
+/**
+ * KepCheck() wrapped to the signature of tle_check().
+ **/
+bool kepcheck(const char *line1, const char *line2)
+{
+	return KepCheck(line1, line2);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *filename = (argc > 1) ? argv[1] : "test_data/newer_tles/amateur.txt";
+	int num_passes = (argc > 2) ? atoi(argv[2]) : 10000;
+
+	FILE *fd = fopen(filename, "r");
+	if (fd == NULL) {
+		fprintf(stderr, "Could not open %s\n", filename);
+		return 1;
+	}
+
+	//read TLE line pairs, skipping names
+	int num_tles = 0;
+	int available_size = 0;
+	char (*lines)[MAX_NUM_CHARS] = NULL;
+	char name[MAX_NUM_CHARS];
+	while (fgets(name, MAX_NUM_CHARS, fd)) {
+		if (num_tles*2 + 2 > available_size) {
+			available_size = available_size*2 + 2;
+			lines = realloc(lines, sizeof(char[MAX_NUM_CHARS])*available_size);
+		}
+		if (!fgets(lines[2*num_tles], MAX_NUM_CHARS, fd) || !fgets(lines[2*num_tles+1], MAX_NUM_CHARS, fd)) {
+			break;
+		}
+		if ((strlen(lines[2*num_tles]) >= TLE_LINE_LENGTH) && (strlen(lines[2*num_tles+1]) >= TLE_LINE_LENGTH)) {
+			num_tles++;
+		}
+	}
+	fclose(fd);
+
+	if (num_tles == 0) {
+		fprintf(stderr, "No TLEs in %s\n", filename);
+		return 1;
+	}
+
+	printf("%d TLEs, %d passes\n", num_tles, num_passes);
+	benchmark_check("KepCheck", kepcheck, lines, num_tles, num_passes);
+	benchmark_check("tle_check_scalar", tle_check_scalar, lines, num_tles, num_passes);
+	benchmark_check("tle_check", tle_check, lines, num_tles, num_passes);
+	free(lines);
+	return 0;
+}
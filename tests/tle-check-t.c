@@ -0,0 +1,92 @@
+#include "tle_check.h"
+#include "tle_db.h"
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_TLE_DIR "test_data/"
+
+//maximum number of TLEs read from a test file
+#define MAX_NUM_TEST_TLES 100
+
+/**
+ * Read TLE line pairs from file, without any validation.
+ *
+ * \param filename TLE file
+ * \param line1 Returned line 1 of each TLE
+ * \param line2 Returned line 2 of each TLE
+ * \return Number of TLEs
+ **/
+int read_tle_lines(const char *filename, char line1[][MAX_NUM_CHARS], char line2[][MAX_NUM_CHARS])
+{
+	FILE *fd = fopen(filename, "r");
+	assert_non_null(fd);
+	char name[MAX_NUM_CHARS];
+	int num_tles = 0;
+	while ((num_tles < MAX_NUM_TEST_TLES) && fgets(name, MAX_NUM_CHARS, fd) && fgets(line1[num_tles], MAX_NUM_CHARS, fd) && fgets(line2[num_tles], MAX_NUM_CHARS, fd)) {
+		num_tles++;
+	}
+	fclose(fd);
+	return num_tles;
+}
+
+/**
+ * Check that tle_check(), tle_check_scalar() and KepCheck() agree on the validity of a TLE.
+ *
+ * \param line1 Line 1 of TLE
+ * \param line2 Line 2 of TLE
+ * \return Validity of TLE
+ **/
+bool assert_tle_checks_equal(const char *line1, const char *line2)
+{
+	bool valid = KepCheck(line1, line2);
+	assert_int_equal(tle_check(line1, line2), valid);
+	assert_int_equal(tle_check_scalar(line1, line2), valid);
+	return valid;
+}
+
+void test_tle_check(void **param)
+{
+	const char *filenames[] = {TEST_TLE_DIR "old_tles/part1.tle", TEST_TLE_DIR "old_tles/part2.tle", TEST_TLE_DIR "newer_tles/amateur.txt"};
+	const char replacements[] = " 0123456789-+.U12A";
+
+	for (int i=0; i < sizeof(filenames)/sizeof(filenames[0]); i++) {
+		char line1[MAX_NUM_TEST_TLES][MAX_NUM_CHARS];
+		char line2[MAX_NUM_TEST_TLES][MAX_NUM_CHARS];
+		int num_tles = read_tle_lines(filenames[i], line1, line2);
+		assert_true(num_tles > 0);
+
+		for (int j=0; j < num_tles; j++) {
+			//unmodified TLEs are valid
+			assert_true(assert_tle_checks_equal(line1[j], line2[j]));
+
+			//replace each column in turn, which should invalidate the TLE in most cases
+			for (int col=0; col < TLE_LINE_LENGTH; col++) {
+				for (int k=0; k < strlen(replacements); k++) {
+					char orig = line1[j][col];
+					line1[j][col] = replacements[k];
+					assert_tle_checks_equal(line1[j], line2[j]);
+					line1[j][col] = orig;
+
+					orig = line2[j][col];
+					line2[j][col] = replacements[k];
+					assert_tle_checks_equal(line1[j], line2[j]);
+					line2[j][col] = orig;
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_tle_check)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
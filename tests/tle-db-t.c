@@ -28,10 +28,16 @@ void test_tle_db_find_entry(void **param)
 	long new_satellite_number = 83;
 	int index = 63;
 
-	tle_db->tles[index].satellite_number = new_satellite_number;
+	struct tle_db_entry new_entry = {0};
+	new_entry.satellite_number = new_satellite_number;
+	tle_db_overwrite_entry(index, tle_db, &new_entry);
 
+	//multiply defined satellite number, first occurrence should be returned
 	assert_int_equal(tle_db_find_entry(tle_db, new_satellite_number), index);
 
+	//old satellite number at the overwritten index should no longer be found
+	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), -1);
+
 	index = 40;
 	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), index);
 	assert_int_equal(tle_db_find_entry(tle_db, 200), -1);
@@ -124,6 +130,29 @@ void test_tle_db_entry_is_newer_than(void **param)
 	assert_false(tle_db_entry_is_newer_than(old_entry, new_entry));
 }
 
+void test_tle_db_entry_to_orbital_elements(void **param)
+{
+	struct tle_db *tle_db = tle_db_create();
+	assert_int_equal(tle_db_from_file(TEST_TLE_DIR "old_tles/part1.tle", tle_db), 0);
+
+	//orbital elements are parsed once and cached
+	predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, 0);
+	assert_non_null(orbital_elements);
+	assert_true(tle_db_entry_to_orbital_elements(tle_db, 0) == orbital_elements);
+	assert_int_equal(orbital_elements->satellite_number, tle_db->tles[0].satellite_number);
+	assert_true(tle_db_entry_epoch(tle_db, 0) > 0);
+
+	//overwriting with an identical entry keeps the cache, differing TLE lines invalidate it
+	struct tle_db_entry entry = tle_db->tles[1];
+	tle_db_overwrite_entry(0, tle_db, &(tle_db->tles[0]));
+	assert_true(tle_db->cache[0].orbital_elements == orbital_elements);
+	tle_db_overwrite_entry(0, tle_db, &entry);
+	assert_null(tle_db->cache[0].orbital_elements);
+	assert_int_equal(tle_db_entry_to_orbital_elements(tle_db, 0)->satellite_number, entry.satellite_number);
+
+	tle_db_destroy(&tle_db);
+}
+
 void test_tle_db_from_directory(void **param)
 {
 	struct tle_db *tle_db = tle_db_create();
@@ -203,6 +232,40 @@ void test_tle_db_filenames(void **param)
 	assert_int_not_equal(string_array_find(&string_array, TEST_TLE_DIR "old_tles/part2.tle"), -1);
 }
 
+void test_tle_db_from_file_formats(void **param)
+{
+	const char *name = "CUTE-1.7+APD II (CO-65)";
+	const char *line1 = "1 32785U 08021C   13115.72547332  .00001052  00000-0  13319-3 0  6142";
+	const char *line2 = "2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098";
+
+	//same TLE with padded name, CRLF line endings, 3LE name prefix and no trailing newline
+	const char *formats[] = {"%s\n%s\n%s\n",
+				 "%s            \n%s\n%s\n",
+				 "%s\r\n%s\r\n%s\r\n",
+				 "0 %s\n%s\n%s\n",
+				 "%s\n%s\n%s"};
+	for (int i=0; i < sizeof(formats)/sizeof(formats[0]); i++) {
+		char filename[L_tmpnam] = "/tmp/XXXXXX";
+		int fid = mkstemp(filename);
+		assert_true(fid != -1);
+		FILE *fd = fdopen(fid, "w");
+		fprintf(fd, formats[i], name, line1, line2);
+		fclose(fd);
+
+		struct tle_db *tle_db = tle_db_create();
+		assert_int_equal(tle_db_from_file(filename, tle_db), 0);
+		assert_int_equal(tle_db->num_tles, 1);
+		assert_int_equal(tle_db->tles[0].satellite_number, 32785);
+		assert_string_equal(tle_db->tles[0].name, name);
+		assert_string_equal(tle_db->tles[0].line1, line1);
+		assert_string_equal(tle_db->tles[0].line2, line2);
+		assert_string_equal(tle_db_entry_filename(tle_db, 0), filename);
+		tle_db_destroy(&tle_db);
+
+		unlink(filename);
+	}
+}
+
 void test_tle_db_to_file(void **param)
 {
 	char filename[L_tmpnam] = "/tmp/XXXXXX";
@@ -372,6 +435,114 @@ void test_tle_db_merge(void **param)
 	tle_db_destroy(&merged);
 }
 
+/**
+ * Reference implementation of the original quadratic TLE database merge, used for checking that
+ * tle_db_merge() retains the same behavior.
+ **/
+void reference_merge(struct tle_db *new_db, struct tle_db *main_db, enum tle_merge_behavior merge_opt)
+{
+	for (int i=0; i < new_db->num_tles; i++) {
+		bool tle_exists = false;
+		for (int j=0; j < main_db->num_tles; j++) {
+			if (new_db->tles[i].satellite_number == main_db->tles[j].satellite_number) {
+				tle_exists = true;
+
+				if ((merge_opt == TLE_OVERWRITE_OLD) && tle_db_entry_is_newer_than(new_db->tles[i], main_db->tles[j])) {
+					tle_db_overwrite_entry(j, main_db, &(new_db->tles[i]));
+				}
+			}
+		}
+
+		if (!tle_exists) {
+			tle_db_add_entry(main_db, &(new_db->tles[i]));
+		}
+	}
+}
+
+/**
+ * Check that two TLE databases contain the same entries in the same order.
+ **/
+void assert_tle_db_equal(struct tle_db *db_1, struct tle_db *db_2)
+{
+	assert_int_equal(db_1->num_tles, db_2->num_tles);
+	for (int i=0; i < db_1->num_tles; i++) {
+		assert_int_equal(db_1->tles[i].satellite_number, db_2->tles[i].satellite_number);
+		assert_string_equal(db_1->tles[i].name, db_2->tles[i].name);
+		assert_string_equal(db_1->tles[i].line1, db_2->tles[i].line1);
+		assert_string_equal(db_1->tles[i].line2, db_2->tles[i].line2);
+		assert_string_equal(tle_db_entry_filename(db_1, i), tle_db_entry_filename(db_2, i));
+	}
+}
+
+void test_tle_db_merge_matches_reference(void **param)
+{
+	const char *tle_files[] = {TEST_TLE_DIR "old_tles/part1.tle",
+				   TEST_TLE_DIR "newer_tles/amateur.txt",
+				   TEST_TLE_DIR "old_tles/part2.tle",
+				   TEST_TLE_DIR "old_tles/part1.tle"};
+	int num_files = sizeof(tle_files)/sizeof(tle_files[0]);
+	enum tle_merge_behavior behaviors[] = {TLE_OVERWRITE_OLD, TLE_OVERWRITE_NONE};
+
+	for (int b=0; b < 2; b++) {
+		//merge files one by one in both orders, as in tle_db_from_directory()
+		for (int reverse=0; reverse < 2; reverse++) {
+			struct tle_db *merged = tle_db_create();
+			struct tle_db *expected = tle_db_create();
+			for (int i=0; i < num_files; i++) {
+				const char *filename = tle_files[reverse ? num_files-1-i : i];
+				struct tle_db *file_db = tle_db_create();
+				tle_db_from_file(filename, file_db);
+				assert_true(file_db->num_tles > 0);
+
+				tle_db_merge(file_db, merged, behaviors[b]);
+				reference_merge(file_db, expected, behaviors[b]);
+				tle_db_destroy(&file_db);
+
+				assert_tle_db_equal(merged, expected);
+			}
+
+			//merge whole directories with lower precedence, as in tle_db_from_search_paths()
+			struct tle_db *dir_db = tle_db_create();
+			tle_db_from_directory(TEST_TLE_DIR "mixture/flyby/tles/", dir_db);
+			tle_db_merge(dir_db, merged, TLE_OVERWRITE_NONE);
+			reference_merge(dir_db, expected, TLE_OVERWRITE_NONE);
+			assert_tle_db_equal(merged, expected);
+
+			//lookups should still be consistent after merging
+			for (int i=0; i < merged->num_tles; i++) {
+				assert_int_equal(tle_db_find_entry(merged, merged->tles[i].satellite_number), i);
+			}
+
+			tle_db_destroy(&dir_db);
+			tle_db_destroy(&merged);
+			tle_db_destroy(&expected);
+		}
+	}
+}
+
+void test_tle_db_from_directory_threads(void **param)
+{
+	const char *dirs[] = {TEST_TLE_DIR "old_tles/", TEST_TLE_DIR "newer_tles/", TEST_TLE_DIR "mixture/flyby/tles/"};
+	for (int i=0; i < 3; i++) {
+		//single-threaded loading
+		struct tle_db *serial_db = tle_db_create();
+		serial_db->num_loader_threads = 1;
+		tle_db_from_directory(dirs[i], serial_db);
+		assert_true(serial_db->num_tles > 0);
+
+		//result should not depend on the number of threads
+		int num_threads[] = {2, 3, 16, 0};
+		for (int j=0; j < 4; j++) {
+			struct tle_db *threaded_db = tle_db_create();
+			threaded_db->num_loader_threads = num_threads[j];
+			tle_db_from_directory(dirs[i], threaded_db);
+			assert_tle_db_equal(threaded_db, serial_db);
+			tle_db_destroy(&threaded_db);
+		}
+		tle_db_destroy(&serial_db);
+	}
+}
+
 char *xdg_data_dirs()
 {
 	return strdup((char*)mock());
@@ -465,7 +636,7 @@ void test_whitelist_from_search_paths(void **param)
 void set_filenames(struct tle_db *tle_db, const char *filename)
 {
 	for (int i=0; i < tle_db->num_tles; i++) {
-		strcpy(tle_db->tles[i].filename, filename);
+		tle_db_entry_set_filename(tle_db, i, filename);
 	}
 }
 
@@ -566,7 +737,7 @@ void test_tle_db_update(void **param)
 
 			if (!updatefile_set) {
 				updatefile_set = true;
-				strncpy(updatefile, tle_db->tles[i].filename, MAX_NUM_CHARS);
+				strncpy(updatefile, tle_db_entry_filename(tle_db, i), MAX_NUM_CHARS);
 			}
 		}
 		update_status[i] = 0;
@@ -600,20 +771,103 @@ void test_tle_db_update(void **param)
 	free(update_status);
 }
 
+void test_tle_db_update_from_files(void **param)
+{
+	//combined update set from a directory and a file should keep the most recent TLEs
+	string_array_t update_files = {0};
+	string_array_add(&update_files, TEST_TLE_DIR "newer_tles/");
+	string_array_add(&update_files, TEST_TLE_DIR "old_tles/part1.tle");
+	string_array_add(&update_files, "/dev/NULL");
+	struct tle_db *update_db = tle_db_create();
+	assert_int_equal(tle_db_update_set_from_files(&update_files, update_db), 1);
+
+	struct tle_db *expected_db = tle_db_create();
+	tle_db_from_directory(TEST_TLE_DIR "newer_tles/", expected_db);
+	struct tle_db *part1_db = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "old_tles/part1.tle", part1_db);
+	tle_db_merge(part1_db, expected_db, TLE_OVERWRITE_OLD);
+	assert_int_equal(update_db->num_tles, expected_db->num_tles);
+	for (int i=0; i < update_db->num_tles; i++) {
+		assert_string_equal(update_db->tles[i].line1, expected_db->tles[i].line1);
+		assert_string_equal(update_db->tles[i].line2, expected_db->tles[i].line2);
+	}
+
+	//old database split across two writable files
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	mkdtemp(temp_dir);
+	char filenames[2][MAX_NUM_CHARS];
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_directory(TEST_TLE_DIR "old_tles/", tle_db);
+	for (int i=0; i < 2; i++) {
+		snprintf(filenames[i], MAX_NUM_CHARS, "%s/test%d.tle", temp_dir, i);
+		int fid = open(filenames[i], O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		close(fid);
+	}
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_entry_set_filename(tle_db, i, filenames[i % 2]);
+	}
+
+	int *update_status = (int*)calloc(tle_db->num_tles, sizeof(int));
+	tle_db_update_from_db(update_db, tle_db, update_status);
+	bool updated = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (update_status[i] & TLE_DB_UPDATED) {
+			updated = true;
+			assert_true(update_status[i] & TLE_FILE_UPDATED);
+			assert_false(update_status[i] & TLE_IN_NEW_FILE);
+		}
+	}
+	assert_true(updated);
+
+	//each file should contain the updated entries belonging to it, and keep its permissions
+	for (int i=0; i < 2; i++) {
+		struct tle_db *file_db = tle_db_create();
+		assert_int_equal(tle_db_from_file(filenames[i], file_db), 0);
+		int k = 0;
+		for (int j=i; j < tle_db->num_tles; j += 2) {
+			assert_string_equal(file_db->tles[k].line1, tle_db->tles[j].line1);
+			assert_string_equal(file_db->tles[k].line2, tle_db->tles[j].line2);
+			k++;
+		}
+		assert_int_equal(file_db->num_tles, k);
+		tle_db_destroy(&file_db);
+
+		struct stat file_stat;
+		assert_int_equal(stat(filenames[i], &file_stat), 0);
+		assert_int_equal(file_stat.st_mode & 0777, 0644);
+		unlink(filenames[i]);
+	}
+
+	//no temporary files should be left behind
+	assert_int_equal(rmdir(temp_dir), 0);
+
+	free(update_status);
+	string_array_free(&update_files);
+	tle_db_destroy(&update_db);
+	tle_db_destroy(&expected_db);
+	tle_db_destroy(&part1_db);
+	tle_db_destroy(&tle_db);
+}
+
 int main()
 {
 	struct CMUnitTest tests[] = {cmocka_unit_test(test_tle_db_add_entry),
 	cmocka_unit_test(test_tle_db_find_entry),
 	cmocka_unit_test(test_tle_db_from_file),
+	cmocka_unit_test(test_tle_db_from_file_formats),
 	cmocka_unit_test(test_tle_db_overwrite_entry),
 	cmocka_unit_test(test_tle_db_entry_is_newer_than),
+	cmocka_unit_test(test_tle_db_entry_to_orbital_elements),
 	cmocka_unit_test(test_tle_db_from_directory),
+	cmocka_unit_test(test_tle_db_from_directory_threads),
 	cmocka_unit_test(test_tle_db_filenames),
 	cmocka_unit_test(test_whitelist_from_file),
 	cmocka_unit_test(test_tle_db_to_file),
 	cmocka_unit_test(test_tle_db_merge),
+	cmocka_unit_test(test_tle_db_merge_matches_reference),
 	cmocka_unit_test(test_whitelist_from_search_paths),
 	cmocka_unit_test(test_tle_db_update),
+	cmocka_unit_test(test_tle_db_update_from_files),
 	cmocka_unit_test(test_tle_db_from_search_paths),
 	cmocka_unit_test(test_tle_db_enabled)
 	};
@@ -0,0 +1,194 @@
+#include "tle_db_watcher.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_TLE_DIR "test_data/"
+
+void test_tle_db_watcher_apply(void **param)
+{
+	//XDG_DATA_HOME with a single TLE file
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	assert_non_null(mkdtemp(temp_dir));
+	char data_home[MAX_NUM_CHARS], tle_dir[MAX_NUM_CHARS], tle_file[MAX_NUM_CHARS];
+	snprintf(data_home, MAX_NUM_CHARS, "%s/", temp_dir);
+	snprintf(tle_dir, MAX_NUM_CHARS, "%s/flyby/", temp_dir);
+	mkdir(tle_dir, 0777);
+	snprintf(tle_dir, MAX_NUM_CHARS, "%s/flyby/tles/", temp_dir);
+	mkdir(tle_dir, 0777);
+	snprintf(tle_file, MAX_NUM_CHARS, "%spart1.tle", tle_dir);
+
+	struct tle_db *old_tles = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "old_tles/part1.tle", old_tles);
+	assert_int_equal(tle_db_to_file(tle_file, old_tles), 0);
+
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_directory(tle_dir, tle_db);
+	assert_int_equal(tle_db->num_tles, old_tles->num_tles);
+	struct transponder_db *transponder_db = transponder_db_create(tle_db);
+
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	struct tle_db_watcher *watcher = tle_db_watcher_create(true);
+	assert_non_null(watcher);
+
+	bool *updated_tles = (bool*)calloc(tle_db->num_tles, sizeof(bool));
+	assert_int_equal(tle_db_watcher_apply(watcher, tle_db, transponder_db, updated_tles), 0);
+
+	//replace file with newer TLEs, only entries already in the database should be updated
+	struct tle_db *new_tles = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "newer_tles/amateur.txt", new_tles);
+	assert_int_equal(tle_db_to_file(tle_file, new_tles), 0);
+
+	int num_updated = 0;
+	for (int i=0; (i < 50) && (num_updated == 0); i++) {
+		usleep(100000);
+		num_updated = tle_db_watcher_apply(watcher, tle_db, transponder_db, updated_tles);
+	}
+	assert_true(num_updated > 0);
+	assert_int_equal(tle_db->num_tles, old_tles->num_tles);
+
+	int num_expected_updated = 0;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		int new_index = tle_db_find_entry(new_tles, tle_db->tles[i].satellite_number);
+		assert_int_equal(updated_tles[i], new_index != -1);
+		if (new_index != -1) {
+			num_expected_updated++;
+			assert_string_equal(tle_db->tles[i].line1, new_tles->tles[new_index].line1);
+			assert_string_equal(tle_db->tles[i].line2, new_tles->tles[new_index].line2);
+			assert_true(tle_db_entry_to_orbital_elements(tle_db, i) != NULL);
+		} else {
+			assert_string_equal(tle_db->tles[i].line1, old_tles->tles[i].line1);
+		}
+	}
+	assert_int_equal(num_updated, num_expected_updated);
+
+	tle_db_watcher_destroy(&watcher);
+	assert_null(watcher);
+
+	unlink(tle_file);
+	rmdir(tle_dir);
+	snprintf(tle_dir, MAX_NUM_CHARS, "%s/flyby/", temp_dir);
+	rmdir(tle_dir);
+	rmdir(temp_dir);
+
+	free(updated_tles);
+	tle_db_destroy(&old_tles);
+	tle_db_destroy(&new_tles);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+}
+
+/**
+ * Write transponder database file with a transponder for PRISM and/or a squint angle for KKS-1.
+ **/
+void write_transponder_db(const char *filename, bool with_prism, bool with_kks)
+{
+	FILE *fd = fopen(filename, "w");
+	assert_non_null(fd);
+	if (with_prism) {
+		fprintf(fd, "PRISM\n33493\nNo alat, alon\ntest_1\n1.0, 3.0\n0.0, 0.0\nNo weekly schedule\nNo orbital schedule\nend\n");
+	}
+	if (with_kks) {
+		fprintf(fd, "KKS-1\n33499\n0.0, 0.0\nend\n");
+	}
+	fprintf(fd, "end\n");
+	fclose(fd);
+}
+
+void test_tle_db_watcher_transponder_db(void **param)
+{
+	//XDG_DATA_HOME with a transponder database
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	assert_non_null(mkdtemp(temp_dir));
+	char data_home[MAX_NUM_CHARS], flyby_dir[MAX_NUM_CHARS], db_file[MAX_NUM_CHARS];
+	snprintf(data_home, MAX_NUM_CHARS, "%s/", temp_dir);
+	snprintf(flyby_dir, MAX_NUM_CHARS, "%s/flyby/", temp_dir);
+	mkdir(flyby_dir, 0777);
+	snprintf(db_file, MAX_NUM_CHARS, "%sflyby.db", flyby_dir);
+
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "old_tles/part1.tle", tle_db);
+	int prism_index = tle_db_find_entry(tle_db, 33493);
+	int kks_index = tle_db_find_entry(tle_db, 33499);
+	assert_true(prism_index != -1);
+	assert_true(kks_index != -1);
+	struct transponder_db *transponder_db = transponder_db_create(tle_db);
+
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	struct tle_db_watcher *watcher = tle_db_watcher_create(false);
+	assert_non_null(watcher);
+	bool *updated_tles = (bool*)calloc(tle_db->num_tles, sizeof(bool));
+
+	//written transponder database should be loaded
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	write_transponder_db(db_file, true, true);
+	for (int i=0; (i < 50) && !(transponder_db->loaded); i++) {
+		usleep(100000);
+		tle_db_watcher_apply(watcher, tle_db, transponder_db, updated_tles);
+	}
+	assert_true(transponder_db->loaded);
+	assert_int_equal(transponder_db->sats[prism_index].num_transponders, 1);
+	assert_int_equal(transponder_db->sats[prism_index].location, LOCATION_DATA_HOME);
+	assert_true(transponder_db->sats[kks_index].squintflag);
+
+	//entry removed from the transponder database should be removed after reloading
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	write_transponder_db(db_file, false, true);
+	for (int i=0; (i < 50) && (transponder_db->sats[prism_index].num_transponders > 0); i++) {
+		usleep(100000);
+		tle_db_watcher_apply(watcher, tle_db, transponder_db, updated_tles);
+	}
+	assert_int_equal(transponder_db->sats[prism_index].num_transponders, 0);
+	assert_int_equal(transponder_db->sats[prism_index].location, LOCATION_NONE);
+	assert_true(transponder_db->sats[kks_index].squintflag);
+	assert_int_equal(transponder_db->sats[kks_index].location, LOCATION_DATA_HOME);
+
+	tle_db_watcher_destroy(&watcher);
+	unlink(db_file);
+	rmdir(flyby_dir);
+	rmdir(temp_dir);
+
+	free(updated_tles);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_xdg_dirs()
+{
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_tle_db_watcher_apply),
+	cmocka_unit_test(test_tle_db_watcher_transponder_db)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,119 @@
+#include "update_schedule.h"
+#include <stdlib.h>
+#include <math.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define NUM_ITEMS 517
+
+/**
+ * Check that the heap property holds and that the item positions are consistent.
+ **/
+void assert_valid_schedule(const struct update_schedule *schedule)
+{
+	for (int i=0; i < schedule->num_items; i++) {
+		assert_int_equal(schedule->heap_positions[schedule->heap[i]], i);
+		if (i > 0) {
+			assert_true(schedule->update_times[schedule->heap[(i - 1)/2]] <= schedule->update_times[schedule->heap[i]]);
+		}
+	}
+}
+
+/**
+ * Check that the due items are exactly the items with an update time earlier than or equal to the given time, in
+ * increasing order.
+ **/
+void assert_due_items(const struct update_schedule *schedule, const double *update_times, double time)
+{
+	int items[NUM_ITEMS];
+	int num_due = update_schedule_due_items(schedule, time, items);
+	int expected_num_due = 0;
+	for (int i=0; i < NUM_ITEMS; i++) {
+		if (update_times[i] <= time) {
+			assert_true(expected_num_due < num_due);
+			assert_int_equal(items[expected_num_due], i);
+			expected_num_due++;
+		}
+	}
+	assert_int_equal(num_due, expected_num_due);
+}
+
+void test_update_schedule_create(void **param)
+{
+	//all items should initially be due
+	struct update_schedule *schedule = update_schedule_create(NUM_ITEMS);
+	int items[NUM_ITEMS];
+	assert_int_equal(update_schedule_due_items(schedule, -1.0E9, items), NUM_ITEMS);
+	for (int i=0; i < NUM_ITEMS; i++) {
+		assert_int_equal(items[i], i);
+	}
+	assert_valid_schedule(schedule);
+	update_schedule_destroy(&schedule);
+	assert_null(schedule);
+
+	//empty schedule
+	schedule = update_schedule_create(0);
+	assert_int_equal(update_schedule_due_items(schedule, 0, items), 0);
+	assert_true(isinf(update_schedule_next_time(schedule)));
+	update_schedule_destroy(&schedule);
+}
+
+void test_update_schedule_due_items(void **param)
+{
+	struct update_schedule *schedule = update_schedule_create(NUM_ITEMS);
+	double update_times[NUM_ITEMS];
+	srand(1);
+	for (int i=0; i < NUM_ITEMS; i++) {
+		update_times[i] = rand() % 100;
+		if (i % 50 == 0) {
+			update_times[i] = INFINITY;
+		}
+		update_schedule_set(schedule, i, update_times[i]);
+		assert_valid_schedule(schedule);
+	}
+
+	for (double time=-1; time <= 101; time += 0.5) {
+		assert_due_items(schedule, update_times, time);
+	}
+
+	//reschedule items both to earlier and later times
+	for (int i=0; i < NUM_ITEMS; i += 3) {
+		update_times[i] = (i % 2 == 0) ? update_times[i] - 50 : update_times[i] + 50;
+		update_schedule_set(schedule, i, update_times[i]);
+		assert_valid_schedule(schedule);
+	}
+	double earliest_time = INFINITY;
+	for (int i=0; i < NUM_ITEMS; i++) {
+		earliest_time = fmin(earliest_time, update_times[i]);
+	}
+	assert_true(update_schedule_next_time(schedule) == earliest_time);
+	for (double time=-51; time <= 151; time += 0.5) {
+		assert_due_items(schedule, update_times, time);
+	}
+
+	//never due again after being set to infinity, unless reset
+	for (int i=0; i < NUM_ITEMS; i++) {
+		update_times[i] = INFINITY;
+		update_schedule_set(schedule, i, update_times[i]);
+	}
+	assert_due_items(schedule, update_times, 1.0E9);
+	update_schedule_reset(schedule);
+	int items[NUM_ITEMS];
+	assert_int_equal(update_schedule_due_items(schedule, 0, items), NUM_ITEMS);
+	assert_valid_schedule(schedule);
+
+	update_schedule_destroy(&schedule);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_update_schedule_create),
+	cmocka_unit_test(test_update_schedule_due_items)
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}